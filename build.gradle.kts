@@ -1,5 +1,6 @@
 plugins {
     alias(libs.plugins.kotlin.jvm)
+    alias(libs.plugins.kotlin.multiplatform) apply false
     alias(libs.plugins.maven.publish)
     alias(libs.plugins.git.versioning)
 }
@@ -36,6 +37,9 @@ repositories {
 
 dependencies {
 
+    /* Flow is part of the public API for update progress. */
+    api(libs.kotlinx.coroutines.core)
+
     testImplementation(kotlin("test"))
 }
 
@@ -133,6 +137,31 @@ fun resolveVisualStudioInstance(): String? {
 
     return candidates.firstOrNull { file(it).exists() }
 }
+
+/**
+ * Builds the CMake configure command line for native/winrt into [buildDir].
+ *
+ * [options] are passed on as cache entries, e.g. `-DMSSTORE_WINRT_PGO=USE`.
+ */
+fun cmakeConfigureCommand(buildDir: File, options: List<String> = emptyList()): List<String> {
+
+    val vsInstance = resolveVisualStudioInstance()
+
+    val args = mutableListOf(
+        resolveCmakeExe(),
+        "-S", "native/winrt",
+        "-B", buildDir.absolutePath,
+        "-G", "Visual Studio 17 2022",
+        "-A", "x64"
+    )
+
+    if (vsInstance != null)
+        args.add("-DCMAKE_GENERATOR_INSTANCE=$vsInstance")
+
+    args.addAll(options)
+
+    return args
+}
 // endregion
 
 // region Native build tasks for msstore_winrt.dll.
@@ -146,22 +175,7 @@ tasks.register<Exec>("configureWinrt") {
     onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
 
     doFirst {
-
-        val cmakeExe = resolveCmakeExe()
-        val vsInstance = resolveVisualStudioInstance()
-
-        val baseArgs = mutableListOf(
-            cmakeExe,
-            "-S", "native/winrt",
-            "-B", winrtBuildDir.get().asFile.absolutePath,
-            "-G", "Visual Studio 17 2022",
-            "-A", "x64"
-        )
-
-        if (vsInstance != null)
-            baseArgs.add("-DCMAKE_GENERATOR_INSTANCE=$vsInstance")
-
-        commandLine(baseArgs)
+        commandLine(cmakeConfigureCommand(winrtBuildDir.get().asFile))
     }
 }
 
@@ -216,6 +230,330 @@ tasks.withType<PublishToMavenLocal>().configureEach {
 }
 // endregion
 
+// region Profile-guided native build
+
+/*
+ * Profile-guided, link-time-optimized msstore_winrt.dll.
+ *
+ * An instrumented DLL runs the training workload (msstore_workload.cpp) to
+ * record which branches of the conversion and marshalling code are taken;
+ * the optimized DLL is then linked with that profile. Not part of the
+ * regular build, since training needs the MSVC profiling runtime.
+ *
+ *   gradlew buildNativeLibPgo     trains, builds and copies the optimized DLL
+ *   gradlew benchmarkWinrtPgo     compares it with a regular Release build
+ */
+
+/* CMake output directories of the instrumented, optimized and baseline builds. */
+val winrtPgoInstrumentedBuildDir = layout.buildDirectory.dir("winrt-pgo-instrumented")
+val winrtPgoBuildDir = layout.buildDirectory.dir("winrt-pgo")
+val winrtBaselineBuildDir = layout.buildDirectory.dir("winrt-baseline")
+
+/* Workload rounds per training run; every run is a separate process. */
+val pgoTrainingIterations = providers.gradleProperty("pgoTrainingIterations").orElse("500")
+val pgoTrainingRuns = 5
+
+/* Processes per DLL for the benchmark; each one gives one cold-start sample. */
+val pgoBenchmarkRuns = 15
+val pgoBenchmarkIterations = 200
+
+/** Path of a Release build output in a Visual Studio CMake build directory. */
+fun releaseOutput(buildDir: Provider<Directory>, fileName: String): File =
+    buildDir.get().dir("Release").file(fileName).asFile
+
+/** Registers configure and build tasks for a native/winrt build with extra CMake [options]. */
+fun registerWinrtVariant(name: String, buildDir: Provider<Directory>, summary: String, options: () -> List<String>) {
+
+    tasks.register<Exec>("configureWinrt$name") {
+
+        group = "native"
+        description = "Configure the $summary build of $winrtDllFileName."
+
+        onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
+
+        doFirst {
+            commandLine(cmakeConfigureCommand(buildDir.get().asFile, options()))
+        }
+    }
+
+    tasks.register<Exec>("buildWinrt$name") {
+
+        group = "native"
+        description = "Build the $summary $winrtDllFileName."
+
+        onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
+
+        dependsOn("configureWinrt$name")
+
+        doFirst {
+            commandLine(
+                resolveCmakeExe(),
+                "--build", buildDir.get().asFile.absolutePath,
+                "--config", "Release"
+            )
+        }
+    }
+}
+
+registerWinrtVariant("PgoInstrumented", winrtPgoInstrumentedBuildDir, "instrumented (PGO)") {
+    listOf("-DMSSTORE_WINRT_PGO=GENERATE")
+}
+
+/* Keeps the workload export, so the benchmark can drive the optimized DLL too. */
+registerWinrtVariant("Pgo", winrtPgoBuildDir, "profile-optimized") {
+    listOf(
+        "-DMSSTORE_WINRT_PGO=USE",
+        "-DMSSTORE_WINRT_PGD=${releaseOutput(winrtPgoInstrumentedBuildDir, "msstore_winrt.pgd").absolutePath}",
+        "-DMSSTORE_WINRT_WORKLOAD=ON"
+    )
+}
+
+registerWinrtVariant("Baseline", winrtBaselineBuildDir, "regular Release (benchmark baseline)") {
+    listOf("-DMSSTORE_WINRT_WORKLOAD=ON")
+}
+
+tasks.register("trainWinrtPgo") {
+
+    group = "native"
+    description = "Run the training workload against the instrumented $winrtDllFileName."
+
+    onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
+
+    dependsOn("buildWinrtPgoInstrumented")
+
+    doLast {
+
+        val driver = releaseOutput(winrtPgoInstrumentedBuildDir, "msstore_winrt_workload.exe")
+        val dll = releaseOutput(winrtPgoInstrumentedBuildDir, winrtDllFileName)
+
+        /* Profiles of earlier trainings would be merged in as well. */
+        dll.parentFile.listFiles { file -> file.name.endsWith(".pgc") }?.forEach { it.delete() }
+
+        repeat(pgoTrainingRuns) {
+
+            val exitCode = ProcessBuilder(driver.absolutePath, dll.absolutePath, "train", pgoTrainingIterations.get())
+                .inheritIO()
+                .start()
+                .waitFor()
+
+            if (exitCode != 0)
+                throw GradleException("Training workload failed with exit code $exitCode.")
+        }
+    }
+}
+
+tasks.named("configureWinrtPgo") {
+    dependsOn("trainWinrtPgo")
+}
+
+tasks.register<Copy>("buildNativeLibPgo") {
+
+    group = "native"
+    description = "Build the profile-optimized $winrtDllFileName and copy it to src/main/resources/windows-x86_64."
+
+    onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
+
+    dependsOn("buildWinrtPgo")
+
+    from(winrtPgoBuildDir.map { it.dir("Release").file(winrtDllFileName) })
+    into(windowsX64ResourceDir)
+}
+
+tasks.register("benchmarkWinrtPgo") {
+
+    group = "native"
+    description = "Compare cold-start and steady-state latency of the regular and the profile-optimized DLL."
+
+    onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
+
+    dependsOn("buildWinrtBaseline", "buildWinrtPgo")
+
+    doLast {
+
+        fun median(values: List<Double>): Double =
+            values.sorted().let { sorted -> (sorted[(sorted.size - 1) / 2] + sorted[sorted.size / 2]) / 2 }
+
+        fun sample(buildDir: Provider<Directory>): Map<String, Double> {
+
+            val driver = releaseOutput(buildDir, "msstore_winrt_workload.exe")
+            val dll = releaseOutput(buildDir, winrtDllFileName)
+
+            val samples = (1..pgoBenchmarkRuns).map {
+
+                val process = ProcessBuilder(driver.absolutePath, dll.absolutePath, "bench", "$pgoBenchmarkIterations")
+                    .redirectErrorStream(true)
+                    .start()
+
+                val output = process.inputStream.bufferedReader().readText().trim()
+
+                if (process.waitFor() != 0)
+                    throw GradleException("Benchmark run failed: $output")
+
+                /* "loadMicros=812 firstMicros=403 meanMicros=97.35" */
+                output.split(' ').associate { field ->
+                    field.substringBefore('=') to field.substringAfter('=').toDouble()
+                }
+            }
+
+            return samples.first().keys.associateWith { key -> median(samples.map { it.getValue(key) }) }
+        }
+
+        val baseline = sample(winrtBaselineBuildDir)
+        val optimized = sample(winrtPgoBuildDir)
+
+        println("Median of $pgoBenchmarkRuns processes, microseconds:")
+        println(String.format("%-12s %12s %12s %8s", "", "baseline", "pgo+lto", "change"))
+
+        for (key in listOf("loadMicros", "firstMicros", "meanMicros")) {
+
+            val before = baseline.getValue(key)
+            val after = optimized.getValue(key)
+
+            println(String.format("%-12s %12.1f %12.1f %+7.1f%%", key, before, after, (after - before) / before * 100))
+        }
+    }
+}
+// endregion
+
+// region Cold-start benchmark
+
+/*
+ * Time from JVM launch to the first license result, through every way
+ * MsStoreNativeLoader can find the DLL.
+ *
+ * Every sample is a fresh JVM running MsStoreColdStartProbe (src/coldStart),
+ * which reports the phases class init, DLL loading, downcall binding and the
+ * native call. Medians are written to build/cold-start/<version>.txt; pass
+ * -PcoldStartBaseline=<file of another version> to compare against it.
+ *
+ *   gradlew benchmarkColdStart
+ */
+
+val coldStartSourceSet: SourceSet = sourceSets.create("coldStart")
+
+/* The probe triggers the loader phases one by one, so it needs internal access. */
+kotlin.target.compilations.named("coldStart") {
+    associateWith(kotlin.target.compilations.getByName("main"))
+}
+
+/* JVM launches per loader path; the first one of each only warms the file cache. */
+val coldStartRuns = providers.gradleProperty("coldStartRuns").orElse("20")
+
+tasks.register("benchmarkColdStart") {
+
+    group = "native"
+    description = "Measure JVM launch to first license result through each DLL loader path."
+
+    onlyIf { org.gradle.internal.os.OperatingSystem.current().isWindows }
+
+    dependsOn("coldStartClasses", "processResources")
+
+    val javaLauncher = javaToolchains.launcherFor {
+        languageVersion = JavaLanguageVersion.of(25)
+    }
+
+    doLast {
+
+        val java = javaLauncher.get().executablePath.asFile.absolutePath
+
+        val classpath = files(
+            coldStartSourceSet.output,
+            sourceSets.main.get().output,
+            configurations.runtimeClasspath
+        ).asPath
+
+        val dll = releaseOutput(winrtBuildDir, winrtDllFileName)
+
+        val scratchDir = temporaryDir.also { it.deleteRecursively() }
+
+        /* Empty folders, so that no loader path finds the DLL by accident. */
+        val emptyDir = File(scratchDir, "empty").also { it.mkdirs() }
+
+        val appLocalDir = File(scratchDir, "app-local").also { it.mkdirs() }
+        dll.copyTo(File(appLocalDir, winrtDllFileName))
+
+        /* Per loader path: working directory and system properties of a run. */
+        val loaderPaths: Map<String, (Int) -> Pair<File, List<String>>> = mapOf(
+            "override" to { _ ->
+                emptyDir to listOf("-Dmsstore.winrt.path=${dll.absolutePath}", "-Djava.library.path=$emptyDir")
+            },
+            "appLocal" to { _ ->
+                appLocalDir to listOf("-Djava.library.path=$emptyDir")
+            },
+            "libraryPath" to { _ ->
+                emptyDir to listOf("-Djava.library.path=${dll.parentFile.absolutePath}")
+            },
+            "embedded" to { run ->
+                /* A fresh temp directory per run, so every run extracts. */
+                val tempDir = File(scratchDir, "tmp-$run").also { it.mkdirs() }
+                emptyDir to listOf("-Djava.library.path=$emptyDir", "-Djava.io.tmpdir=${tempDir.absolutePath}")
+            }
+        )
+
+        fun median(values: List<Double>): Double =
+            values.sorted().let { sorted -> (sorted[(sorted.size - 1) / 2] + sorted[sorted.size / 2]) / 2 }
+
+        val results = linkedMapOf<String, Double>()
+
+        for ((name, configure) in loaderPaths) {
+
+            val samples = (0..coldStartRuns.get().toInt()).map { run ->
+
+                val (workingDir, properties) = configure(run)
+
+                val process = ProcessBuilder(
+                    listOf(java) + properties + listOf("-cp", classpath, "de.stefan_oltmann.msstore.MsStoreColdStartProbeKt")
+                )
+                    .directory(workingDir)
+                    .redirectErrorStream(true)
+                    .start()
+
+                val output = process.inputStream.bufferedReader().readText().trim()
+
+                if (process.waitFor() != 0)
+                    throw GradleException("Cold-start probe failed ($name): $output")
+
+                /* "launchMillis=95 classInitMicros=4210 ... result=ok", on the last line */
+                output.lines().last().split(' ').associate { field ->
+                    field.substringBefore('=') to field.substringAfter('=')
+                }
+            }.drop(1)
+
+            for (key in samples.first().keys - "result")
+                results["$name.$key"] = median(samples.map { it.getValue(key).toDouble() })
+
+            results["$name.errors"] = samples.count { it["result"] != "ok" }.toDouble()
+        }
+
+        val resultFile = layout.buildDirectory.file("cold-start/$version.txt").get().asFile
+
+        resultFile.parentFile.mkdirs()
+        resultFile.writeText(results.entries.joinToString("\n", postfix = "\n") { "${it.key}=${it.value}" })
+
+        val baseline = providers.gradleProperty("coldStartBaseline").orNull
+            ?.let { file(it).readLines() }
+            ?.filter { it.contains('=') }
+            ?.associate { it.substringBefore('=') to it.substringAfter('=').toDouble() }
+            ?: emptyMap()
+
+        println("Median of ${coldStartRuns.get()} JVM launches, version $version:")
+        println(String.format("%-28s %12s %12s %8s", "", "baseline", "this", "change"))
+
+        for ((key, value) in results) {
+
+            val before = baseline[key]
+
+            if (before == null || before == 0.0)
+                println(String.format("%-28s %12s %12.1f", key, "-", value))
+            else
+                println(String.format("%-28s %12.1f %12.1f %+7.1f%%", key, before, value, (value - before) / before * 100))
+        }
+
+        println("Written to $resultFile")
+    }
+}
+// endregion
+
 // region BuildInfo.kt
 val generatedBuildInfoFile = layout.buildDirectory.file(
     "generated/src/main/kotlin/de/stefan_oltmann/msstore/BuildInfo.kt"
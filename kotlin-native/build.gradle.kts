@@ -0,0 +1,92 @@
+import org.jetbrains.kotlin.gradle.targets.native.tasks.KotlinNativeTest
+
+plugins {
+    alias(libs.plugins.kotlin.multiplatform)
+}
+
+/*
+ * Kotlin/Native binding of msstore_winrt.dll for command-line tools that
+ * can't use the JVM library.
+ *
+ * Binds native/winrt/msstore_winrt.h through cinterop and compiles the model
+ * classes of the JVM library from the same sources, so both return the same
+ * types. Decoding reads the native structs directly.
+ */
+
+group = "de.stefan_oltmann.msstorelib"
+description = "Kotlin/Native API for Microsoft Store."
+
+/* Release output of the root project's native build: import library and DLL. */
+val winrtReleaseDir = rootProject.layout.buildDirectory.dir("winrt/Release")
+
+val isWindowsHost = org.gradle.internal.os.OperatingSystem.current().isWindows
+
+kotlin {
+
+    /* Ensure public API is explicitly marked. */
+    explicitApi()
+
+    mingwX64 {
+
+        compilations.getByName("main") {
+            cinterops {
+                create("msstore_winrt") {
+                    definitionFile = file("src/nativeInterop/cinterop/msstore_winrt.def")
+                    includeDirs(rootProject.file("native/winrt"))
+                }
+            }
+        }
+
+        binaries.all {
+            linkerOpts("-L${winrtReleaseDir.get().asFile.absolutePath}", "-lmsstore_winrt")
+        }
+    }
+
+    compilerOptions {
+
+        /* Make the code safer */
+        progressiveMode = true
+        extraWarnings = true
+        allWarningsAsErrors = true
+    }
+
+    sourceSets {
+
+        /* Plain Kotlin shared with the JVM library. */
+        commonMain {
+            kotlin.srcDir(rootProject.file("src/main/kotlin"))
+            kotlin.include(
+                "de/stefan_oltmann/msstore/model/**",
+                "de/stefan_oltmann/msstore/MsStoreAbi.kt",
+                "de/stefan_oltmann/msstore/MsStoreLicenseException.kt"
+            )
+        }
+
+        commonTest {
+            dependencies {
+                implementation(kotlin("test"))
+            }
+        }
+
+        all {
+            languageSettings.optIn("kotlinx.cinterop.ExperimentalForeignApi")
+        }
+    }
+}
+
+/*
+ * Linking needs msstore_winrt.lib and the tests load msstore_winrt.dll, so
+ * both only run on Windows after the native build. Other hosts still compile
+ * the klib.
+ */
+tasks.matching { it.name.startsWith("link") && it.name.endsWith("MingwX64") }.configureEach {
+    dependsOn(":buildWinrt")
+    onlyIf { isWindowsHost }
+}
+
+tasks.withType<KotlinNativeTest>().configureEach {
+
+    onlyIf { isWindowsHost }
+
+    environment("PATH", winrtReleaseDir.get().asFile.absolutePath + File.pathSeparator + System.getenv("PATH"))
+}
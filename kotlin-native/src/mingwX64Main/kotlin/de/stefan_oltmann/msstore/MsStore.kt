@@ -0,0 +1,138 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_free
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_free_license_changes
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_free_license_v2
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_get_abi_info
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_get_last_error
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_get_license_changes
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_get_license_v2
+import de.stefan_oltmann.msstore.cinterop.msstore_winrt_request_purchase
+import de.stefan_oltmann.msstore.model.MsStoreLicenseChanges
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo.Companion.STORE_ID_LENGTH
+import de.stefan_oltmann.msstore.model.MsStorePurchaseStatus
+import kotlinx.cinterop.get
+import kotlinx.cinterop.pointed
+import kotlinx.cinterop.toKString
+
+/**
+ * Kotlin/Native API entry-point for Microsoft Store license info and purchases.
+ *
+ * Same calls and model types as the JVM library, bound through cinterop to
+ * `msstore_winrt.dll`, which must be next to the executable or on the PATH.
+ *
+ * cinterop links the DLL's functions at load time, so unlike the JVM library
+ * there is no fallback for older DLLs: it must export the license v2
+ * functions ([MsStoreAbi.CAP_LICENSE_V2]), or the executable does not start.
+ */
+public object MsStore {
+
+    /** ABI of the loaded DLL, read once. */
+    internal val abi: MsStoreAbi by lazy {
+
+        /* Never null: the DLL returns a static struct. */
+        val info = msstore_winrt_get_abi_info()!!.pointed
+
+        /* An older DLL may end its struct before StructLayoutHashes. */
+        val structLayoutHashCount =
+            ((info.StructSize.toLong() - MsStoreAbi.ABI_INFO_NATIVE_SIZE) / 8)
+                .coerceIn(0, MsStoreAbi.STRUCT_LAYOUT_SLOTS.toLong()).toInt()
+
+        MsStoreAbi(
+            abiVersion = info.AbiVersion.toInt(),
+            layoutHash = info.LayoutHash.toLong(),
+            capabilities = info.Capabilities.toLong(),
+            structLayoutHashes = LongArray(structLayoutHashCount) { index ->
+                info.StructLayoutHashes[index].toLong()
+            }
+        )
+    }
+
+    /**
+     * Returns the current app license info.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun getLicenseInfo(): MsStoreLicenseInfo {
+
+        abi.requireStructLayout(MsStoreAbi.STRUCT_LICENSE_V2)
+        abi.requireStructLayout(MsStoreAbi.STRUCT_ADD_ON_LICENSE_V2)
+
+        val license = msstore_winrt_get_license_v2()
+            ?: throw MsStoreLicenseException(readLastError() ?: "Native license query failed.")
+
+        try {
+            return MsStoreNativeDecoder.readLicenseInfo(license.pointed)
+        } finally {
+            msstore_winrt_free_license_v2(license)
+        }
+    }
+
+    /**
+     * Queries the current license and returns the add-on changes since [generation].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun licenseChangesSince(generation: Long): MsStoreLicenseChanges {
+
+        abi.requireStructLayout(MsStoreAbi.STRUCT_LICENSE_CHANGES)
+        abi.requireStructLayout(MsStoreAbi.STRUCT_ADD_ON_LICENSE_V2)
+
+        val changes = msstore_winrt_get_license_changes(generation)
+            ?: throw MsStoreLicenseException(readLastError() ?: "Native license query failed.")
+
+        try {
+            return MsStoreNativeDecoder.readLicenseChanges(changes.pointed)
+        } finally {
+            msstore_winrt_free_license_changes(changes)
+        }
+    }
+
+    /**
+     * Requests a purchase for the given Store product ID.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun requestPurchase(storeId: String): MsStorePurchaseStatus {
+
+        /* Prevent wrong use */
+        if (storeId.length != STORE_ID_LENGTH)
+            throw MsStoreLicenseException("Store ID must be 12 characters long.")
+
+        val statusCode = msstore_winrt_request_purchase(storeId)
+
+        if (statusCode < 0)
+            throw MsStoreLicenseException(readLastError() ?: "Native purchase request failed.")
+
+        return MsStorePurchaseStatus.fromNativeCode(statusCode)
+    }
+
+    /** Reads the last native error string (if any) and frees it. */
+    private fun readLastError(): String? {
+
+        val error = msstore_winrt_get_last_error() ?: return null
+
+        try {
+            return error.toKString().ifEmpty { null }
+        } finally {
+            msstore_winrt_free(error)
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.cinterop.MsStoreAddOnLicenseV2Native
+import de.stefan_oltmann.msstore.cinterop.MsStoreLicenseChangesNative
+import de.stefan_oltmann.msstore.cinterop.MsStoreLicenseV2Native
+import de.stefan_oltmann.msstore.model.MsStoreAddOnLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreLicenseChanges
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.get
+import kotlinx.cinterop.toKString
+
+/**
+ * Converts the structs of msstore_winrt.h into the model classes.
+ *
+ * Works directly on the cinterop struct views; nothing is copied before
+ * decoding. Frees nothing, the caller owns the structs.
+ */
+internal object MsStoreNativeDecoder {
+
+    fun readLicenseInfo(license: MsStoreLicenseV2Native): MsStoreLicenseInfo {
+
+        /*
+         * SkuStoreId is a combination of Store ID and SKU ID like "9ND96XCDZRGB/0100".
+         * It's only set if installed from the MS Store.
+         */
+        val skuStoreId = license.SkuStoreId?.toKString() ?: ""
+
+        return MsStoreLicenseInfo(
+            storeId = skuStoreId.take(MsStoreLicenseInfo.STORE_ID_LENGTH),
+            skuId = skuStoreId.drop(MsStoreLicenseInfo.STORE_ID_LENGTH + 1),
+            expirationDate = license.ExpirationDate,
+            isActive = license.IsActive,
+            isTrial = license.IsTrial,
+            addOnLicenses = readAddOnLicenseInfos(license.AddOnLicenses, license.AddOnLicensesCount),
+            fingerprint = license.Fingerprint.toLong(),
+            generation = license.Generation
+        )
+    }
+
+    fun readLicenseChanges(changes: MsStoreLicenseChangesNative): MsStoreLicenseChanges {
+
+        val skuStoreId = changes.SkuStoreId?.toKString() ?: ""
+
+        return MsStoreLicenseChanges(
+            generation = changes.Generation,
+            fingerprint = changes.Fingerprint.toLong(),
+            storeId = skuStoreId.take(MsStoreLicenseInfo.STORE_ID_LENGTH),
+            skuId = skuStoreId.drop(MsStoreLicenseInfo.STORE_ID_LENGTH + 1),
+            expirationDate = changes.ExpirationDate,
+            isActive = changes.IsActive,
+            isTrial = changes.IsTrial,
+            isFullResync = changes.IsFullResync,
+            added = readAddOnLicenseInfos(changes.Added, changes.AddedCount),
+            removed = readAddOnLicenseInfos(changes.Removed, changes.RemovedCount),
+            changed = readAddOnLicenseInfos(changes.Changed, changes.ChangedCount)
+        )
+    }
+
+    private fun readAddOnLicenseInfos(
+        array: CPointer<MsStoreAddOnLicenseV2Native>?,
+        count: Int
+    ): List<MsStoreAddOnLicenseInfo> {
+
+        if (array == null || count <= 0)
+            return emptyList()
+
+        return List(count) { index -> readAddOnLicenseInfo(array[index]) }
+    }
+
+    private fun readAddOnLicenseInfo(addOn: MsStoreAddOnLicenseV2Native): MsStoreAddOnLicenseInfo {
+
+        val skuStoreId = addOn.SkuStoreId?.toKString() ?: ""
+
+        return MsStoreAddOnLicenseInfo(
+            storeId = skuStoreId.take(MsStoreLicenseInfo.STORE_ID_LENGTH),
+            skuId = skuStoreId.drop(MsStoreLicenseInfo.STORE_ID_LENGTH + 1),
+            inAppOfferToken = addOn.InAppOfferToken?.toKString() ?: "",
+            expirationDate = addOn.ExpirationDate,
+            fingerprint = addOn.Fingerprint.toLong()
+        )
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.cinterop.MsStoreAddOnLicenseV2Native
+import de.stefan_oltmann.msstore.cinterop.MsStoreLicenseV2Native
+import kotlinx.cinterop.allocArray
+import kotlinx.cinterop.alloc
+import kotlinx.cinterop.cstr
+import kotlinx.cinterop.get
+import kotlinx.cinterop.memScoped
+import kotlinx.cinterop.ptr
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class MsStoreNativeDecoderTest {
+
+    @Test
+    fun decodesLicenseStruct() = memScoped {
+
+        val addOns = allocArray<MsStoreAddOnLicenseV2Native>(2)
+
+        addOns[0].SkuStoreId = "9P0000001000/0010".cstr.ptr
+        addOns[0].InAppOfferToken = "pro".cstr.ptr
+        addOns[0].ExpirationDate = 1_700_000_000_000
+        addOns[0].Fingerprint = 42u
+
+        addOns[1].SkuStoreId = null
+        addOns[1].InAppOfferToken = null
+
+        val license = alloc<MsStoreLicenseV2Native>()
+        license.SkuStoreId = "9NBLGGH4R315/0010".cstr.ptr
+        license.IsActive = true
+        license.IsTrial = false
+        license.ExpirationDate = 0
+        license.AddOnLicenses = addOns
+        license.AddOnLicensesCount = 2
+        license.Fingerprint = ULong.MAX_VALUE
+        license.Generation = 3
+
+        val info = MsStoreNativeDecoder.readLicenseInfo(license)
+
+        assertEquals("9NBLGGH4R315", info.storeId)
+        assertEquals("0010", info.skuId)
+        assertTrue(info.isActive)
+        assertEquals(-1L, info.fingerprint)
+        assertEquals(3L, info.generation)
+        assertEquals(2, info.addOnLicenses.size)
+        assertEquals("9P0000001000", info.addOnLicenses[0].storeId)
+        assertEquals("pro", info.addOnLicenses[0].inAppOfferToken)
+        assertEquals(42L, info.addOnLicenses[0].fingerprint)
+        assertEquals("", info.addOnLicenses[1].storeId)
+    }
+
+    @Test
+    fun headerMatchesLoadedDll() {
+        assertEquals(MsStoreAbi.EXPECTED_LAYOUT_HASH, MsStore.abi.layoutHash)
+        assertContentEquals(MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES, MsStore.abi.structLayoutHashes.copyOf(
+            MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES.size
+        ))
+    }
+}
@@ -0,0 +1,170 @@
+#include "msstore_winrt.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Size and field offsets of each public struct.
+ *
+ * Keep in sync with msstore_winrt.h; the JVM side hashes the same values
+ * (MsStoreAbi.kt) to detect structs built from another header.
+ */
+static constexpr uint32_t ADD_ON_LICENSE_LAYOUT[] = {
+    sizeof(MsStoreAddOnLicenseNative),
+    offsetof(MsStoreAddOnLicenseNative, SkuStoreId),
+    offsetof(MsStoreAddOnLicenseNative, InAppOfferToken),
+    offsetof(MsStoreAddOnLicenseNative, ExpirationDate)
+};
+
+static constexpr uint32_t LICENSE_LAYOUT[] = {
+    sizeof(MsStoreLicenseNative),
+    offsetof(MsStoreLicenseNative, SkuStoreId),
+    offsetof(MsStoreLicenseNative, IsActive),
+    offsetof(MsStoreLicenseNative, IsTrial),
+    offsetof(MsStoreLicenseNative, ExpirationDate),
+    offsetof(MsStoreLicenseNative, AddOnLicenses),
+    offsetof(MsStoreLicenseNative, AddOnLicensesCount)
+};
+
+static constexpr uint32_t ADD_ON_LICENSE_V2_LAYOUT[] = {
+    sizeof(MsStoreAddOnLicenseV2Native),
+    offsetof(MsStoreAddOnLicenseV2Native, SkuStoreId),
+    offsetof(MsStoreAddOnLicenseV2Native, InAppOfferToken),
+    offsetof(MsStoreAddOnLicenseV2Native, ExpirationDate),
+    offsetof(MsStoreAddOnLicenseV2Native, Fingerprint)
+};
+
+static constexpr uint32_t LICENSE_V2_LAYOUT[] = {
+    sizeof(MsStoreLicenseV2Native),
+    offsetof(MsStoreLicenseV2Native, SkuStoreId),
+    offsetof(MsStoreLicenseV2Native, IsActive),
+    offsetof(MsStoreLicenseV2Native, IsTrial),
+    offsetof(MsStoreLicenseV2Native, ExpirationDate),
+    offsetof(MsStoreLicenseV2Native, AddOnLicenses),
+    offsetof(MsStoreLicenseV2Native, AddOnLicensesCount),
+    offsetof(MsStoreLicenseV2Native, Fingerprint),
+    offsetof(MsStoreLicenseV2Native, Generation)
+};
+
+static constexpr uint32_t LICENSE_CHANGES_LAYOUT[] = {
+    sizeof(MsStoreLicenseChangesNative),
+    offsetof(MsStoreLicenseChangesNative, Generation),
+    offsetof(MsStoreLicenseChangesNative, Fingerprint),
+    offsetof(MsStoreLicenseChangesNative, SkuStoreId),
+    offsetof(MsStoreLicenseChangesNative, ExpirationDate),
+    offsetof(MsStoreLicenseChangesNative, IsActive),
+    offsetof(MsStoreLicenseChangesNative, IsTrial),
+    offsetof(MsStoreLicenseChangesNative, IsFullResync),
+    offsetof(MsStoreLicenseChangesNative, Added),
+    offsetof(MsStoreLicenseChangesNative, AddedCount),
+    offsetof(MsStoreLicenseChangesNative, Removed),
+    offsetof(MsStoreLicenseChangesNative, RemovedCount),
+    offsetof(MsStoreLicenseChangesNative, Changed),
+    offsetof(MsStoreLicenseChangesNative, ChangedCount)
+};
+
+static constexpr uint32_t PENDING_UPDATES_LAYOUT[] = {
+    sizeof(MsStorePendingUpdatesNative),
+    offsetof(MsStorePendingUpdatesNative, Generation),
+    offsetof(MsStorePendingUpdatesNative, CheckedAt),
+    offsetof(MsStorePendingUpdatesNative, UpdateCount),
+    offsetof(MsStorePendingUpdatesNative, MandatoryUpdateCount),
+    offsetof(MsStorePendingUpdatesNative, LastCheckFailed)
+};
+
+static constexpr uint32_t UPDATE_PROGRESS_LAYOUT[] = {
+    sizeof(MsStoreUpdateProgressNative),
+    offsetof(MsStoreUpdateProgressNative, PackageBytesDownloaded),
+    offsetof(MsStoreUpdateProgressNative, PackageDownloadSizeInBytes),
+    offsetof(MsStoreUpdateProgressNative, PackageDownloadProgress),
+    offsetof(MsStoreUpdateProgressNative, TotalDownloadProgress),
+    offsetof(MsStoreUpdateProgressNative, State),
+    offsetof(MsStoreUpdateProgressNative, IsFinal),
+    offsetof(MsStoreUpdateProgressNative, PackageFamilyName)
+};
+
+static constexpr uint32_t SLOW_CALL_LAYOUT[] = {
+    sizeof(MsStoreSlowCallNative),
+    offsetof(MsStoreSlowCallNative, Sequence),
+    offsetof(MsStoreSlowCallNative, StartedAt),
+    offsetof(MsStoreSlowCallNative, TotalMicros),
+    offsetof(MsStoreSlowCallNative, QueueWaitMicros),
+    offsetof(MsStoreSlowCallNative, ApartmentMicros),
+    offsetof(MsStoreSlowCallNative, StoreMicros),
+    offsetof(MsStoreSlowCallNative, MarshalMicros),
+    offsetof(MsStoreSlowCallNative, JvmDecodeMicros),
+    offsetof(MsStoreSlowCallNative, Operation),
+    offsetof(MsStoreSlowCallNative, AddOnCount),
+    offsetof(MsStoreSlowCallNative, Failed),
+    offsetof(MsStoreSlowCallNative, Joined),
+    offsetof(MsStoreSlowCallNative, Error)
+};
+
+static constexpr uint32_t PURCHASE_ATTEMPT_LAYOUT[] = {
+    sizeof(MsStorePurchaseAttemptNative),
+    offsetof(MsStorePurchaseAttemptNative, Sequence),
+    offsetof(MsStorePurchaseAttemptNative, DialogOpenedAt),
+    offsetof(MsStorePurchaseAttemptNative, DialogClosedAt),
+    offsetof(MsStorePurchaseAttemptNative, Status),
+    offsetof(MsStorePurchaseAttemptNative, HResult),
+    offsetof(MsStorePurchaseAttemptNative, RetryCount),
+    offsetof(MsStorePurchaseAttemptNative, ShortCircuited),
+    offsetof(MsStorePurchaseAttemptNative, ForUser),
+    offsetof(MsStorePurchaseAttemptNative, StoreId)
+};
+
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+/* Continues hash over layout, each value as 4 little-endian bytes. */
+template <size_t Count>
+static constexpr uint64_t hash_layout(uint64_t hash, const uint32_t (&layout)[Count]) {
+
+    for (uint32_t value : layout) {
+        for (int index = 0; index < 4; ++index) {
+            hash ^= (value >> (index * 8)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+static constexpr MsStoreAbiInfoNative ABI_INFO = {
+    MSSTORE_WINRT_ABI_VERSION,
+    sizeof(MsStoreAbiInfoNative),
+    hash_layout(hash_layout(FNV_OFFSET_BASIS, ADD_ON_LICENSE_LAYOUT), LICENSE_LAYOUT),
+    MSSTORE_WINRT_CAP_PACKED_BLOB |
+        MSSTORE_WINRT_CAP_CACHE |
+        MSSTORE_WINRT_CAP_EVENTS |
+        MSSTORE_WINRT_CAP_UPDATE_CHECKER |
+        MSSTORE_WINRT_CAP_EXTENDED_JSON |
+        MSSTORE_WINRT_CAP_BROKER |
+        MSSTORE_WINRT_CAP_USERS |
+        MSSTORE_WINRT_CAP_PURCHASE_SHORT_CIRCUIT |
+        MSSTORE_WINRT_CAP_DIAGNOSTICS |
+        MSSTORE_WINRT_CAP_SLOW_CALLS |
+        MSSTORE_WINRT_CAP_PURCHASE_LOG |
+        MSSTORE_WINRT_CAP_REFRESHER |
+        MSSTORE_WINRT_CAP_PREPARED_PURCHASE |
+        MSSTORE_WINRT_CAP_DIRECT_LICENSE |
+        MSSTORE_WINRT_CAP_LICENSE_V2,
+    {
+        /* In MSSTORE_WINRT_STRUCT_* order. */
+        hash_layout(FNV_OFFSET_BASIS, ADD_ON_LICENSE_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, LICENSE_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, LICENSE_CHANGES_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, PENDING_UPDATES_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, UPDATE_PROGRESS_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, SLOW_CALL_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, PURCHASE_ATTEMPT_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, ADD_ON_LICENSE_V2_LAYOUT),
+        hash_layout(FNV_OFFSET_BASIS, LICENSE_V2_LAYOUT)
+    }
+};
+
+/*
+ * Returns the ABI description of this DLL.
+ */
+extern "C" MSSTORE_WINRT_API const MsStoreAbiInfoNative* msstore_winrt_get_abi_info() {
+    return &ABI_INFO;
+}
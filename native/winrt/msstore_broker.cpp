@@ -0,0 +1,579 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Cross-process license broker.
+ *
+ * One process per session (the owner) publishes every license snapshot it
+ * queries into a named shared memory segment. Other processes (clients) map
+ * the same segment and decode the latest snapshot from it without a Store
+ * call or any IPC round trip.
+ *
+ * The segment lives in the session-local namespace ("Local\"), so it is
+ * shared between the processes of one user session on a terminal server,
+ * but not across sessions.
+ *
+ * Consistency uses a seqlock: the owner makes the sequence odd, writes the
+ * payload and makes it even again. Readers retry if the sequence was odd or
+ * changed while they copied the payload.
+ */
+
+static constexpr uint32_t BROKER_MAGIC = 0x4253534D; /* "MSSB" */
+static constexpr uint32_t BROKER_LAYOUT_VERSION = 1;
+static constexpr size_t BROKER_SEGMENT_SIZE = 256 * 1024;
+static constexpr int BROKER_READ_ATTEMPTS = 64;
+
+struct BrokerHeader {
+    uint32_t magic;
+    uint32_t layoutVersion;
+    volatile LONG64 sequence;
+    int64_t publishedAt;
+    uint32_t ownerProcessId;
+    uint32_t payloadSize;
+};
+
+static constexpr size_t BROKER_PAYLOAD_CAPACITY = BROKER_SEGMENT_SIZE - sizeof(BrokerHeader);
+
+/*
+ * Ownership of the broker, held by a dedicated thread.
+ *
+ * A Win32 mutex belongs to the thread that acquired it: released from any
+ * other thread, ReleaseMutex fails, and when the acquiring thread exits,
+ * Windows abandons the mutex while this process still publishes. So the
+ * owner mutex is acquired and released by one thread that lives exactly as
+ * long as the ownership, no matter which threads open and close the broker.
+ * Only a dying process abandons it, and then another process may take over.
+ */
+struct BrokerOwnership {
+
+    HANDLE mutex = nullptr;
+    HANDLE acquired = nullptr;
+    HANDLE release = nullptr;
+    HANDLE thread = nullptr;
+
+    BrokerOwnership() = default;
+    BrokerOwnership(const BrokerOwnership&) = delete;
+    BrokerOwnership& operator=(const BrokerOwnership&) = delete;
+
+    /* Releases the owner mutex and waits for the owner thread to end. */
+    ~BrokerOwnership() {
+
+        if (thread != nullptr) {
+            ::SetEvent(release);
+            ::WaitForSingleObject(thread, INFINITE);
+            ::CloseHandle(thread);
+        }
+
+        if (release != nullptr)
+            ::CloseHandle(release);
+
+        if (acquired != nullptr)
+            ::CloseHandle(acquired);
+
+        if (mutex != nullptr)
+            ::CloseHandle(mutex);
+    }
+};
+
+/*
+ * Broker state of this process. Guarded by g_brokerMutex.
+ *
+ * g_brokerOwnership is set while this process owns the broker. It is a raw
+ * pointer on purpose: a static destructor would wait for the owner thread
+ * under the loader lock when the DLL is unloaded.
+ */
+static std::mutex g_brokerMutex;
+static HANDLE g_brokerMapping = nullptr;
+static BrokerOwnership* g_brokerOwnership = nullptr;
+static BrokerHeader* g_brokerHeader = nullptr;
+static bool g_brokerIsOwner = false;
+
+// region Payload encoding
+
+static void write_bytes(std::vector<char>& out, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template <typename T>
+static void write_value(std::vector<char>& out, T value) {
+    write_bytes(out, &value, sizeof(value));
+}
+
+static void write_string(std::vector<char>& out, const std::string& value) {
+    write_value<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    write_bytes(out, value.data(), value.size());
+}
+
+static std::vector<char> encode_snapshot(const LicenseSnapshot& snapshot) {
+
+    std::vector<char> out;
+
+    write_value<uint64_t>(out, snapshot.fingerprint);
+    write_value<int64_t>(out, snapshot.generation);
+    write_value<int64_t>(out, snapshot.capturedAt);
+    write_value<int64_t>(out, snapshot.expirationDate);
+    write_value<uint8_t>(out, snapshot.isActive ? 1 : 0);
+    write_value<uint8_t>(out, snapshot.isTrial ? 1 : 0);
+    write_string(out, snapshot.skuStoreId);
+    write_value<uint32_t>(out, static_cast<uint32_t>(snapshot.addOns.size()));
+
+    for (auto const& addOn : snapshot.addOns) {
+        write_value<int64_t>(out, addOn.expirationDate);
+        write_value<uint64_t>(out, addOn.fingerprint);
+        write_string(out, addOn.skuStoreId);
+        write_string(out, addOn.inAppOfferToken);
+    }
+
+    return out;
+}
+
+/* Bounds-checked reader over a copied payload. */
+struct PayloadReader {
+
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+    bool failed = false;
+
+    template <typename T>
+    T read_value() {
+
+        T value {};
+
+        if (failed || size - pos < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+
+        return value;
+    }
+
+    std::string read_string() {
+
+        const uint32_t length = read_value<uint32_t>();
+
+        if (failed || size - pos < length) {
+            failed = true;
+            return std::string();
+        }
+
+        std::string value(data + pos, length);
+        pos += length;
+
+        return value;
+    }
+};
+
+static bool decode_snapshot(const std::vector<char>& payload, LicenseSnapshot& snapshot) {
+
+    PayloadReader reader { payload.data(), payload.size() };
+
+    snapshot.fingerprint = reader.read_value<uint64_t>();
+    snapshot.generation = reader.read_value<int64_t>();
+    snapshot.capturedAt = reader.read_value<int64_t>();
+    snapshot.expirationDate = reader.read_value<int64_t>();
+    snapshot.isActive = reader.read_value<uint8_t>() != 0;
+    snapshot.isTrial = reader.read_value<uint8_t>() != 0;
+    snapshot.skuStoreId = reader.read_string();
+
+    const uint32_t addOnCount = reader.read_value<uint32_t>();
+
+    for (uint32_t index = 0; index < addOnCount && !reader.failed; ++index) {
+
+        AddOnSnapshot addOn;
+        addOn.expirationDate = reader.read_value<int64_t>();
+        addOn.fingerprint = reader.read_value<uint64_t>();
+        addOn.skuStoreId = reader.read_string();
+        addOn.inAppOfferToken = reader.read_string();
+
+        snapshot.addOns.push_back(std::move(addOn));
+    }
+
+    return !reader.failed;
+}
+
+// endregion
+
+/* Accepts names that are safe as part of a kernel object name. */
+static bool is_valid_broker_name(const char* name) {
+
+    if (name == nullptr || *name == '\0' || std::strlen(name) > 64)
+        return false;
+
+    for (const char* c = name; *c != '\0'; ++c) {
+
+        const bool valid = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+                           (*c >= '0' && *c <= '9') || *c == '.' || *c == '_' || *c == '-';
+
+        if (!valid)
+            return false;
+    }
+
+    return true;
+}
+
+/* Releases all broker handles. Expects g_brokerMutex to be held. */
+static void close_broker_locked() {
+
+    if (g_brokerHeader != nullptr) {
+        ::UnmapViewOfFile(g_brokerHeader);
+        g_brokerHeader = nullptr;
+    }
+
+    if (g_brokerMapping != nullptr) {
+        ::CloseHandle(g_brokerMapping);
+        g_brokerMapping = nullptr;
+    }
+
+    delete g_brokerOwnership;
+    g_brokerOwnership = nullptr;
+
+    g_brokerIsOwner = false;
+}
+
+/* Acquires the owner mutex, holds it until ownership->release is set, then releases it. */
+static DWORD WINAPI broker_owner_thread(void* parameter) {
+
+    BrokerOwnership* ownership = static_cast<BrokerOwnership*>(parameter);
+
+    /* WAIT_ABANDONED means the previous owner died: take over. */
+    const DWORD waitResult = ::WaitForSingleObject(ownership->mutex, 0);
+
+    if (waitResult != WAIT_OBJECT_0 && waitResult != WAIT_ABANDONED)
+        return 1;
+
+    ::SetEvent(ownership->acquired);
+
+    ::WaitForSingleObject(ownership->release, INFINITE);
+
+    ::ReleaseMutex(ownership->mutex);
+
+    return 0;
+}
+
+/*
+ * Starts the owner thread and waits until it acquired the owner mutex.
+ *
+ * Returns nullptr with the last error set if another process owns the broker.
+ */
+static BrokerOwnership* acquire_broker_ownership(const std::wstring& ownerMutexName) {
+
+    auto ownership = std::make_unique<BrokerOwnership>();
+
+    ownership->mutex = ::CreateMutexW(nullptr, FALSE, ownerMutexName.c_str());
+    ownership->acquired = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    ownership->release = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    if (ownership->mutex == nullptr || ownership->acquired == nullptr || ownership->release == nullptr) {
+        g_lastError = "Could not create the broker owner mutex.";
+        return nullptr;
+    }
+
+    ownership->thread = ::CreateThread(nullptr, 0, broker_owner_thread, ownership.get(), 0, nullptr);
+
+    if (ownership->thread == nullptr) {
+        g_lastError = "Could not start the broker owner thread.";
+        return nullptr;
+    }
+
+    /* The thread either signals the mutex as acquired or ends without it. */
+    const HANDLE handles[] = { ownership->acquired, ownership->thread };
+
+    if (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) {
+        g_lastError = "Another process already owns this license broker.";
+        return nullptr;
+    }
+
+    return ownership.release();
+}
+
+/*
+ * Reads the seqlock sequence with acquire semantics.
+ *
+ * Clients map the segment read-only, so no interlocked operation may touch
+ * it there: even a failing compare-exchange writes and faults.
+ */
+static LONG64 read_broker_sequence(const BrokerHeader* header) {
+    return ::ReadAcquire64(&header->sequence);
+}
+
+/* Writes payload into the segment under the seqlock. Expects g_brokerMutex and a writable view. */
+static void write_payload_locked(const std::vector<char>& payload) {
+
+    char* payloadArea = reinterpret_cast<char*>(g_brokerHeader + 1);
+
+    /* Odd sequence: write in progress. Interlocked operations are full barriers. */
+    ::InterlockedIncrement64(&g_brokerHeader->sequence);
+
+    if (!payload.empty())
+        std::memcpy(payloadArea, payload.data(), payload.size());
+
+    g_brokerHeader->payloadSize = static_cast<uint32_t>(payload.size());
+    g_brokerHeader->publishedAt = current_unix_epoch_millis();
+    g_brokerHeader->ownerProcessId = ::GetCurrentProcessId();
+
+    ::InterlockedIncrement64(&g_brokerHeader->sequence);
+}
+
+/* Writes snapshot into the segment. Expects g_brokerMutex to be held. */
+static void broker_publish_locked(const LicenseSnapshot& snapshot) {
+
+    if (!g_brokerIsOwner || g_brokerHeader == nullptr)
+        return;
+
+    const std::vector<char> payload = encode_snapshot(snapshot);
+
+    /* Keep the last snapshot that fit; clients see it as getting stale. */
+    if (payload.size() > BROKER_PAYLOAD_CAPACITY)
+        return;
+
+    write_payload_locked(payload);
+}
+
+/*
+ * Makes the segment consistent for a new owner.
+ *
+ * A previous owner that died mid-publish left an odd sequence and a torn
+ * payload. The sequence is rounded up to even, so the parity of later
+ * publishes is right again, and the payload is replaced: with this
+ * process's snapshot, or with an empty one that clients read as "no
+ * snapshot yet".
+ */
+static void take_over_segment_locked() {
+
+    if ((read_broker_sequence(g_brokerHeader) & 1) != 0)
+        ::InterlockedIncrement64(&g_brokerHeader->sequence);
+
+    std::vector<char> payload;
+
+    if (auto snapshot = current_snapshot())
+        payload = encode_snapshot(*snapshot);
+
+    if (payload.size() > BROKER_PAYLOAD_CAPACITY)
+        payload.clear();
+
+    write_payload_locked(payload);
+}
+
+void broker_publish(const LicenseSnapshot& snapshot) {
+
+    std::lock_guard<std::mutex> lock(g_brokerMutex);
+
+    broker_publish_locked(snapshot);
+}
+
+/*
+ * Opens the broker segment as owner or client.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_broker_open(const char* name, bool owner) {
+
+    if (!is_valid_broker_name(name)) {
+        g_lastError = "Broker name must be 1-64 characters of A-Z, a-z, 0-9, '.', '_' or '-'.";
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(g_brokerMutex);
+
+    close_broker_locked();
+
+    const std::string baseName = std::string("Local\\msstorelib-broker-") + name;
+    const std::wstring mappingName = winrt::to_hstring(baseName).c_str();
+    const std::wstring ownerMutexName = winrt::to_hstring(baseName + "-owner").c_str();
+
+    if (owner) {
+
+        g_brokerOwnership = acquire_broker_ownership(ownerMutexName);
+
+        if (g_brokerOwnership == nullptr)
+            return -1;
+    }
+
+    /* Clients create the segment too, so they may start before the owner. */
+    g_brokerMapping = ::CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        nullptr,
+        PAGE_READWRITE,
+        0,
+        static_cast<DWORD>(BROKER_SEGMENT_SIZE),
+        mappingName.c_str()
+    );
+
+    if (g_brokerMapping == nullptr) {
+        close_broker_locked();
+        g_lastError = "Could not create the broker shared memory segment.";
+        return -1;
+    }
+
+    g_brokerHeader = static_cast<BrokerHeader*>(::MapViewOfFile(
+        g_brokerMapping,
+        owner ? FILE_MAP_WRITE : FILE_MAP_READ,
+        0,
+        0,
+        BROKER_SEGMENT_SIZE
+    ));
+
+    if (g_brokerHeader == nullptr) {
+        close_broker_locked();
+        g_lastError = "Could not map the broker shared memory segment.";
+        return -1;
+    }
+
+    if (owner) {
+
+        /* A fresh segment is zero-filled; stamp it once. */
+        if (g_brokerHeader->magic != BROKER_MAGIC) {
+            g_brokerHeader->layoutVersion = BROKER_LAYOUT_VERSION;
+            g_brokerHeader->magic = BROKER_MAGIC;
+        }
+
+        /* Also shares what this process already knows right away. */
+        take_over_segment_locked();
+
+        g_brokerIsOwner = true;
+    }
+
+    g_lastError.clear();
+
+    return 0;
+}
+
+/*
+ * Closes the broker segment. An owner gives up ownership.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_broker_close() {
+
+    std::lock_guard<std::mutex> lock(g_brokerMutex);
+
+    close_broker_locked();
+}
+
+/*
+ * Reads the latest snapshot published by the broker owner.
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_broker_read_license(int64_t maxAgeMillis) {
+
+    CallSpan span(CALL_BROKER_READ_LICENSE, g_lastError);
+
+    try {
+
+        std::vector<char> payload;
+        int64_t publishedAt = 0;
+        bool consistent = false;
+
+        {
+            std::lock_guard<std::mutex> lock(g_brokerMutex);
+
+            if (g_brokerHeader == nullptr) {
+                g_lastError = "License broker is not open.";
+                return nullptr;
+            }
+
+            if (g_brokerHeader->magic != BROKER_MAGIC || g_brokerHeader->layoutVersion != BROKER_LAYOUT_VERSION) {
+                g_lastError = "License broker has no snapshot yet.";
+                return nullptr;
+            }
+
+            const char* payloadArea = reinterpret_cast<const char*>(g_brokerHeader + 1);
+
+            for (int attempt = 0; attempt < BROKER_READ_ATTEMPTS && !consistent; ++attempt) {
+
+                const LONG64 before = read_broker_sequence(g_brokerHeader);
+
+                if ((before & 1) != 0) {
+                    ::YieldProcessor();
+                    continue;
+                }
+
+                const uint32_t payloadSize = g_brokerHeader->payloadSize;
+                publishedAt = g_brokerHeader->publishedAt;
+
+                if (payloadSize > BROKER_PAYLOAD_CAPACITY)
+                    continue;
+
+                payload.assign(payloadArea, payloadArea + payloadSize);
+
+                ::MemoryBarrier();
+
+                const LONG64 after = read_broker_sequence(g_brokerHeader);
+
+                consistent = before == after && before != 0;
+            }
+        }
+
+        if (!consistent) {
+            g_lastError = "License broker has no consistent snapshot.";
+            return nullptr;
+        }
+
+        /* A new owner without a snapshot clears the payload of its predecessor. */
+        if (payload.empty()) {
+            g_lastError = "License broker has no snapshot yet.";
+            return nullptr;
+        }
+
+        if (maxAgeMillis >= 0 && current_unix_epoch_millis() - publishedAt > maxAgeMillis) {
+            g_lastError = "License broker snapshot is older than the allowed age.";
+            return nullptr;
+        }
+
+        LicenseSnapshot snapshot;
+
+        if (!decode_snapshot(payload, snapshot)) {
+            g_lastError = "License broker snapshot is malformed.";
+            return nullptr;
+        }
+
+        span.set_add_on_count(snapshot.addOns.size());
+
+        const SpanClock::time_point marshalStart = span.now();
+
+        MsStoreLicenseV2Native* licensePointer = marshal_license(snapshot);
+
+        span.end_marshal(marshalStart);
+
+        if (licensePointer == nullptr)
+            return nullptr;
+
+        g_lastError.clear();
+
+        return licensePointer;
+
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return nullptr;
+}
+
+void dump_broker_state(DiagnosticsWriter& writer) {
+
+    std::lock_guard<std::mutex> lock(g_brokerMutex);
+
+    writer.begin_object("broker");
+    writer.add_bool("open", g_brokerHeader != nullptr);
+    writer.add_bool("owner", g_brokerIsOwner);
+
+    if (g_brokerHeader != nullptr) {
+        writer.add_number("sequence", read_broker_sequence(g_brokerHeader));
+        writer.add_number("publishedAt", g_brokerHeader->publishedAt);
+        writer.add_number("ownerProcessId", g_brokerHeader->ownerProcessId);
+        writer.add_number("payloadSize", g_brokerHeader->payloadSize);
+    }
+
+    writer.end_object();
+}
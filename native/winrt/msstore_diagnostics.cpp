@@ -0,0 +1,114 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+#include "msstore_snapshot.h"
+
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <winrt/base.h>
+#include <winrt/Windows.ApplicationModel.h>
+
+using namespace winrt;
+using namespace Windows::ApplicationModel;
+
+/*
+ * Identifies which DLL and which package identity answer Store calls.
+ *
+ * Without package identity StoreContext calls fail or return empty results,
+ * which is the most common cause of "no license" reports.
+ */
+static void dump_backend_state(DiagnosticsWriter& writer) {
+
+    const MsStoreAbiInfoNative* abi = msstore_winrt_get_abi_info();
+
+    writer.begin_object("backend");
+    writer.add_string("name", "StoreContext");
+    writer.add_number("abiVersion", abi->AbiVersion);
+    writer.add_number("capabilities", static_cast<int64_t>(abi->Capabilities));
+    writer.add_number("processId", ::GetCurrentProcessId());
+
+    try {
+        writer.add_string("packageFamilyName", to_string(Package::Current().Id().FamilyName()));
+        writer.add_bool("packaged", true);
+    } catch (...) {
+        /* Package::Current() throws without package identity. */
+        writer.add_bool("packaged", false);
+    }
+
+    writer.end_object();
+}
+
+static void dump_license_state(DiagnosticsWriter& writer) {
+
+    auto snapshot = current_snapshot();
+
+    writer.begin_object("license");
+    writer.add_bool("cached", snapshot != nullptr);
+
+    if (snapshot != nullptr) {
+        writer.add_number("generation", snapshot->generation);
+        writer.add_number("capturedAt", snapshot->capturedAt);
+        writer.add_number("ageMillis", current_unix_epoch_millis() - snapshot->capturedAt);
+        writer.add_number("addOnCount", static_cast<int64_t>(snapshot->addOns.size()));
+        writer.add_bool("isActive", snapshot->isActive);
+        writer.add_bool("isTrial", snapshot->isTrial);
+    }
+
+    writer.end_object();
+}
+
+/*
+ * Writes a JSON document describing the internal state of the DLL.
+ *
+ * Returns the document length; writes it only if it fits into buffer.
+ */
+extern "C" MSSTORE_WINRT_API int64_t msstore_winrt_dump_state(char* buffer, int64_t size) {
+
+    try {
+
+        if (size < 0 || (buffer == nullptr && size != 0)) {
+            g_lastError = "Invalid diagnostics buffer.";
+            return -1;
+        }
+
+        DiagnosticsWriter writer;
+
+        writer.add_number("dumpedAt", current_unix_epoch_millis());
+
+        dump_backend_state(writer);
+        dump_license_state(writer);
+        dump_engine_state(writer);
+        dump_refresher_state(writer);
+        dump_dispatcher_state(writer);
+        dump_allocation_state(writer);
+        dump_update_state(writer);
+        dump_broker_state(writer);
+        dump_user_state(writer);
+        dump_extended_json_state(writer);
+        dump_purchase_log_state(writer);
+        dump_slow_call_state(writer);
+
+        /* Only the calling thread's error; the engine section has the last refresh error. */
+        writer.add_string("callerLastError", g_lastError);
+
+        const std::string json = writer.finish();
+
+        const int64_t length = static_cast<int64_t>(json.size());
+
+        if (size > length)
+            std::memcpy(buffer, json.c_str(), json.size() + 1);
+
+        return length;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return -1;
+}
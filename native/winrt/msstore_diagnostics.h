@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/*
+ * Builder for the JSON document returned by msstore_winrt_dump_state().
+ *
+ * Every module reports its own section through a dump_*_state() function
+ * defined next to the state it describes (see msstore_winrt_internal.h), so
+ * no module needs to expose its globals for diagnostics.
+ *
+ * This file has no WinRT dependency.
+ */
+class DiagnosticsWriter {
+
+public:
+
+    DiagnosticsWriter() : m_json("{"), m_needsComma(false) {}
+
+    /* Opens a nested object; close it with end_object(). */
+    void begin_object(const char* key) {
+        write_key(key);
+        m_json += '{';
+        m_needsComma = false;
+    }
+
+    void end_object() {
+        m_json += '}';
+        m_needsComma = true;
+    }
+
+    void add_number(const char* key, int64_t value) {
+        write_key(key);
+        m_json += std::to_string(value);
+    }
+
+    void add_bool(const char* key, bool value) {
+        write_key(key);
+        m_json += value ? "true" : "false";
+    }
+
+    void add_string(const char* key, const std::string& value) {
+
+        write_key(key);
+
+        m_json += '"';
+
+        for (const char c : value) {
+
+            switch (c) {
+                case '"': m_json += "\\\""; break;
+                case '\\': m_json += "\\\\"; break;
+                case '\n': m_json += "\\n"; break;
+                case '\r': m_json += "\\r"; break;
+                case '\t': m_json += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        static constexpr char HEX[] = "0123456789abcdef";
+                        m_json += "\\u00";
+                        m_json += HEX[(c >> 4) & 0xF];
+                        m_json += HEX[c & 0xF];
+                    } else {
+                        m_json += c;
+                    }
+            }
+        }
+
+        m_json += '"';
+    }
+
+    /* Closes the document and returns it. The writer must not be used afterwards. */
+    std::string finish() {
+        m_json += '}';
+        return std::move(m_json);
+    }
+
+private:
+
+    void write_key(const char* key) {
+
+        if (m_needsComma)
+            m_json += ',';
+
+        m_json += '"';
+        m_json += key;
+        m_json += "\":";
+
+        m_needsComma = true;
+    }
+
+    std::string m_json;
+    bool m_needsComma;
+};
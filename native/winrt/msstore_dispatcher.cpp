@@ -0,0 +1,125 @@
+#include "msstore_dispatcher.h"
+#include "msstore_diagnostics.h"
+#include "msstore_winrt_internal.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <winrt/base.h>
+
+using namespace winrt;
+
+namespace {
+
+    struct ScheduledTask {
+        std::chrono::steady_clock::time_point due;
+        uint64_t sequence;
+        std::function<void()> task;
+    };
+
+    /* Orders the queue by due time, then by insertion order for equal times. */
+    struct RunsLater {
+        bool operator()(const ScheduledTask& left, const ScheduledTask& right) const {
+            if (left.due != right.due)
+                return left.due > right.due;
+            return left.sequence > right.sequence;
+        }
+    };
+}
+
+static std::mutex g_dispatcherMutex;
+static std::condition_variable g_dispatcherCondition;
+static std::priority_queue<ScheduledTask, std::vector<ScheduledTask>, RunsLater> g_dispatcherQueue;
+static uint64_t g_dispatcherSequence = 0;
+static bool g_dispatcherStarted = false;
+
+/*
+ * Runs queued tasks until the process exits.
+ *
+ * The thread is detached and never joined: joining from a static destructor
+ * during DLL unload would deadlock on the loader lock.
+ */
+static void dispatcher_loop() {
+
+    /* Store async operations complete on the thread pool, MTA avoids marshalling. */
+    init_apartment(apartment_type::multi_threaded);
+
+    std::unique_lock<std::mutex> lock(g_dispatcherMutex);
+
+    for (;;) {
+
+        if (g_dispatcherQueue.empty()) {
+            g_dispatcherCondition.wait(lock);
+            continue;
+        }
+
+        const auto due = g_dispatcherQueue.top().due;
+
+        if (std::chrono::steady_clock::now() < due) {
+            g_dispatcherCondition.wait_until(lock, due);
+            continue;
+        }
+
+        std::function<void()> task = g_dispatcherQueue.top().task;
+        g_dispatcherQueue.pop();
+
+        lock.unlock();
+
+        try {
+            task();
+        } catch (...) {
+            /* Tasks report their own errors; keep the dispatcher alive. */
+        }
+
+        lock.lock();
+    }
+}
+
+void dispatcher_post(std::function<void()> task) {
+    dispatcher_post_delayed(std::chrono::milliseconds(0), std::move(task));
+}
+
+void dispatcher_post_delayed(std::chrono::milliseconds delay, std::function<void()> task) {
+
+    {
+        std::lock_guard<std::mutex> lock(g_dispatcherMutex);
+
+        g_dispatcherQueue.push(ScheduledTask {
+            std::chrono::steady_clock::now() + delay,
+            g_dispatcherSequence++,
+            std::move(task)
+        });
+
+        if (!g_dispatcherStarted) {
+            std::thread(dispatcher_loop).detach();
+            g_dispatcherStarted = true;
+        }
+    }
+
+    g_dispatcherCondition.notify_one();
+}
+
+void dump_dispatcher_state(DiagnosticsWriter& writer) {
+
+    std::lock_guard<std::mutex> lock(g_dispatcherMutex);
+
+    writer.begin_object("dispatcher");
+    writer.add_bool("started", g_dispatcherStarted);
+    writer.add_number("queued", static_cast<int64_t>(g_dispatcherQueue.size()));
+    writer.add_number("posted", static_cast<int64_t>(g_dispatcherSequence));
+
+    if (!g_dispatcherQueue.empty()) {
+
+        const auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(
+            g_dispatcherQueue.top().due - std::chrono::steady_clock::now());
+
+        /* Negative if the next task is overdue, i.e. the dispatcher is behind. */
+        writer.add_number("nextDueInMillis", untilDue.count());
+    }
+
+    writer.end_object();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+/*
+ * Background dispatcher for Store work that must not run on the caller's thread.
+ *
+ * A single thread joins the multi-threaded apartment once and executes
+ * queued tasks in due-time order. The thread is started lazily on the first
+ * post, so loading the DLL alone never spawns it.
+ *
+ * Tasks must not throw; exceptions escaping a task are swallowed to keep the
+ * dispatcher alive.
+ */
+
+/* Queues a task to run as soon as possible. */
+void dispatcher_post(std::function<void()> task);
+
+/* Queues a task to run after the given delay. */
+void dispatcher_post_delayed(std::chrono::milliseconds delay, std::function<void()> task);
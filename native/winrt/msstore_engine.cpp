@@ -0,0 +1,119 @@
+#include "msstore_engine.h"
+#include "msstore_diagnostics.h"
+#include "msstore_dispatcher.h"
+#include "msstore_winrt_internal.h"
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <winrt/base.h>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Services.Store.h>
+
+using namespace winrt;
+using namespace Windows::Services::Store;
+
+/*
+ * Engine backend talking to the Store through StoreContext::GetDefault().
+ *
+ * Coroutines start on the dispatcher thread (MTA) and continue on the WinRT
+ * thread pool after each co_await.
+ */
+struct StoreBackend {
+
+    Task<LicenseSnapshot> query_license() {
+
+        /* StoreContext::GetDefault uses the identity of the current package. */
+        StoreContext context = StoreContext::GetDefault();
+
+        StoreAppLicense license = co_await context.GetAppLicenseAsync();
+
+        co_return license_snapshot_from(license, true);
+    }
+
+    std::shared_ptr<const LicenseSnapshot> publish(LicenseSnapshot snapshot) {
+        return publish_license_snapshot(std::move(snapshot));
+    }
+
+    void post(std::function<void()> work) {
+        dispatcher_post(std::move(work));
+    }
+
+    std::string describe(std::exception_ptr error) {
+
+        try {
+            std::rethrow_exception(error);
+        } catch (const hresult_error& ex) {
+            return to_string(ex.message());
+        } catch (const std::exception& ex) {
+            return ex.what();
+        } catch (...) {
+            return "Unknown native error.";
+        }
+    }
+};
+
+static StoreBackend g_storeBackend;
+static LicenseEngine<StoreBackend> g_licenseEngine(g_storeBackend);
+
+std::shared_ptr<const LicenseSnapshot> refresh_license_snapshot(RefreshTiming* timing) {
+
+    bool joined = false;
+
+    std::shared_ptr<SnapshotResult> result = g_licenseEngine.refresh(&joined);
+
+    std::shared_ptr<const LicenseSnapshot> snapshot;
+    std::string error;
+
+    const bool succeeded = result->wait(snapshot, error);
+
+    if (timing != nullptr) {
+        *timing = result->timing;
+        timing->joined = joined;
+    }
+
+    if (!succeeded)
+        throw std::runtime_error(error);
+
+    return snapshot;
+}
+
+void refresh_license_snapshot_async() {
+    g_licenseEngine.refresh();
+}
+
+void refresh_license_snapshot_then(std::function<void(std::shared_ptr<const LicenseSnapshot>)> done) {
+
+    std::shared_ptr<SnapshotResult> result = g_licenseEngine.refresh();
+
+    result->on_done([result, done = std::move(done)]() {
+
+        std::shared_ptr<const LicenseSnapshot> snapshot;
+        std::string error;
+
+        /* Already done, so this does not block. */
+        if (!result->wait(snapshot, error))
+            snapshot = nullptr;
+
+        done(std::move(snapshot));
+    });
+}
+
+void dump_engine_state(DiagnosticsWriter& writer) {
+
+    EngineStats stats = g_licenseEngine.stats();
+
+    DetachedTaskFailures detached = detached_task_failures();
+
+    writer.begin_object("engine");
+    writer.add_number("refreshes", static_cast<int64_t>(stats.refreshes));
+    writer.add_number("failures", static_cast<int64_t>(stats.failures));
+    writer.add_bool("refreshInFlight", stats.inFlight);
+    writer.add_string("lastError", stats.lastError);
+    writer.add_number("detachedFailures", static_cast<int64_t>(detached.count));
+    writer.add_string("detachedLastError", detached.lastError);
+    writer.end_object();
+}
@@ -0,0 +1,458 @@
+#pragma once
+
+#include "msstore_snapshot.h"
+#include "msstore_spans.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Coroutine engine for Store operations.
+ *
+ * Store calls are written as coroutines that co_await the WinRT async
+ * operations instead of blocking on .get(). They start on the dispatcher
+ * thread and continue on whatever thread completes the operation, so any
+ * number of calls can be in flight without holding one OS thread each.
+ * Exported C functions that must stay synchronous wait on an AsyncResult.
+ *
+ * This header has no WinRT dependency. Store access goes through a Backend
+ * (see LicenseEngine), so the engine also runs against a fake backend.
+ */
+
+/*
+ * Lazily started coroutine producing a T.
+ *
+ * Starts when awaited and resumes the awaiting coroutine when done.
+ * Exceptions propagate to the awaiter.
+ */
+template <typename T>
+class Task {
+
+public:
+
+    struct promise_type {
+
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() noexcept {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        template <typename U>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&&) = delete;
+
+    ~Task() {
+
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+
+        m_handle.promise().continuation = awaiting;
+
+        return m_handle;
+    }
+
+    T await_resume() {
+
+        promise_type& promise = m_handle.promise();
+
+        if (promise.exception)
+            std::rethrow_exception(promise.exception);
+
+        return std::move(*promise.value);
+    }
+
+private:
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/* Exceptions that escaped a DetachedTask, for diagnostics. */
+struct DetachedTaskFailures {
+    uint64_t count = 0;
+    std::string lastError;
+};
+
+inline std::mutex g_detachedTaskMutex;
+inline DetachedTaskFailures g_detachedTaskFailures;
+
+/*
+ * Records the exception that ended a detached task.
+ *
+ * Never throws: it runs in a noexcept unhandled_exception().
+ */
+inline void record_detached_task_failure(std::exception_ptr exception) noexcept {
+
+    try {
+
+        std::string error = "Unknown native error.";
+
+        try {
+            std::rethrow_exception(exception);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        } catch (...) {
+            /* Keep the generic message; WinRT errors are described by the task itself. */
+        }
+
+        std::lock_guard<std::mutex> lock(g_detachedTaskMutex);
+        g_detachedTaskFailures.count++;
+        g_detachedTaskFailures.lastError = std::move(error);
+
+    } catch (...) {
+        /* Out of memory for the message; dropping the task matters more. */
+    }
+}
+
+inline DetachedTaskFailures detached_task_failures() {
+
+    std::lock_guard<std::mutex> lock(g_detachedTaskMutex);
+
+    return g_detachedTaskFailures;
+}
+
+/*
+ * Eagerly started coroutine nobody awaits.
+ *
+ * Tasks should handle their own errors. An exception that still escapes is
+ * recorded (see detached_task_failures()) and the task is dropped; it must
+ * not take the host process down with it.
+ */
+struct DetachedTask {
+
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { record_detached_task_failure(std::current_exception()); }
+    };
+};
+
+/*
+ * Result of an operation that completes on another thread.
+ *
+ * Either a value or an error message. Any number of threads can wait, or
+ * register a callback instead of blocking.
+ */
+template <typename T>
+class AsyncResult {
+
+public:
+
+    void complete(T value) {
+
+        std::vector<std::function<void()>> callbacks;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_value.emplace(std::move(value));
+            m_done = true;
+            callbacks.swap(m_callbacks);
+        }
+        m_completed.notify_all();
+
+        for (auto& callback : callbacks)
+            callback();
+    }
+
+    void fail(std::string error) {
+
+        std::vector<std::function<void()>> callbacks;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::move(error);
+            m_done = true;
+            callbacks.swap(m_callbacks);
+        }
+        m_completed.notify_all();
+
+        for (auto& callback : callbacks)
+            callback();
+    }
+
+    /*
+     * Runs callback once done: on the completing thread, or right away if
+     * already done. wait() returns without blocking inside the callback.
+     */
+    void on_done(std::function<void()> callback) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (!m_done) {
+                m_callbacks.push_back(std::move(callback));
+                return;
+            }
+        }
+
+        callback();
+    }
+
+    /* Blocks until done. Returns true with value set, or false with error set. */
+    bool wait(T& value, std::string& error) {
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_completed.wait(lock, [this]() { return m_done; });
+
+        if (!m_value) {
+            error = m_error;
+            return false;
+        }
+
+        value = *m_value;
+
+        return true;
+    }
+
+private:
+
+    std::mutex m_mutex;
+    std::condition_variable m_completed;
+    bool m_done = false;
+    std::optional<T> m_value;
+    std::string m_error;
+    std::vector<std::function<void()>> m_callbacks;
+};
+
+/*
+ * Coalesces concurrent requests for the same operation.
+ *
+ * The first caller (the leader) starts the operation; callers arriving
+ * while it runs share its result instead of starting another one. Result
+ * is an AsyncResult or a type derived from it.
+ */
+template <typename Result>
+class SingleFlight {
+
+public:
+
+    /* Returns the running operation's result; leader is set if the caller must start it. */
+    std::shared_ptr<Result> join(bool& leader) {
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        leader = m_inFlight == nullptr;
+
+        if (leader)
+            m_inFlight = std::make_shared<Result>();
+
+        return m_inFlight;
+    }
+
+    /* Returns whether an operation is running. */
+    bool in_flight() {
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_inFlight != nullptr;
+    }
+
+    /* Ends the flight, so that later callers start a new operation. */
+    void land(const std::shared_ptr<Result>& result) {
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_inFlight == result)
+            m_inFlight = nullptr;
+    }
+
+private:
+
+    std::mutex m_mutex;
+    std::shared_ptr<Result> m_inFlight;
+};
+
+/*
+ * Result of one license refresh.
+ *
+ * The leader writes timing before completing; waiters may read it once
+ * wait() returned.
+ */
+struct SnapshotResult : AsyncResult<std::shared_ptr<const LicenseSnapshot>> {
+    SpanClock::time_point postedAt;
+    RefreshTiming timing;
+};
+
+/* Counters of a LicenseEngine, for diagnostics. */
+struct EngineStats {
+    uint64_t refreshes = 0;
+    uint64_t failures = 0;
+    bool inFlight = false;
+    std::string lastError;
+};
+
+/*
+ * Single-flight license refreshes on top of a Backend.
+ *
+ * Backend provides:
+ *   Task<LicenseSnapshot> query_license();
+ *   std::shared_ptr<const LicenseSnapshot> publish(LicenseSnapshot snapshot);
+ *   void post(std::function<void()> work);
+ *   std::string describe(std::exception_ptr error);
+ *
+ * post() schedules work on the engine thread; describe() turns an exception
+ * into the message for the last error.
+ */
+template <typename Backend>
+class LicenseEngine {
+
+public:
+
+    explicit LicenseEngine(Backend& backend) : m_backend(backend) {}
+
+    /*
+     * Starts a license query or joins the one in flight.
+     *
+     * The result is the published snapshot. Callers that arrive while a query
+     * runs get that query's result, so a burst of calls costs one Store call.
+     * joined, if given, tells whether the query was already in flight. If
+     * the backend cannot post the query, its exception is rethrown.
+     */
+    std::shared_ptr<SnapshotResult> refresh(bool* joined = nullptr) {
+
+        bool leader = false;
+
+        std::shared_ptr<SnapshotResult> result = m_flight.join(leader);
+
+        if (joined != nullptr)
+            *joined = !leader;
+
+        if (leader) {
+
+            result->postedAt = SpanClock::now();
+
+            try {
+                m_backend.post([this, result]() { run_refresh(result); });
+            } catch (...) {
+
+                /* No run_refresh will land this flight, so later callers would join it forever. */
+                m_flight.land(result);
+                result->fail(m_backend.describe(std::current_exception()));
+
+                throw;
+            }
+        }
+
+        return result;
+    }
+
+    EngineStats stats() {
+
+        EngineStats stats;
+        stats.refreshes = m_refreshes.load(std::memory_order_relaxed);
+        stats.failures = m_failures.load(std::memory_order_relaxed);
+        stats.inFlight = m_flight.in_flight();
+
+        std::lock_guard<std::mutex> lock(m_lastErrorMutex);
+        stats.lastError = m_lastError;
+
+        return stats;
+    }
+
+private:
+
+    DetachedTask run_refresh(std::shared_ptr<SnapshotResult> result) {
+
+        std::shared_ptr<const LicenseSnapshot> published;
+        std::string error;
+
+        m_refreshes.fetch_add(1, std::memory_order_relaxed);
+
+        /* A handful of clock reads per Store query, so timing is always on. */
+        const SpanClock::time_point startedAt = SpanClock::now();
+
+        result->timing.queueWaitMicros = micros_between(result->postedAt, startedAt);
+
+        try {
+
+            LicenseSnapshot snapshot = co_await m_backend.query_license();
+
+            result->timing.storeMicros = micros_between(startedAt, SpanClock::now());
+
+            published = m_backend.publish(std::move(snapshot));
+
+        } catch (...) {
+
+            /* A failed query still took its time; publish failures keep the query time. */
+            if (result->timing.storeMicros == 0)
+                result->timing.storeMicros = micros_between(startedAt, SpanClock::now());
+
+            error = m_backend.describe(std::current_exception());
+        }
+
+        /* Land before completing: a caller woken up may immediately refresh again. */
+        m_flight.land(result);
+
+        if (published) {
+            result->complete(std::move(published));
+            co_return;
+        }
+
+        if (error.empty())
+            error = "License query failed.";
+
+        m_failures.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(m_lastErrorMutex);
+            m_lastError = error;
+        }
+
+        result->fail(std::move(error));
+    }
+
+    Backend& m_backend;
+    SingleFlight<SnapshotResult> m_flight;
+
+    std::atomic<uint64_t> m_refreshes { 0 };
+    std::atomic<uint64_t> m_failures { 0 };
+    std::mutex m_lastErrorMutex;
+    std::string m_lastError;
+};
@@ -0,0 +1,305 @@
+#include "msstore_engine.h"
+#include "msstore_snapshot.h"
+#include "msstore_test.h"
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+/*
+ * Tests of the coroutine engine against a fake backend.
+ *
+ * The backend runs posted work and Store replies only when a test asks for
+ * it, so every interleaving below is deterministic and single-threaded.
+ *
+ * Portable C++20 without WinRT, built with MSSTORE_WINRT_TESTS (see
+ * CMakeLists.txt) and run by ctest.
+ */
+
+class FakeBackend {
+
+public:
+
+    Task<LicenseSnapshot> query_license() {
+
+        m_queries++;
+
+        co_await StoreReply { *this };
+
+        if (!m_error.empty())
+            throw std::runtime_error(m_error);
+
+        co_return m_license;
+    }
+
+    std::shared_ptr<const LicenseSnapshot> publish(LicenseSnapshot snapshot) {
+
+        fingerprint_snapshot(snapshot);
+
+        return m_history.publish(std::move(snapshot));
+    }
+
+    void post(std::function<void()> work) {
+
+        if (!m_postError.empty())
+            throw std::runtime_error(m_postError);
+
+        m_posted.push_back(std::move(work));
+    }
+
+    std::string describe(std::exception_ptr error) {
+
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& ex) {
+            return ex.what();
+        } catch (...) {
+            return "Unknown error.";
+        }
+    }
+
+    /* Runs all posted work; queries then wait for answer(). */
+    void run_posted() {
+
+        while (!m_posted.empty()) {
+
+            std::function<void()> work = std::move(m_posted.front());
+            m_posted.pop_front();
+
+            work();
+        }
+    }
+
+    /* Answers all waiting queries with the license, or fails them with error. */
+    void answer(LicenseSnapshot license, std::string error = {}) {
+
+        m_license = std::move(license);
+        m_error = std::move(error);
+
+        while (!m_waiting.empty()) {
+
+            std::coroutine_handle<> handle = m_waiting.front();
+            m_waiting.pop_front();
+
+            handle.resume();
+        }
+    }
+
+    /* Makes post() throw error until called again with an empty one. */
+    void fail_posts(std::string error) { m_postError = std::move(error); }
+
+    int queries() const { return m_queries; }
+
+private:
+
+    /* Suspends a query until answer(). */
+    struct StoreReply {
+
+        FakeBackend& backend;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { backend.m_waiting.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    std::deque<std::function<void()>> m_posted;
+    std::deque<std::coroutine_handle<>> m_waiting;
+    LicenseSnapshot m_license;
+    std::string m_error;
+    std::string m_postError;
+    int m_queries = 0;
+    LicenseSnapshotHistory m_history;
+};
+
+static LicenseSnapshot make_license(const char* skuStoreId) {
+
+    LicenseSnapshot license;
+    license.skuStoreId = skuStoreId;
+    license.isActive = true;
+
+    return license;
+}
+
+static void test_concurrent_refreshes_share_one_query() {
+
+    FakeBackend backend;
+    LicenseEngine<FakeBackend> engine(backend);
+
+    bool firstJoined = true;
+    bool secondJoined = false;
+
+    std::shared_ptr<SnapshotResult> first = engine.refresh(&firstJoined);
+
+    backend.run_posted();
+
+    /* Arrives while the Store call is in flight. */
+    std::shared_ptr<SnapshotResult> second = engine.refresh(&secondJoined);
+
+    CHECK(!firstJoined);
+    CHECK(secondJoined);
+    CHECK(first == second);
+    CHECK(engine.stats().inFlight);
+
+    backend.answer(make_license("9NBLGGH4R315"));
+
+    std::shared_ptr<const LicenseSnapshot> snapshot;
+    std::string error;
+
+    CHECK(second->wait(snapshot, error));
+    CHECK(snapshot != nullptr && snapshot->skuStoreId == "9NBLGGH4R315");
+    CHECK(snapshot != nullptr && snapshot->generation == 1);
+    CHECK(backend.queries() == 1);
+    CHECK(engine.stats().refreshes == 1);
+    CHECK(!engine.stats().inFlight);
+}
+
+static void test_refresh_after_landing_starts_new_query() {
+
+    FakeBackend backend;
+    LicenseEngine<FakeBackend> engine(backend);
+
+    std::shared_ptr<SnapshotResult> first = engine.refresh();
+    backend.run_posted();
+    backend.answer(make_license("9NBLGGH4R315"));
+
+    bool joined = true;
+
+    std::shared_ptr<SnapshotResult> second = engine.refresh(&joined);
+    backend.run_posted();
+
+    CHECK(!joined);
+    CHECK(first != second);
+    CHECK(backend.queries() == 2);
+
+    /* Same license again: the history keeps the generation. */
+    backend.answer(make_license("9NBLGGH4R315"));
+
+    std::shared_ptr<const LicenseSnapshot> snapshot;
+    std::string error;
+
+    CHECK(second->wait(snapshot, error));
+    CHECK(snapshot != nullptr && snapshot->generation == 1);
+}
+
+static void test_failed_query_fails_all_waiters() {
+
+    FakeBackend backend;
+    LicenseEngine<FakeBackend> engine(backend);
+
+    std::shared_ptr<SnapshotResult> first = engine.refresh();
+    backend.run_posted();
+    std::shared_ptr<SnapshotResult> second = engine.refresh();
+
+    backend.answer({}, "Store unavailable.");
+
+    std::shared_ptr<const LicenseSnapshot> snapshot;
+    std::string error;
+
+    CHECK(!first->wait(snapshot, error));
+    CHECK(error == "Store unavailable.");
+    CHECK(!second->wait(snapshot, error));
+
+    EngineStats stats = engine.stats();
+
+    CHECK(stats.failures == 1);
+    CHECK(stats.lastError == "Store unavailable.");
+    CHECK(!stats.inFlight);
+}
+
+static void test_failed_post_lands_the_flight() {
+
+    FakeBackend backend;
+    LicenseEngine<FakeBackend> engine(backend);
+
+    backend.fail_posts("Dispatcher stopped.");
+
+    std::string thrown;
+
+    try {
+        engine.refresh();
+    } catch (const std::exception& ex) {
+        thrown = ex.what();
+    }
+
+    CHECK(thrown == "Dispatcher stopped.");
+    CHECK(!engine.stats().inFlight);
+
+    /* The next caller leads a new query instead of joining the lost one. */
+    backend.fail_posts({});
+
+    bool joined = true;
+
+    std::shared_ptr<SnapshotResult> result = engine.refresh(&joined);
+    backend.run_posted();
+    backend.answer(make_license("9NBLGGH4R315"));
+
+    std::shared_ptr<const LicenseSnapshot> snapshot;
+    std::string error;
+
+    CHECK(!joined);
+    CHECK(backend.queries() == 1);
+    CHECK(result->wait(snapshot, error));
+}
+
+static void test_on_done_runs_once_done() {
+
+    AsyncResult<int> result;
+
+    int calls = 0;
+
+    result.on_done([&calls]() { calls++; });
+
+    CHECK(calls == 0);
+
+    result.complete(42);
+
+    CHECK(calls == 1);
+
+    /* Already done: runs right away. */
+    result.on_done([&calls]() { calls++; });
+
+    CHECK(calls == 2);
+
+    int value = 0;
+    std::string error;
+
+    CHECK(result.wait(value, error));
+    CHECK(value == 42);
+}
+
+static DetachedTask throw_detached(const char* message) {
+
+    co_await std::suspend_never {};
+
+    throw std::runtime_error(message);
+}
+
+static void test_detached_task_failure_is_recorded() {
+
+    const uint64_t before = detached_task_failures().count;
+
+    /* Must return instead of terminating the process. */
+    throw_detached("Detached task failed.");
+
+    DetachedTaskFailures failures = detached_task_failures();
+
+    CHECK(failures.count == before + 1);
+    CHECK(failures.lastError == "Detached task failed.");
+}
+
+int main() {
+
+    test_concurrent_refreshes_share_one_query();
+    test_refresh_after_landing_starts_new_query();
+    test_failed_query_fails_all_waiters();
+    test_failed_post_lands_the_flight();
+    test_on_done_runs_once_done();
+    test_detached_task_failure_is_recorded();
+
+    return test_result("msstore_engine_test");
+}
@@ -0,0 +1,214 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string>
+
+using namespace winrt;
+
+/*
+ * CBOR (RFC 8949) export of license snapshots for telemetry.
+ *
+ * The encoder writes straight from the snapshot into the caller's buffer.
+ * It never allocates: past the end of the buffer it only keeps counting, so
+ * the same pass yields the required size.
+ */
+
+/* Map keys of the export, see msstore_winrt_export_license() in msstore_winrt.h. */
+enum LicenseExportKey : uint64_t {
+    EXPORT_SCHEMA = 0,
+    EXPORT_SKU_STORE_ID = 1,
+    EXPORT_IS_ACTIVE = 2,
+    EXPORT_IS_TRIAL = 3,
+    EXPORT_EXPIRATION_DATE = 4,
+    EXPORT_FINGERPRINT = 5,
+    EXPORT_GENERATION = 6,
+    EXPORT_CAPTURED_AT = 7,
+    EXPORT_ADD_ONS = 8
+};
+
+enum AddOnExportKey : uint64_t {
+    EXPORT_ADD_ON_SKU_STORE_ID = 0,
+    EXPORT_ADD_ON_IN_APP_OFFER_TOKEN = 1,
+    EXPORT_ADD_ON_EXPIRATION_DATE = 2,
+    EXPORT_ADD_ON_FINGERPRINT = 3
+};
+
+static constexpr uint8_t CBOR_UNSIGNED = 0;
+static constexpr uint8_t CBOR_NEGATIVE = 1;
+static constexpr uint8_t CBOR_TEXT = 3;
+static constexpr uint8_t CBOR_ARRAY = 4;
+static constexpr uint8_t CBOR_MAP = 5;
+static constexpr uint8_t CBOR_FALSE = 0xF4;
+static constexpr uint8_t CBOR_TRUE = 0xF5;
+
+class CborWriter {
+
+public:
+
+    CborWriter(uint8_t* buffer, size_t size) : m_buffer(buffer), m_size(size) {}
+
+    /* Bytes the document needs, also if they did not fit. */
+    size_t length() const { return m_length; }
+
+    void head(uint8_t major, uint64_t value) {
+
+        const uint8_t type = static_cast<uint8_t>(major << 5);
+
+        if (value < 24) {
+            put(type | static_cast<uint8_t>(value));
+        } else if (value <= 0xFF) {
+            put(type | 24);
+            put_big_endian(value, 1);
+        } else if (value <= 0xFFFF) {
+            put(type | 25);
+            put_big_endian(value, 2);
+        } else if (value <= 0xFFFFFFFF) {
+            put(type | 26);
+            put_big_endian(value, 4);
+        } else {
+            put(type | 27);
+            put_big_endian(value, 8);
+        }
+    }
+
+    void add_unsigned(uint64_t value) {
+        head(CBOR_UNSIGNED, value);
+    }
+
+    void add_signed(int64_t value) {
+
+        /* Negative n is encoded as -1 - n, which is ~n in two's complement. */
+        if (value < 0)
+            head(CBOR_NEGATIVE, ~static_cast<uint64_t>(value));
+        else
+            head(CBOR_UNSIGNED, static_cast<uint64_t>(value));
+    }
+
+    void add_bool(bool value) {
+        put(value ? CBOR_TRUE : CBOR_FALSE);
+    }
+
+    void add_text(const std::string& value) {
+
+        head(CBOR_TEXT, value.size());
+
+        if (!value.empty() && m_length + value.size() <= m_size)
+            std::memcpy(m_buffer + m_length, value.data(), value.size());
+
+        m_length += value.size();
+    }
+
+private:
+
+    void put(uint8_t byte) {
+
+        if (m_length < m_size)
+            m_buffer[m_length] = byte;
+
+        ++m_length;
+    }
+
+    void put_big_endian(uint64_t value, int byteCount) {
+
+        for (int index = byteCount - 1; index >= 0; --index)
+            put(static_cast<uint8_t>(value >> (index * 8)));
+    }
+
+    uint8_t* m_buffer;
+    size_t m_size;
+    size_t m_length = 0;
+};
+
+size_t encode_license_cbor(const LicenseSnapshot& snapshot, uint8_t* buffer, size_t size) {
+
+    CborWriter writer(buffer, size);
+
+    writer.head(CBOR_MAP, 9);
+
+    writer.add_unsigned(EXPORT_SCHEMA);
+    writer.add_unsigned(MSSTORE_WINRT_LICENSE_EXPORT_SCHEMA);
+
+    writer.add_unsigned(EXPORT_SKU_STORE_ID);
+    writer.add_text(snapshot.skuStoreId);
+
+    writer.add_unsigned(EXPORT_IS_ACTIVE);
+    writer.add_bool(snapshot.isActive);
+
+    writer.add_unsigned(EXPORT_IS_TRIAL);
+    writer.add_bool(snapshot.isTrial);
+
+    writer.add_unsigned(EXPORT_EXPIRATION_DATE);
+    writer.add_signed(snapshot.expirationDate);
+
+    writer.add_unsigned(EXPORT_FINGERPRINT);
+    writer.add_unsigned(snapshot.fingerprint);
+
+    writer.add_unsigned(EXPORT_GENERATION);
+    writer.add_signed(snapshot.generation);
+
+    writer.add_unsigned(EXPORT_CAPTURED_AT);
+    writer.add_signed(snapshot.capturedAt);
+
+    writer.add_unsigned(EXPORT_ADD_ONS);
+    writer.head(CBOR_ARRAY, snapshot.addOns.size());
+
+    for (const AddOnSnapshot& addOn : snapshot.addOns) {
+
+        writer.head(CBOR_MAP, 4);
+
+        writer.add_unsigned(EXPORT_ADD_ON_SKU_STORE_ID);
+        writer.add_text(addOn.skuStoreId);
+
+        writer.add_unsigned(EXPORT_ADD_ON_IN_APP_OFFER_TOKEN);
+        writer.add_text(addOn.inAppOfferToken);
+
+        writer.add_unsigned(EXPORT_ADD_ON_EXPIRATION_DATE);
+        writer.add_signed(addOn.expirationDate);
+
+        writer.add_unsigned(EXPORT_ADD_ON_FINGERPRINT);
+        writer.add_unsigned(addOn.fingerprint);
+    }
+
+    return writer.length();
+}
+
+/*
+ * Writes the license as CBOR into buffer.
+ */
+extern "C" MSSTORE_WINRT_API int64_t msstore_winrt_export_license(uint8_t* buffer, int64_t size, int64_t maxAgeMillis) {
+
+    try {
+
+        if (size < 0 || (buffer == nullptr && size != 0)) {
+            g_lastError = "Export buffer is null or has a negative size.";
+            return -1;
+        }
+
+        auto snapshot = current_snapshot();
+
+        if (snapshot == nullptr || maxAgeMillis <= 0 ||
+            current_unix_epoch_millis() - snapshot->capturedAt > maxAgeMillis) {
+
+            /* Joins a query already in flight instead of starting another one. */
+            snapshot = refresh_license_snapshot();
+        }
+
+        const size_t length = encode_license_cbor(*snapshot, buffer, static_cast<size_t>(size));
+
+        g_lastError.clear();
+
+        return static_cast<int64_t>(length);
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return -1;
+}
@@ -0,0 +1,159 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+#include "msstore_json.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * ExtendedJsonData documents of the last license snapshot.
+ *
+ * Kept as plain UTF-8 so lookups can scan them in place. Guarded by
+ * g_extendedJsonMutex; lookups hold the lock only while scanning and
+ * copying the single value found.
+ */
+static std::atomic<bool> g_keepExtendedJson { false };
+static std::mutex g_extendedJsonMutex;
+static bool g_hasExtendedJson = false;
+static std::string g_appExtendedJson;
+static std::vector<std::pair<std::string, std::string>> g_addOnExtendedJson;
+
+bool is_extended_json_kept() {
+    return g_keepExtendedJson.load(std::memory_order_relaxed);
+}
+
+void keep_extended_json(std::string appJson, std::vector<std::pair<std::string, std::string>> addOnJson) {
+
+    std::lock_guard<std::mutex> lock(g_extendedJsonMutex);
+
+    g_appExtendedJson = std::move(appJson);
+    g_addOnExtendedJson = std::move(addOnJson);
+    g_hasExtendedJson = true;
+}
+
+/*
+ * Looks up path in json and returns a copy of the value for the caller.
+ *
+ * A missing field returns nullptr with an empty last error.
+ */
+static const char* find_json_field(const std::string& json, const char* path) {
+
+    std::string_view value;
+
+    if (!json_find_path(json, path, value)) {
+        g_lastError.clear();
+        return nullptr;
+    }
+
+    const char* result = dup_string(std::string(value));
+
+    if (result == nullptr) {
+        g_lastError = "Out of memory allocating JSON field.";
+        return nullptr;
+    }
+
+    g_lastError.clear();
+
+    return result;
+}
+
+/*
+ * Enables or disables keeping ExtendedJsonData.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_set_keep_extended_json(bool keep) {
+
+    g_keepExtendedJson.store(keep, std::memory_order_relaxed);
+
+    if (keep)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_extendedJsonMutex);
+
+    g_appExtendedJson.clear();
+    g_appExtendedJson.shrink_to_fit();
+    g_addOnExtendedJson.clear();
+    g_addOnExtendedJson.shrink_to_fit();
+    g_hasExtendedJson = false;
+}
+
+/*
+ * Returns one field of the kept app license ExtendedJsonData.
+ */
+extern "C" MSSTORE_WINRT_API const char* msstore_winrt_get_json_field(const char* path) {
+
+    if (path == nullptr) {
+        g_lastError = "JSON path is null.";
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(g_extendedJsonMutex);
+
+    if (!g_hasExtendedJson) {
+        g_lastError = "No ExtendedJsonData kept. Enable it and query the license first.";
+        return nullptr;
+    }
+
+    return find_json_field(g_appExtendedJson, path);
+}
+
+/*
+ * Returns one field of the kept ExtendedJsonData of an add-on license.
+ */
+extern "C" MSSTORE_WINRT_API const char* msstore_winrt_get_addon_json_field(const char* storeId, const char* path) {
+
+    if (storeId == nullptr || *storeId == '\0') {
+        g_lastError = "Store ID is null or empty.";
+        return nullptr;
+    }
+
+    if (path == nullptr) {
+        g_lastError = "JSON path is null.";
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(g_extendedJsonMutex);
+
+    if (!g_hasExtendedJson) {
+        g_lastError = "No ExtendedJsonData kept. Enable it and query the license first.";
+        return nullptr;
+    }
+
+    const size_t storeIdLength = std::strlen(storeId);
+
+    /* SkuStoreId looks like "9NBLGGH4R315/0010"; match the Store ID part. */
+    for (auto const& entry : g_addOnExtendedJson) {
+
+        const std::string& skuStoreId = entry.first;
+
+        if (skuStoreId.compare(0, storeIdLength, storeId) == 0 &&
+            (skuStoreId.size() == storeIdLength || skuStoreId[storeIdLength] == '/'))
+            return find_json_field(entry.second, path);
+    }
+
+    g_lastError.clear();
+
+    return nullptr;
+}
+
+void dump_extended_json_state(DiagnosticsWriter& writer) {
+
+    std::lock_guard<std::mutex> lock(g_extendedJsonMutex);
+
+    size_t bytes = g_appExtendedJson.size();
+
+    for (auto const& entry : g_addOnExtendedJson)
+        bytes += entry.first.size() + entry.second.size();
+
+    writer.begin_object("extendedJson");
+    writer.add_bool("keep", is_extended_json_kept());
+    writer.add_bool("available", g_hasExtendedJson);
+    writer.add_number("documents", g_hasExtendedJson ? static_cast<int64_t>(g_addOnExtendedJson.size() + 1) : 0);
+    writer.add_number("bytes", static_cast<int64_t>(bytes));
+    writer.end_object();
+}
@@ -0,0 +1,800 @@
+#include "msstore_engine.h"
+#include "msstore_refresh_policy.h"
+#include "msstore_snapshot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Fleet load simulator for the cache and refresh policies.
+ *
+ * Runs a fleet of clients against a fake Store in simulated time. Every
+ * client has its own LicenseEngine and snapshot history, the same code the
+ * DLL uses, so concurrent reads of a client share one query exactly as in
+ * the field. Its background refresher follows msstore_refresh_policy.h like
+ * msstore_refresher.cpp does. Only the Store is fake: a fleet-wide token
+ * bucket, log-normal latencies and outage windows.
+ *
+ *   msstore_fleet_sim [name=value ...]
+ *
+ * See FLEET_OPTIONS for the names and defaults. outage=<startMinutes>:<minutes>
+ * can be given several times. Prints the Store request volume, the latency
+ * clients observed and how stale their licenses were, as name=value lines
+ * that diff well between configurations.
+ *
+ * Portable C++20 without WinRT, built with MSSTORE_WINRT_FLEET_SIM (see
+ * CMakeLists.txt), also on Linux and macOS.
+ */
+
+static constexpr int64_t SECOND_MILLIS = 1000;
+static constexpr int64_t MINUTE_MILLIS = 60 * SECOND_MILLIS;
+static constexpr int64_t HOUR_MILLIS = 60 * MINUTE_MILLIS;
+static constexpr int64_t DAY_MILLIS = 24 * HOUR_MILLIS;
+
+/* Expiration date of perpetual licenses as the Store reports it (year 9999). */
+static constexpr int64_t PERPETUAL_EXPIRATION = 253402300799000LL;
+
+static constexpr int64_t SUBSCRIPTION_PERIOD_MILLIS = 30 * DAY_MILLIS;
+
+struct FleetOption {
+    const char* name;
+    double value;
+    const char* description;
+};
+
+/* Command-line options with their defaults. */
+static FleetOption FLEET_OPTIONS[] = {
+    { "clients", 10000, "number of clients" },
+    { "hours", 24, "simulated time" },
+    { "seed", 1, "random seed; same seed, same run" },
+    { "rampMinutes", 0, "clients launch spread over this time; 0 = all at once" },
+    { "readsPerHour", 4, "license reads per client and hour, after the one at launch" },
+    { "ttlMillis", 5 * MINUTE_MILLIS, "max age of a cached license a read accepts; 0 = always query" },
+    { "intervalMillis", 0, "refresher interval; 0 = no refresher" },
+    { "minIntervalMillis", 0, "refresher min interval; 0 = interval / 10" },
+    { "maxIntervalMillis", 0, "refresher max interval; 0 = interval * 4" },
+    { "storeRps", 200, "Store requests per second the fleet may make" },
+    { "storeBurst", 2000, "requests the Store accepts above storeRps in a burst" },
+    { "latencyMedianMillis", 250, "median Store latency" },
+    { "latencyP99Millis", 2500, "99th percentile Store latency" },
+    { "throttleMillis", 80, "time until a throttled request fails" },
+    { "timeoutMillis", 30 * SECOND_MILLIS, "time until a request fails during an outage" },
+    { "purchasesPerDay", 0.02, "license changes per client and day" },
+    { "subscriptionShare", 0.3, "share of clients with a subscription add-on" },
+    { "renewalDelayMillis", 2 * MINUTE_MILLIS, "time after an expiration until the Store shows the renewal" }
+};
+
+static double option(const char* name) {
+
+    for (const FleetOption& option : FLEET_OPTIONS)
+        if (std::string(option.name) == name)
+            return option.value;
+
+    throw std::logic_error(std::string("Unknown option ") + name);
+}
+
+struct OutageWindow {
+    int64_t start = 0;
+    int64_t end = 0;
+};
+
+/* Result of one fake Store request, known when the request arrives. */
+enum class StoreOutcome {
+    Answered,
+    Throttled,
+    Unavailable
+};
+
+/* Store counters of one simulated hour. */
+struct HourStats {
+    uint64_t requests = 0;
+    uint64_t throttled = 0;
+    uint64_t unavailable = 0;
+};
+
+class Fleet;
+
+/* A client's Backend of LicenseEngine: queries the fake Store in simulated time. */
+class SimBackend {
+
+public:
+
+    SimBackend(Fleet& fleet, size_t clientIndex) : m_fleet(fleet), m_clientIndex(clientIndex) {}
+
+    Task<LicenseSnapshot> query_license();
+
+    std::shared_ptr<const LicenseSnapshot> publish(LicenseSnapshot snapshot) {
+        return m_history.publish(std::move(snapshot));
+    }
+
+    void post(std::function<void()> work);
+
+    std::string describe(std::exception_ptr error) {
+
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& ex) {
+            return ex.what();
+        } catch (...) {
+            return "Unknown error.";
+        }
+    }
+
+    std::shared_ptr<const LicenseSnapshot> current() const {
+        return m_history.current();
+    }
+
+private:
+
+    Fleet& m_fleet;
+    size_t m_clientIndex;
+    LicenseSnapshotHistory m_history;
+};
+
+/* One install: the Store's view of its license and the library state of its process. */
+struct SimClient {
+
+    SimBackend backend;
+    LicenseEngine<SimBackend> engine;
+
+    /* The license as the Store currently has it. */
+    LicenseSnapshot truth;
+
+    /* Earliest truth change the client has not seen yet; 0 if in sync. */
+    int64_t unseenChangeAt = 0;
+
+    /* Refresher state, see msstore_refresher.cpp. */
+    RefreshObservation observation;
+    int64_t lastRefreshGeneration = 0;
+
+    SimClient(Fleet& fleet, size_t index) : backend(fleet, index), engine(backend) {}
+};
+
+class Fleet {
+
+public:
+
+    Fleet(uint64_t seed, std::vector<OutageWindow> outages) : m_random(seed), m_outages(std::move(outages)) {
+
+        m_durationMillis = static_cast<int64_t>(option("hours") * HOUR_MILLIS);
+        m_ttlMillis = static_cast<int64_t>(option("ttlMillis"));
+        m_readsPerMillis = option("readsPerHour") / HOUR_MILLIS;
+
+        m_policy.intervalMillis = static_cast<int64_t>(option("intervalMillis"));
+        m_policy.minIntervalMillis = static_cast<int64_t>(option("minIntervalMillis"));
+        m_policy.maxIntervalMillis = static_cast<int64_t>(option("maxIntervalMillis"));
+
+        if (m_policy.intervalMillis > 0) {
+
+            if (m_policy.minIntervalMillis == 0)
+                m_policy.minIntervalMillis = m_policy.intervalMillis / 10;
+
+            if (m_policy.maxIntervalMillis == 0)
+                m_policy.maxIntervalMillis = m_policy.intervalMillis * 4;
+
+            if (!is_valid_refresh_policy(m_policy))
+                throw std::invalid_argument("Refresh intervals must be positive with min <= interval <= max.");
+        }
+
+        m_storeTokens = option("storeBurst");
+
+        /* sigma of a log-normal from its median and 99th percentile (z = 2.326). */
+        const double median = option("latencyMedianMillis");
+        const double sigma = std::log(std::max(option("latencyP99Millis"), median) / median) / 2.326;
+
+        m_latency = std::lognormal_distribution<double>(std::log(median), sigma);
+
+        m_hours.resize(static_cast<size_t>((m_durationMillis + HOUR_MILLIS - 1) / HOUR_MILLIS));
+        m_requestsPerSecond.resize(static_cast<size_t>(m_durationMillis / SECOND_MILLIS + 1));
+    }
+
+    int64_t now() const { return m_now; }
+
+    /* Runs work at the given simulated time; ignored past the end of the run. */
+    void schedule(int64_t at, std::function<void()> work) {
+
+        if (at <= m_durationMillis)
+            m_events.push(Event { at, m_nextEventSequence++, std::move(work) });
+    }
+
+    void run() {
+
+        const size_t clientCount = static_cast<size_t>(option("clients"));
+        const int64_t rampMillis = static_cast<int64_t>(option("rampMinutes") * MINUTE_MILLIS);
+
+        m_clients.reserve(clientCount);
+
+        for (size_t index = 0; index < clientCount; ++index) {
+
+            m_clients.push_back(std::make_unique<SimClient>(*this, index));
+
+            SimClient& client = *m_clients.back();
+
+            init_truth(client, index);
+
+            const int64_t launchAt = rampMillis > 0 ? uniform_millis(rampMillis) : 0;
+
+            schedule(launchAt, [this, index]() { launch(index); });
+        }
+
+        while (!m_events.empty()) {
+
+            /* The queue only hands out const references; work is moved out before running. */
+            Event event = std::move(const_cast<Event&>(m_events.top()));
+            m_events.pop();
+
+            m_now = event.at;
+            event.work();
+        }
+
+        m_now = m_durationMillis;
+
+        /* Changes nobody saw until the end are as late as the run allows. */
+        for (const auto& client : m_clients) {
+
+            if (client->unseenChangeAt != 0) {
+                m_detectionLags.push_back(m_now - client->unseenChangeAt);
+                m_undetectedChanges++;
+            }
+        }
+    }
+
+    /* Decides a request's outcome and latency on arrival, like a front end would. */
+    StoreOutcome admit_request(int64_t& latencyMillis) {
+
+        record_request();
+
+        if (in_outage(m_now)) {
+
+            m_hours[hour_index()].unavailable++;
+            latencyMillis = static_cast<int64_t>(option("timeoutMillis"));
+
+            return StoreOutcome::Unavailable;
+        }
+
+        refill_store_tokens();
+
+        if (m_storeTokens < 1.0) {
+
+            m_hours[hour_index()].throttled++;
+            latencyMillis = static_cast<int64_t>(option("throttleMillis"));
+
+            return StoreOutcome::Throttled;
+        }
+
+        m_storeTokens -= 1.0;
+
+        latencyMillis = std::max<int64_t>(1, static_cast<int64_t>(m_latency(m_random)));
+
+        return StoreOutcome::Answered;
+    }
+
+    /* Copy of the Store's current view of a client's license, as a query returns it. */
+    LicenseSnapshot store_license(size_t clientIndex) const {
+
+        LicenseSnapshot snapshot = m_clients[clientIndex]->truth;
+        snapshot.capturedAt = m_now;
+
+        return snapshot;
+    }
+
+    void report() const;
+
+private:
+
+    struct Event {
+
+        int64_t at;
+        uint64_t sequence;
+        std::function<void()> work;
+
+        /* Earliest first, and in scheduling order at the same time. */
+        bool operator<(const Event& other) const {
+            return at != other.at ? at > other.at : sequence > other.sequence;
+        }
+    };
+
+    int64_t uniform_millis(int64_t rangeMillis) {
+        return std::uniform_int_distribution<int64_t>(0, rangeMillis - 1)(m_random);
+    }
+
+    int64_t exponential_millis(double ratePerMillis) {
+
+        if (ratePerMillis <= 0)
+            return m_durationMillis + 1;
+
+        return 1 + static_cast<int64_t>(std::exponential_distribution<double>(ratePerMillis)(m_random));
+    }
+
+    size_t hour_index() const {
+        return std::min(static_cast<size_t>(m_now / HOUR_MILLIS), m_hours.size() - 1);
+    }
+
+    bool in_outage(int64_t at) const {
+
+        for (const OutageWindow& outage : m_outages)
+            if (at >= outage.start && at < outage.end)
+                return true;
+
+        return false;
+    }
+
+    void record_request() {
+
+        m_storeRequests++;
+        m_hours[hour_index()].requests++;
+
+        const size_t second = static_cast<size_t>(m_now / SECOND_MILLIS);
+
+        if (second < m_requestsPerSecond.size())
+            m_requestsPerSecond[second]++;
+    }
+
+    void refill_store_tokens() {
+
+        m_storeTokens = std::min(
+            option("storeBurst"),
+            m_storeTokens + option("storeRps") * static_cast<double>(m_now - m_storeTokensAt) / SECOND_MILLIS
+        );
+
+        m_storeTokensAt = m_now;
+    }
+
+    void init_truth(SimClient& client, size_t index) {
+
+        LicenseSnapshot& truth = client.truth;
+        truth.skuStoreId = "9NBLGGH4R315/0010";
+        truth.isActive = true;
+        truth.expirationDate = PERPETUAL_EXPIRATION;
+
+        std::bernoulli_distribution hasSubscription(option("subscriptionShare"));
+
+        if (hasSubscription(m_random)) {
+
+            AddOnSnapshot subscription;
+            subscription.skuStoreId = "9P0000000000/0010";
+            subscription.inAppOfferToken = "subscription";
+            subscription.expirationDate = uniform_millis(SUBSCRIPTION_PERIOD_MILLIS);
+
+            truth.addOns.push_back(std::move(subscription));
+
+            schedule_renewal(index, truth.addOns.back().expirationDate);
+        }
+
+        fingerprint_snapshot(truth);
+
+        schedule_purchase(index);
+    }
+
+    /* The Store shows the next period a little after the current one ended. */
+    void schedule_renewal(size_t index, int64_t expirationDate) {
+
+        schedule(expirationDate + static_cast<int64_t>(option("renewalDelayMillis")), [this, index]() {
+
+            SimClient& client = *m_clients[index];
+
+            for (AddOnSnapshot& addOn : client.truth.addOns) {
+
+                if (addOn.inAppOfferToken == "subscription") {
+
+                    addOn.expirationDate += SUBSCRIPTION_PERIOD_MILLIS;
+
+                    schedule_renewal(index, addOn.expirationDate);
+                }
+            }
+
+            change_truth(client);
+        });
+    }
+
+    void schedule_purchase(size_t index) {
+
+        schedule(m_now + exponential_millis(option("purchasesPerDay") / DAY_MILLIS), [this, index]() {
+
+            SimClient& client = *m_clients[index];
+
+            char skuStoreId[32];
+            std::snprintf(skuStoreId, sizeof(skuStoreId), "9P%010zu/0010", client.truth.addOns.size() + 1);
+
+            AddOnSnapshot addOn;
+            addOn.skuStoreId = skuStoreId;
+            addOn.inAppOfferToken = "durable";
+            addOn.expirationDate = PERPETUAL_EXPIRATION;
+
+            client.truth.addOns.push_back(std::move(addOn));
+
+            change_truth(client);
+            schedule_purchase(index);
+        });
+    }
+
+    void change_truth(SimClient& client) {
+
+        fingerprint_snapshot(client.truth);
+
+        if (client.unseenChangeAt == 0)
+            client.unseenChangeAt = m_now;
+
+        m_truthChanges++;
+    }
+
+    /* Called with every snapshot a client published. */
+    void observe(SimClient& client, const LicenseSnapshot& snapshot) {
+
+        if (client.unseenChangeAt != 0 && snapshot.fingerprint == client.truth.fingerprint) {
+            m_detectionLags.push_back(m_now - client.unseenChangeAt);
+            client.unseenChangeAt = 0;
+        }
+    }
+
+    void launch(size_t index) {
+
+        read_license(index);
+
+        if (m_policy.intervalMillis > 0) {
+
+            SimClient& client = *m_clients[index];
+
+            client.observation.jitterSeed = refresh_jitter_hash(index, 0);
+
+            schedule(m_now + initial_refresh_delay_millis(m_policy, client.observation.jitterSeed), [this, index]() {
+                refresh_tick(index);
+            });
+        }
+    }
+
+    /*
+     * One license read of the app, like MsStore.getLicenseInfo(ttlMillis):
+     * from the cache if fresh enough, else through the engine.
+     */
+    void read_license(size_t index) {
+
+        SimClient& client = *m_clients[index];
+
+        m_reads++;
+
+        auto cached = client.backend.current();
+
+        if (cached != nullptr && m_ttlMillis > 0 && m_now - cached->capturedAt <= m_ttlMillis) {
+
+            m_cachedReads++;
+            m_readLatencies.push_back(0);
+
+            if (cached->fingerprint != client.truth.fingerprint)
+                m_staleReads++;
+
+            m_cacheAges.push_back(m_now - cached->capturedAt);
+
+        } else {
+
+            const int64_t startedAt = m_now;
+
+            bool joined = false;
+
+            auto result = client.engine.refresh(&joined);
+
+            if (joined)
+                m_joinedReads++;
+
+            result->on_done([this, index, result, startedAt]() {
+
+                std::shared_ptr<const LicenseSnapshot> snapshot;
+                std::string error;
+
+                m_readLatencies.push_back(m_now - startedAt);
+                m_queriedLatencies.push_back(m_now - startedAt);
+
+                if (result->wait(snapshot, error))
+                    observe(*m_clients[index], *snapshot);
+                else
+                    m_failedReads++;
+            });
+        }
+
+        schedule(m_now + exponential_millis(m_readsPerMillis), [this, index]() { read_license(index); });
+    }
+
+    /* Mirrors run_refresh_tick() and finish_refresh_tick() of msstore_refresher.cpp. */
+    void refresh_tick(size_t index) {
+
+        SimClient& client = *m_clients[index];
+
+        auto snapshot = client.backend.current();
+
+        if (snapshot != nullptr && m_now - snapshot->capturedAt < m_policy.minIntervalMillis) {
+            m_refresherSkips++;
+            finish_refresh_tick(index, snapshot);
+            return;
+        }
+
+        m_refresherQueries++;
+
+        auto result = client.engine.refresh();
+
+        result->on_done([this, index, result]() {
+
+            std::shared_ptr<const LicenseSnapshot> refreshed;
+            std::string error;
+
+            if (result->wait(refreshed, error))
+                observe(*m_clients[index], *refreshed);
+            else
+                refreshed = nullptr;
+
+            finish_refresh_tick(index, refreshed);
+        });
+    }
+
+    void finish_refresh_tick(size_t index, const std::shared_ptr<const LicenseSnapshot>& snapshot) {
+
+        SimClient& client = *m_clients[index];
+        RefreshObservation& observation = client.observation;
+
+        if (snapshot != nullptr) {
+
+            const bool changed = client.lastRefreshGeneration != 0 && snapshot->generation != client.lastRefreshGeneration;
+
+            observation.changeScore = decay_change_score(observation.changeScore, changed);
+            observation.consecutiveFailures = 0;
+            observation.nextExpirationAt = next_expiration_at(*snapshot, m_now);
+
+            client.lastRefreshGeneration = snapshot->generation;
+
+        } else {
+            observation.consecutiveFailures++;
+        }
+
+        observation.now = m_now;
+
+        const int64_t delayMillis = refresh_delay_millis(m_policy, observation);
+
+        observation.round++;
+
+        schedule(m_now + delayMillis, [this, index]() { refresh_tick(index); });
+    }
+
+    std::mt19937_64 m_random;
+    std::lognormal_distribution<double> m_latency;
+    std::vector<OutageWindow> m_outages;
+
+    int64_t m_durationMillis = 0;
+    int64_t m_ttlMillis = 0;
+    double m_readsPerMillis = 0;
+    RefreshPolicy m_policy;
+
+    int64_t m_now = 0;
+    uint64_t m_nextEventSequence = 0;
+    std::priority_queue<Event> m_events;
+    std::vector<std::unique_ptr<SimClient>> m_clients;
+
+    double m_storeTokens = 0;
+    int64_t m_storeTokensAt = 0;
+
+    uint64_t m_storeRequests = 0;
+    std::vector<HourStats> m_hours;
+    std::vector<uint32_t> m_requestsPerSecond;
+
+    uint64_t m_reads = 0;
+    uint64_t m_cachedReads = 0;
+    uint64_t m_joinedReads = 0;
+    uint64_t m_failedReads = 0;
+    uint64_t m_staleReads = 0;
+    uint64_t m_refresherQueries = 0;
+    uint64_t m_refresherSkips = 0;
+    uint64_t m_truthChanges = 0;
+    uint64_t m_undetectedChanges = 0;
+
+    std::vector<int64_t> m_readLatencies;
+    std::vector<int64_t> m_queriedLatencies;
+    std::vector<int64_t> m_cacheAges;
+    std::vector<int64_t> m_detectionLags;
+};
+
+Task<LicenseSnapshot> SimBackend::query_license() {
+
+    /* Suspends the engine's coroutine until the fake Store answers. */
+    struct StoreReply {
+
+        Fleet& fleet;
+        StoreOutcome outcome = StoreOutcome::Answered;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+
+            int64_t latencyMillis = 0;
+
+            outcome = fleet.admit_request(latencyMillis);
+
+            fleet.schedule(fleet.now() + latencyMillis, [handle]() { handle.resume(); });
+        }
+
+        StoreOutcome await_resume() const noexcept { return outcome; }
+    };
+
+    const StoreOutcome outcome = co_await StoreReply { m_fleet };
+
+    if (outcome == StoreOutcome::Throttled)
+        throw std::runtime_error("Store throttled the request.");
+
+    if (outcome == StoreOutcome::Unavailable)
+        throw std::runtime_error("Store did not answer in time.");
+
+    co_return m_fleet.store_license(m_clientIndex);
+}
+
+void SimBackend::post(std::function<void()> work) {
+    m_fleet.schedule(m_fleet.now(), std::move(work));
+}
+
+/* Percentile by rank; reorders values. */
+static int64_t percentile(std::vector<int64_t>& values, double fraction) {
+
+    if (values.empty())
+        return 0;
+
+    const size_t rank = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(rank), values.end());
+
+    return values[rank];
+}
+
+static void print_distribution(const char* name, std::vector<int64_t> values) {
+
+    std::printf("%sP50=%lld %sP95=%lld %sP99=%lld %sMax=%lld\n",
+        name, static_cast<long long>(percentile(values, 0.50)),
+        name, static_cast<long long>(percentile(values, 0.95)),
+        name, static_cast<long long>(percentile(values, 0.99)),
+        name, static_cast<long long>(percentile(values, 1.0)));
+}
+
+static double share(uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0.0 : static_cast<double>(part) / static_cast<double>(whole);
+}
+
+void Fleet::report() const {
+
+    for (const FleetOption& option : FLEET_OPTIONS)
+        std::printf("%s=%g\n", option.name, option.value);
+
+    for (const OutageWindow& outage : m_outages)
+        std::printf("outage=%lld:%lld\n",
+            static_cast<long long>(outage.start / MINUTE_MILLIS),
+            static_cast<long long>((outage.end - outage.start) / MINUTE_MILLIS));
+
+    uint64_t throttled = 0;
+    uint64_t unavailable = 0;
+
+    for (const HourStats& hour : m_hours) {
+        throttled += hour.throttled;
+        unavailable += hour.unavailable;
+    }
+
+    const double clientHours = option("clients") * option("hours");
+
+    std::printf("storeRequests=%llu\n", static_cast<unsigned long long>(m_storeRequests));
+    std::printf("storeRequestsPerClientHour=%.3f\n", clientHours > 0 ? m_storeRequests / clientHours : 0.0);
+    std::printf("storeRequestsPeakSecond=%u\n",
+        m_requestsPerSecond.empty() ? 0u : *std::max_element(m_requestsPerSecond.begin(), m_requestsPerSecond.end()));
+    std::printf("storeThrottled=%llu storeThrottledShare=%.4f\n",
+        static_cast<unsigned long long>(throttled), share(throttled, m_storeRequests));
+    std::printf("storeUnavailable=%llu\n", static_cast<unsigned long long>(unavailable));
+
+    std::printf("reads=%llu cachedShare=%.4f joinedShare=%.4f failedShare=%.4f\n",
+        static_cast<unsigned long long>(m_reads),
+        share(m_cachedReads, m_reads), share(m_joinedReads, m_reads), share(m_failedReads, m_reads));
+
+    print_distribution("readMillis", m_readLatencies);
+    print_distribution("queriedReadMillis", m_queriedLatencies);
+
+    std::printf("refresherQueries=%llu refresherSkips=%llu\n",
+        static_cast<unsigned long long>(m_refresherQueries), static_cast<unsigned long long>(m_refresherSkips));
+
+    std::printf("staleReads=%llu staleReadShare=%.4f\n",
+        static_cast<unsigned long long>(m_staleReads), share(m_staleReads, m_cachedReads));
+
+    print_distribution("cacheAgeMillis", m_cacheAges);
+
+    std::printf("licenseChanges=%llu undetectedChanges=%llu\n",
+        static_cast<unsigned long long>(m_truthChanges), static_cast<unsigned long long>(m_undetectedChanges));
+
+    print_distribution("detectionLagMillis", m_detectionLags);
+
+    for (size_t hour = 0; hour < m_hours.size(); ++hour)
+        std::printf("hour=%zu requests=%llu throttled=%llu unavailable=%llu\n", hour,
+            static_cast<unsigned long long>(m_hours[hour].requests),
+            static_cast<unsigned long long>(m_hours[hour].throttled),
+            static_cast<unsigned long long>(m_hours[hour].unavailable));
+}
+
+static void print_usage(const char* program) {
+
+    std::fprintf(stderr, "Usage: %s [name=value ...]\n\n", program);
+
+    for (const FleetOption& option : FLEET_OPTIONS)
+        std::fprintf(stderr, "  %-20s %-10g %s\n", option.name, option.value, option.description);
+
+    std::fprintf(stderr, "  %-20s %-10s %s\n", "outage", "", "<startMinutes>:<minutes>, repeatable");
+}
+
+int main(int argc, char** argv) {
+
+    std::vector<OutageWindow> outages;
+
+    for (int index = 1; index < argc; ++index) {
+
+        const std::string argument = argv[index];
+        const size_t separator = argument.find('=');
+
+        if (separator == std::string::npos) {
+            print_usage(argv[0]);
+            return 2;
+        }
+
+        const std::string name = argument.substr(0, separator);
+        const char* value = argv[index] + separator + 1;
+
+        if (name == "outage") {
+
+            long long startMinutes = 0;
+            long long minutes = 0;
+
+            if (std::sscanf(value, "%lld:%lld", &startMinutes, &minutes) != 2 || startMinutes < 0 || minutes <= 0) {
+                print_usage(argv[0]);
+                return 2;
+            }
+
+            outages.push_back({ startMinutes * MINUTE_MILLIS, (startMinutes + minutes) * MINUTE_MILLIS });
+            continue;
+        }
+
+        FleetOption* match = nullptr;
+
+        for (FleetOption& option : FLEET_OPTIONS)
+            if (name == option.name)
+                match = &option;
+
+        char* end = nullptr;
+        const double parsed = std::strtod(value, &end);
+
+        if (match == nullptr || end == value || *end != '\0' || parsed < 0) {
+            print_usage(argv[0]);
+            return 2;
+        }
+
+        match->value = parsed;
+    }
+
+    if (option("clients") < 1 || option("hours") <= 0 || option("storeBurst") < 1 || option("latencyMedianMillis") <= 0) {
+        std::fprintf(stderr, "clients, hours, storeBurst and latencyMedianMillis must be positive.\n");
+        return 2;
+    }
+
+    try {
+
+        Fleet fleet(static_cast<uint64_t>(option("seed")), std::move(outages));
+
+        fleet.run();
+        fleet.report();
+
+    } catch (const std::exception& ex) {
+        std::fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+
+    return 0;
+}
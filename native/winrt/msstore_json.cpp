@@ -0,0 +1,355 @@
+#include "msstore_json.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+  #include <emmintrin.h>
+  #define MSSTORE_JSON_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+
+static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+#ifdef MSSTORE_JSON_SSE2
+
+/* Returns the index of the lowest set bit of a non-zero mask. */
+static unsigned lowest_bit_index(unsigned mask) {
+
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#endif
+
+/*
+ * Returns the position of the next '"' or '\' at or after pos, or size.
+ *
+ * This is the hot loop when skipping long string values, so it compares 16
+ * bytes at a time where SSE2 is available.
+ */
+static size_t find_string_special(const char* data, size_t pos, size_t size) {
+
+#ifdef MSSTORE_JSON_SSE2
+
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    while (pos + 16 <= size) {
+
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(chunk, quote),
+            _mm_cmpeq_epi8(chunk, backslash)
+        )));
+
+        if (mask != 0)
+            return pos + lowest_bit_index(mask);
+
+        pos += 16;
+    }
+
+#endif
+
+    while (pos < size && data[pos] != '"' && data[pos] != '\\')
+        pos++;
+
+    return pos;
+}
+
+/*
+ * Returns the position of the next structural character ('"', '{', '}',
+ * '[' or ']') at or after pos, or size.
+ *
+ * Used to skip whole objects and arrays without looking at their members.
+ */
+static size_t find_structural(const char* data, size_t pos, size_t size) {
+
+#ifdef MSSTORE_JSON_SSE2
+
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i openBracket = _mm_set1_epi8('[');
+    const __m128i closeBracket = _mm_set1_epi8(']');
+
+    while (pos + 16 <= size) {
+
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+
+        const __m128i matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, openBrace)),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, closeBrace), _mm_cmpeq_epi8(chunk, openBracket)),
+                _mm_cmpeq_epi8(chunk, closeBracket)
+            )
+        );
+
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+
+        if (mask != 0)
+            return pos + lowest_bit_index(mask);
+
+        pos += 16;
+    }
+
+#endif
+
+    while (pos < size) {
+
+        const char c = data[pos];
+
+        if (c == '"' || c == '{' || c == '}' || c == '[' || c == ']')
+            break;
+
+        pos++;
+    }
+
+    return pos;
+}
+
+static size_t skip_whitespace(const char* data, size_t pos, size_t size) {
+
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '\t'))
+        pos++;
+
+    return pos;
+}
+
+/* Skips a string starting at its opening quote. Returns the position after the closing quote. */
+static size_t skip_string(const char* data, size_t pos, size_t size) {
+
+    /* Opening quote */
+    pos++;
+
+    for (;;) {
+
+        pos = find_string_special(data, pos, size);
+
+        if (pos >= size)
+            return NOT_FOUND;
+
+        if (data[pos] == '"')
+            return pos + 1;
+
+        /* Backslash: skip it and the escaped character. */
+        pos += 2;
+    }
+}
+
+/* Skips an object or array starting at its opening bracket. */
+static size_t skip_container(const char* data, size_t pos, size_t size) {
+
+    size_t depth = 0;
+
+    for (;;) {
+
+        pos = find_structural(data, pos, size);
+
+        if (pos >= size)
+            return NOT_FOUND;
+
+        const char c = data[pos];
+
+        if (c == '"') {
+
+            pos = skip_string(data, pos, size);
+
+            if (pos == NOT_FOUND)
+                return NOT_FOUND;
+
+            continue;
+        }
+
+        if (c == '{' || c == '[')
+            depth++;
+        else
+            depth--;
+
+        pos++;
+
+        if (depth == 0)
+            return pos;
+    }
+}
+
+/* Skips a number or a literal (true, false, null). */
+static size_t skip_scalar(const char* data, size_t pos, size_t size) {
+
+    while (pos < size) {
+
+        const char c = data[pos];
+
+        if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t')
+            break;
+
+        pos++;
+    }
+
+    return pos;
+}
+
+/* Skips any value starting at pos. Returns the position after it. */
+static size_t skip_value(const char* data, size_t pos, size_t size) {
+
+    if (pos >= size)
+        return NOT_FOUND;
+
+    switch (data[pos]) {
+        case '"':
+            return skip_string(data, pos, size);
+        case '{':
+        case '[':
+            return skip_container(data, pos, size);
+        case ',':
+        case '}':
+        case ']':
+        case ':':
+            return NOT_FOUND;
+        default:
+            return skip_scalar(data, pos, size);
+    }
+}
+
+/* Returns the start of the value of member key in the object at pos. */
+static size_t find_object_member(const char* data, size_t pos, size_t size, std::string_view key) {
+
+    if (pos >= size || data[pos] != '{')
+        return NOT_FOUND;
+
+    pos = skip_whitespace(data, pos + 1, size);
+
+    if (pos < size && data[pos] == '}')
+        return NOT_FOUND;
+
+    for (;;) {
+
+        if (pos >= size || data[pos] != '"')
+            return NOT_FOUND;
+
+        const size_t keyEnd = skip_string(data, pos, size);
+
+        if (keyEnd == NOT_FOUND)
+            return NOT_FOUND;
+
+        const std::string_view memberKey(data + pos + 1, keyEnd - pos - 2);
+
+        pos = skip_whitespace(data, keyEnd, size);
+
+        if (pos >= size || data[pos] != ':')
+            return NOT_FOUND;
+
+        pos = skip_whitespace(data, pos + 1, size);
+
+        if (memberKey == key)
+            return pos;
+
+        pos = skip_value(data, pos, size);
+
+        if (pos == NOT_FOUND)
+            return NOT_FOUND;
+
+        pos = skip_whitespace(data, pos, size);
+
+        if (pos >= size || data[pos] != ',')
+            return NOT_FOUND;
+
+        pos = skip_whitespace(data, pos + 1, size);
+    }
+}
+
+/* Returns the start of element index of the array at pos. */
+static size_t find_array_element(const char* data, size_t pos, size_t size, size_t index) {
+
+    if (pos >= size || data[pos] != '[')
+        return NOT_FOUND;
+
+    pos = skip_whitespace(data, pos + 1, size);
+
+    if (pos < size && data[pos] == ']')
+        return NOT_FOUND;
+
+    for (size_t current = 0;; current++) {
+
+        if (current == index)
+            return pos;
+
+        pos = skip_value(data, pos, size);
+
+        if (pos == NOT_FOUND)
+            return NOT_FOUND;
+
+        pos = skip_whitespace(data, pos, size);
+
+        if (pos >= size || data[pos] != ',')
+            return NOT_FOUND;
+
+        pos = skip_whitespace(data, pos + 1, size);
+    }
+}
+
+bool json_find_path(std::string_view json, std::string_view path, std::string_view& value) {
+
+    const char* data = json.data();
+    const size_t size = json.size();
+
+    size_t pos = skip_whitespace(data, 0, size);
+    size_t pathPos = 0;
+
+    while (pathPos < path.size()) {
+
+        if (path[pathPos] == '[') {
+
+            size_t index = 0;
+            size_t digits = 0;
+
+            pathPos++;
+
+            while (pathPos < path.size() && path[pathPos] >= '0' && path[pathPos] <= '9') {
+                index = index * 10 + static_cast<size_t>(path[pathPos] - '0');
+                digits++;
+                pathPos++;
+            }
+
+            if (digits == 0 || pathPos >= path.size() || path[pathPos] != ']')
+                return false;
+
+            pathPos++;
+
+            pos = find_array_element(data, pos, size, index);
+
+        } else {
+
+            const size_t keyStart = pathPos;
+
+            while (pathPos < path.size() && path[pathPos] != '.' && path[pathPos] != '[')
+                pathPos++;
+
+            pos = find_object_member(data, pos, size, path.substr(keyStart, pathPos - keyStart));
+        }
+
+        if (pos == NOT_FOUND)
+            return false;
+
+        if (pathPos < path.size() && path[pathPos] == '.')
+            pathPos++;
+    }
+
+    const size_t end = skip_value(data, pos, size);
+
+    if (end == NOT_FOUND || end == pos)
+        return false;
+
+    value = json.substr(pos, end - pos);
+
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string_view>
+
+/*
+ * On-demand JSON field lookup over ExtendedJsonData.
+ *
+ * The scanner never allocates and never builds a document tree. It walks the
+ * text once, skipping everything that is not on the requested path, and
+ * returns a view into the original buffer.
+ *
+ * Path syntax: object keys separated by dots, array elements as [index].
+ * Examples: "productId", "skuItems[0].skuId", "[2]". Keys are compared with
+ * the raw (still escaped) key text and may not contain '.' or '['.
+ */
+
+/*
+ * Finds the value at path inside json.
+ *
+ * On success returns true and sets value to the raw JSON text of the value
+ * (strings keep their quotes and escapes). Returns false if the path does
+ * not exist or the document is malformed along the way.
+ */
+bool json_find_path(std::string_view json, std::string_view path, std::string_view& value);
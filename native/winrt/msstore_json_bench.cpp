@@ -0,0 +1,127 @@
+#include "msstore_json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+/*
+ * Benchmark of the on-demand JSON field lookup.
+ *
+ *   msstore_json_bench <file> <path> [<path> ...] [iterations=<n>] [padding=<bytes>]
+ *
+ * Looks up every path in the JSON document of file, iterations times each,
+ * and prints the time per lookup and the scan rate as name=value lines.
+ * padding=<bytes> adds a member of that size in front of the document's
+ * first member, so the cost of skipping large unrelated values shows.
+ * The samples in testdata/extended_json are a starting point.
+ *
+ * Portable C++20 without WinRT, built with MSSTORE_WINRT_TESTS (see
+ * CMakeLists.txt). Not run by ctest; build with CMAKE_BUILD_TYPE=Release.
+ */
+
+static bool read_file(const char* path, std::string& content) {
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file)
+        return false;
+
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    return true;
+}
+
+/* Inserts a string member of padding bytes after the opening brace. */
+static bool pad_document(std::string& json, long padding) {
+
+    const size_t brace = json.find('{');
+
+    if (brace == std::string::npos)
+        return false;
+
+    json.insert(brace + 1, "\"padding\": \"" + std::string(static_cast<size_t>(padding), 'x') + "\", ");
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: msstore_json_bench <file> <path> [<path> ...] [iterations=<n>] [padding=<bytes>]\n");
+        return 2;
+    }
+
+    long iterations = 1000000;
+    long padding = 0;
+
+    std::string json;
+
+    if (!read_file(argv[1], json)) {
+        std::fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    for (int index = 2; index < argc; ++index) {
+
+        const std::string_view argument = argv[index];
+
+        if (argument.rfind("iterations=", 0) == 0)
+            iterations = std::strtol(argv[index] + 11, nullptr, 10);
+        else if (argument.rfind("padding=", 0) == 0)
+            padding = std::strtol(argv[index] + 8, nullptr, 10);
+    }
+
+    if (iterations <= 0 || padding < 0) {
+        std::fprintf(stderr, "iterations must be positive and padding not negative.\n");
+        return 2;
+    }
+
+    if (padding > 0 && !pad_document(json, padding)) {
+        std::fprintf(stderr, "Cannot pad a document without an object.\n");
+        return 2;
+    }
+
+    std::printf("file=%s\n", argv[1]);
+    std::printf("documentBytes=%zu\n", json.size());
+    std::printf("iterations=%ld\n", iterations);
+
+    for (int index = 2; index < argc; ++index) {
+
+        const std::string_view path = argv[index];
+
+        if (path.find('=') != std::string_view::npos)
+            continue;
+
+        std::string_view value;
+        size_t scanned = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (long iteration = 0; iteration < iterations; ++iteration) {
+
+            if (!json_find_path(json, path, value))
+                break;
+
+            /* Keeps the lookup from being optimized away. */
+            scanned += static_cast<size_t>(value.data() + value.size() - json.data());
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (scanned == 0) {
+            std::printf("path=%s found=false\n", argv[index]);
+            continue;
+        }
+
+        std::printf("path=%s found=true nanosPerLookup=%.1f scannedMBps=%.1f\n",
+            argv[index],
+            seconds * 1e9 / static_cast<double>(iterations),
+            static_cast<double>(scanned) / seconds / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "msstore_json.h"
+#include "msstore_test.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+/*
+ * Tests of the on-demand JSON field lookup.
+ *
+ * The first argument is the directory of the ExtendedJsonData samples in
+ * testdata/extended_json; CMakeLists.txt passes it to ctest.
+ *
+ * Portable C++20 without WinRT, built with MSSTORE_WINRT_TESTS (see
+ * CMakeLists.txt) and run by ctest.
+ */
+
+static std::string g_corpusDirectory;
+
+/* Returns the value at path, or "<missing>" if there is none. */
+static std::string find(std::string_view json, std::string_view path) {
+
+    std::string_view value;
+
+    if (!json_find_path(json, path, value))
+        return "<missing>";
+
+    return std::string(value);
+}
+
+static std::string read_sample(const char* fileName) {
+
+    std::ifstream file(g_corpusDirectory + "/" + fileName, std::ios::binary);
+
+    if (!file) {
+        std::fprintf(stderr, "Cannot read sample %s\n", fileName);
+        g_testFailures++;
+        return {};
+    }
+
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void test_finds_members_and_elements() {
+
+    const std::string_view json = R"( {"a": 1, "b": {"c": [10, {"d": "x"}, [true, null]]}, "e": -2.5e3 } )";
+
+    CHECK(find(json, "a") == "1");
+    CHECK(find(json, "b.c[0]") == "10");
+    CHECK(find(json, "b.c[1].d") == "\"x\"");
+    CHECK(find(json, "b.c[2][1]") == "null");
+    CHECK(find(json, "b.c[2]") == "[true, null]");
+    CHECK(find(json, "e") == "-2.5e3");
+    CHECK(find(json, "") == "{\"a\": 1, \"b\": {\"c\": [10, {\"d\": \"x\"}, [true, null]]}, \"e\": -2.5e3 }");
+    CHECK(find("[1, [2, 3]]", "[1][0]") == "2");
+}
+
+static void test_missing_paths() {
+
+    const std::string_view json = R"({"a": {"b": [1, 2]}, "empty": {}, "none": []})";
+
+    CHECK(find(json, "x") == "<missing>");
+    CHECK(find(json, "a.x") == "<missing>");
+    CHECK(find(json, "a.b[2]") == "<missing>");
+    CHECK(find(json, "a[0]") == "<missing>");
+    CHECK(find(json, "a.b.c") == "<missing>");
+    CHECK(find(json, "empty.a") == "<missing>");
+    CHECK(find(json, "none[0]") == "<missing>");
+
+    /* Malformed paths */
+    CHECK(find(json, "a.b[") == "<missing>");
+    CHECK(find(json, "a.b[x]") == "<missing>");
+    CHECK(find(json, "a.b[]") == "<missing>");
+}
+
+static void test_malformed_documents() {
+
+    CHECK(find("", "a") == "<missing>");
+    CHECK(find("{", "a") == "<missing>");
+    CHECK(find(R"({"a" 1})", "a") == "<missing>");
+    CHECK(find(R"({"a": "open)", "a") == "<missing>");
+    CHECK(find(R"({"a": [1, 2)", "a") == "<missing>");
+    CHECK(find(R"({"a": 1 "b": 2})", "b") == "<missing>");
+
+    /* Only the path is scanned: damage after the value is not noticed. */
+    CHECK(find(R"({"a": 1, "b": )", "a") == "1");
+}
+
+static void test_strings_with_escapes_and_brackets() {
+
+    const std::string_view json = R"({"a": "say \"hi\" {[", "b\"c": 2, "d": ["]}", "\\"], "e": 3})";
+
+    CHECK(find(json, "a") == R"("say \"hi\" {[")");
+
+    /* Keys are compared with their raw text. */
+    CHECK(find(json, "b\\\"c") == "2");
+    CHECK(find(json, "d[1]") == R"("\\")");
+    CHECK(find(json, "e") == "3");
+}
+
+static void test_every_chunk_boundary() {
+
+    /*
+     * Moves the closing quote, an escape and a bracket across all positions
+     * of the 16-byte chunks, so both the SSE2 loop and the tail are used.
+     */
+    for (size_t length = 0; length < 48; ++length) {
+
+        const std::string filler(length, 'x');
+
+        const std::string json = "{\"s\": \"" + filler + "\\\"" + filler + "\", \"o\": {\"t\": \"" +
+            filler + "]\"}, \"n\": " + std::to_string(length) + "}";
+
+        CHECK(find(json, "s") == "\"" + filler + "\\\"" + filler + "\"");
+        CHECK(find(json, "o.t") == "\"" + filler + "]\"");
+        CHECK(find(json, "n") == std::to_string(length));
+    }
+}
+
+static void test_app_license_sample() {
+
+    const std::string json = read_sample("app_license.json");
+
+    CHECK(find(json, "productId") == "\"9NBLGGH4R315\"");
+    CHECK(find(json, "skuItems[0].skuId") == "\"0010\"");
+    CHECK(find(json, "skuItems[0].collectionData.quantity") == "1");
+    CHECK(find(json, "skuItems[0].collectionData.tags[1]") == R"("bundle \"spring\"")");
+    CHECK(find(json, "skuItems[0].collectionData.tags[2]") == R"("C:\\Tools\\app")");
+    CHECK(find(json, "skuItems[1].collectionData") == "{}");
+    CHECK(find(json, "skuItems[2]") == "<missing>");
+    CHECK(find(json, "productAddOns[0].title") == R"("Pro features \u2013 lifetime")");
+    CHECK(find(json, "productAddOns[1].skuId") == "\"0010\"");
+    CHECK(find(json, "satisfactionInfo.isSatisfied") == "true");
+    CHECK(find(json, "inAppOfferToken") == "null");
+}
+
+static void test_add_on_license_sample() {
+
+    const std::string json = read_sample("add_on_license.json");
+
+    CHECK(find(json, "inAppOfferToken") == "\"pro_lifetime\"");
+    CHECK(find(json, "skuItems[0].collectionData.devOfferId") == "\"pro_lifetime\"");
+    CHECK(find(json, "satisfactionInfo") == R"({"satisfiedByEntitlement":true,"isSatisfied":true})");
+}
+
+static void test_subscription_license_sample() {
+
+    const std::string json = read_sample("subscription_license.json");
+
+    CHECK(find(json, "skuItems[0].recurrenceData.billingPeriodUnit") == "\"Month\"");
+    CHECK(find(json, "skuItems[0].recurrenceData.renewalHistory[1].amount") == "4.99e0");
+    CHECK(find(json, "skuItems[0].recurrenceData.renewalHistory[2].amount") == "-0.5E+1");
+    CHECK(find(json, "skuItems[0].recurrenceData.renewalHistory[2].note") == R"("refund \\ credit \/ adjusted")");
+    CHECK(find(json, "skuItems[0].recurrenceData.renewalHistory[3]") == "<missing>");
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: msstore_json_test <testdata/extended_json directory>\n");
+        return 2;
+    }
+
+    g_corpusDirectory = argv[1];
+
+    test_finds_members_and_elements();
+    test_missing_paths();
+    test_malformed_documents();
+    test_strings_with_escapes_and_brackets();
+    test_every_chunk_boundary();
+    test_app_license_sample();
+    test_add_on_license_sample();
+    test_subscription_license_sample();
+
+    return test_result("msstore_json_test");
+}
@@ -0,0 +1,414 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+/*
+ * Memory-mapped purchase attempt log.
+ *
+ * The log is a file with a header and a fixed number of slots that stays
+ * mapped while the log is open. Appending claims the next sequence number
+ * with one interlocked increment and copies the record into its slot, so
+ * the purchase path only writes memory. The operating system writes the
+ * dirty pages back to the file on its own schedule.
+ *
+ * Each slot carries the sequence of its record, used like the broker's
+ * seqlock: 0 while the record is written, the record's sequence after.
+ * Readers skip slots that changed while they copied them.
+ *
+ * A process that dies between claiming a sequence and writing its slot
+ * leaves the slot behind without that sequence. Opening the log again marks
+ * such slots as abandoned (the negated sequence), so readers skip them
+ * instead of waiting for a write that never comes.
+ */
+
+static constexpr uint32_t PURCHASE_LOG_MAGIC = 0x4C50534D; /* "MSPL" */
+static constexpr uint32_t PURCHASE_LOG_LAYOUT_VERSION = 1;
+static constexpr int PURCHASE_LOG_MAX_CAPACITY = 4 * 1024 * 1024;
+
+struct PurchaseLogHeader {
+    uint32_t magic;
+    uint32_t layoutVersion;
+    uint32_t recordSize;
+    uint32_t capacity;
+    volatile LONG64 nextSequence;
+};
+
+struct PurchaseLogSlot {
+    volatile LONG64 sequence;
+    MsStorePurchaseAttemptNative record;
+};
+
+/* An open purchase log. Unmapped when the last user lets go of it. */
+struct PurchaseLogMapping {
+
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    PurchaseLogHeader* header = nullptr;
+    uint32_t capacity = 0;
+    int64_t abandoned = 0;
+    std::string path;
+
+    PurchaseLogMapping() = default;
+    PurchaseLogMapping(const PurchaseLogMapping&) = delete;
+    PurchaseLogMapping& operator=(const PurchaseLogMapping&) = delete;
+
+    ~PurchaseLogMapping() {
+
+        if (header != nullptr)
+            ::UnmapViewOfFile(header);
+
+        if (mapping != nullptr)
+            ::CloseHandle(mapping);
+
+        if (file != INVALID_HANDLE_VALUE)
+            ::CloseHandle(file);
+    }
+
+    PurchaseLogSlot& slot(LONG64 sequence) const {
+        return reinterpret_cast<PurchaseLogSlot*>(header + 1)[static_cast<uint64_t>(sequence - 1) % capacity];
+    }
+};
+
+/*
+ * Purchase log state of this process. Guarded by g_purchaseLogMutex, which
+ * is only held to copy the pointer and update the retry counts.
+ *
+ * g_purchaseRetries counts the attempts per Store ID since its last
+ * successful one.
+ */
+static std::mutex g_purchaseLogMutex;
+static std::shared_ptr<PurchaseLogMapping> g_purchaseLog;
+static std::unordered_map<std::string, int> g_purchaseRetries;
+
+/* Writes the mapped pages to disk and waits for it. Not for the purchase path. */
+static void flush_purchase_log(const PurchaseLogMapping& log) {
+
+    ::FlushViewOfFile(log.header, 0);
+    ::FlushFileBuffers(log.file);
+}
+
+/*
+ * Marks the slots that a dead writer claimed but never finished.
+ *
+ * Only called while opening: this process is the only writer of the file,
+ * so every claimed slot that does not carry its sequence yet stays so.
+ * Returns the number of slots marked.
+ */
+static int64_t repair_purchase_log(const PurchaseLogMapping& log) {
+
+    const LONG64 newest = log.header->nextSequence;
+
+    int64_t abandoned = 0;
+
+    for (LONG64 sequence = std::max<LONG64>(0, newest - log.capacity) + 1; sequence <= newest; ++sequence) {
+
+        PurchaseLogSlot& slot = log.slot(sequence);
+
+        if (slot.sequence == sequence || slot.sequence == -sequence)
+            continue;
+
+        slot.sequence = -sequence;
+
+        ++abandoned;
+    }
+
+    return abandoned;
+}
+
+static void append_purchase_attempt(const PurchaseLogMapping& log, MsStorePurchaseAttemptNative& record) {
+
+    const LONG64 sequence = ::InterlockedIncrement64(&log.header->nextSequence);
+
+    PurchaseLogSlot& slot = log.slot(sequence);
+
+    record.Sequence = sequence;
+
+    /* 0: write in progress. Interlocked operations are full barriers. */
+    ::InterlockedExchange64(&slot.sequence, 0);
+
+    std::memcpy(&slot.record, &record, sizeof(record));
+
+    ::InterlockedExchange64(&slot.sequence, sequence);
+}
+
+void log_purchase_attempt(
+    const char* storeId,
+    int64_t dialogOpenedAt,
+    int64_t dialogClosedAt,
+    int status,
+    int32_t hresult,
+    bool shortCircuited,
+    bool forUser
+) {
+
+    std::shared_ptr<PurchaseLogMapping> log;
+    int retryCount = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(g_purchaseLogMutex);
+
+        if (g_purchaseLog == nullptr)
+            return;
+
+        log = g_purchaseLog;
+
+        auto retries = g_purchaseRetries.try_emplace(storeId, 0).first;
+
+        retryCount = retries->second;
+
+        /* Succeeded and AlreadyPurchased end a series of attempts. */
+        if (status == 0 || status == 1)
+            g_purchaseRetries.erase(retries);
+        else
+            ++retries->second;
+    }
+
+    MsStorePurchaseAttemptNative record {};
+    record.DialogOpenedAt = dialogOpenedAt;
+    record.DialogClosedAt = dialogClosedAt;
+    record.Status = status;
+    record.HResult = hresult;
+    record.RetryCount = retryCount;
+    record.ShortCircuited = shortCircuited;
+    record.ForUser = forUser;
+
+    const size_t storeIdLength = std::min(std::strlen(storeId), sizeof(record.StoreId) - 1);
+    std::memcpy(record.StoreId, storeId, storeIdLength);
+
+    append_purchase_attempt(*log, record);
+}
+
+/*
+ * Opens (or creates) the purchase log at path.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_purchase_log_open(const char* path, int capacity) {
+
+    try {
+
+        if (path == nullptr || *path == '\0') {
+            g_lastError = "Purchase log path is null or empty.";
+            return -1;
+        }
+
+        if (capacity <= 0 || capacity > PURCHASE_LOG_MAX_CAPACITY) {
+            g_lastError = "Purchase log capacity must be between 1 and " +
+                std::to_string(PURCHASE_LOG_MAX_CAPACITY) + ".";
+            return -1;
+        }
+
+        const uint64_t fileSize = sizeof(PurchaseLogHeader) +
+            static_cast<uint64_t>(capacity) * sizeof(PurchaseLogSlot);
+
+        auto log = std::make_shared<PurchaseLogMapping>();
+        log->capacity = static_cast<uint32_t>(capacity);
+        log->path = path;
+
+        const std::wstring widePath = winrt::to_hstring(std::string_view(path)).c_str();
+
+        /* Others may read the file, but this process is the only writer. */
+        log->file = ::CreateFileW(
+            widePath.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+
+        if (log->file == INVALID_HANDLE_VALUE) {
+            g_lastError = "Could not open the purchase log file.";
+            return -1;
+        }
+
+        LARGE_INTEGER existingSize {};
+
+        if (!::GetFileSizeEx(log->file, &existingSize)) {
+            g_lastError = "Could not read the purchase log file size.";
+            return -1;
+        }
+
+        if (existingSize.QuadPart != 0 && static_cast<uint64_t>(existingSize.QuadPart) != fileSize) {
+            g_lastError = "Purchase log file exists with a different capacity.";
+            return -1;
+        }
+
+        /* Mapping an empty file with a size grows it, zero-filled. */
+        log->mapping = ::CreateFileMappingW(
+            log->file,
+            nullptr,
+            PAGE_READWRITE,
+            static_cast<DWORD>(fileSize >> 32),
+            static_cast<DWORD>(fileSize & 0xFFFFFFFF),
+            nullptr
+        );
+
+        if (log->mapping == nullptr) {
+            g_lastError = "Could not map the purchase log file.";
+            return -1;
+        }
+
+        log->header = static_cast<PurchaseLogHeader*>(::MapViewOfFile(
+            log->mapping,
+            FILE_MAP_WRITE,
+            0,
+            0,
+            static_cast<SIZE_T>(fileSize)
+        ));
+
+        if (log->header == nullptr) {
+            g_lastError = "Could not map the purchase log file.";
+            return -1;
+        }
+
+        if (log->header->magic == 0) {
+
+            log->header->layoutVersion = PURCHASE_LOG_LAYOUT_VERSION;
+            log->header->recordSize = sizeof(MsStorePurchaseAttemptNative);
+            log->header->capacity = log->capacity;
+            log->header->magic = PURCHASE_LOG_MAGIC;
+
+        } else if (log->header->magic != PURCHASE_LOG_MAGIC ||
+                   log->header->layoutVersion != PURCHASE_LOG_LAYOUT_VERSION ||
+                   log->header->recordSize != sizeof(MsStorePurchaseAttemptNative) ||
+                   log->header->capacity != log->capacity) {
+
+            g_lastError = "File is not a purchase log of this version and capacity.";
+            return -1;
+        }
+
+        log->abandoned = repair_purchase_log(*log);
+
+        std::shared_ptr<PurchaseLogMapping> previous;
+
+        {
+            std::lock_guard<std::mutex> lock(g_purchaseLogMutex);
+
+            previous = std::exchange(g_purchaseLog, std::move(log));
+        }
+
+        if (previous != nullptr)
+            flush_purchase_log(*previous);
+
+        g_lastError.clear();
+
+        return 0;
+
+    } catch (const winrt::hresult_error& ex) {
+        g_lastError = winrt::to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return -1;
+}
+
+/*
+ * Flushes and closes the purchase log.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_purchase_log_close() {
+
+    std::shared_ptr<PurchaseLogMapping> log;
+
+    {
+        std::lock_guard<std::mutex> lock(g_purchaseLogMutex);
+
+        log = std::exchange(g_purchaseLog, nullptr);
+    }
+
+    /* An append still running keeps the mapping alive until it is done. */
+    if (log != nullptr)
+        flush_purchase_log(*log);
+}
+
+/*
+ * Copies purchase attempts newer than sinceSequence, oldest first.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_purchase_log_read(
+    int64_t sinceSequence,
+    MsStorePurchaseAttemptNative* buffer,
+    int capacity
+) {
+
+    std::shared_ptr<PurchaseLogMapping> log;
+
+    {
+        std::lock_guard<std::mutex> lock(g_purchaseLogMutex);
+
+        log = g_purchaseLog;
+    }
+
+    if (log == nullptr) {
+        g_lastError = "Purchase log is not open.";
+        return -1;
+    }
+
+    if (buffer == nullptr || capacity <= 0)
+        return 0;
+
+    const LONG64 newest = ::InterlockedCompareExchange64(&log->header->nextSequence, 0, 0);
+
+    /* Sequences older than one capacity have been overwritten. */
+    LONG64 sequence = std::max<LONG64>(sinceSequence, newest - log->capacity) + 1;
+
+    int count = 0;
+
+    for (; sequence <= newest && count < capacity; ++sequence) {
+
+        PurchaseLogSlot& slot = log->slot(sequence);
+
+        const LONG64 before = ::InterlockedCompareExchange64(&slot.sequence, 0, 0);
+
+        /* Abandoned by a writer that died, see repair_purchase_log(). */
+        if (before == -sequence)
+            continue;
+
+        /* Claimed but not written yet: stop, the next read continues here. */
+        if (before < sequence)
+            break;
+
+        /* Overwritten by a newer record meanwhile. */
+        if (before > sequence)
+            continue;
+
+        std::memcpy(&buffer[count], &slot.record, sizeof(MsStorePurchaseAttemptNative));
+
+        if (::InterlockedCompareExchange64(&slot.sequence, 0, 0) == before)
+            ++count;
+    }
+
+    g_lastError.clear();
+
+    return count;
+}
+
+void dump_purchase_log_state(DiagnosticsWriter& writer) {
+
+    std::lock_guard<std::mutex> lock(g_purchaseLogMutex);
+
+    writer.begin_object("purchaseLog");
+    writer.add_bool("open", g_purchaseLog != nullptr);
+
+    if (g_purchaseLog != nullptr) {
+        writer.add_string("path", g_purchaseLog->path);
+        writer.add_number("capacity", static_cast<int64_t>(g_purchaseLog->capacity));
+        writer.add_number("appended", static_cast<int64_t>(g_purchaseLog->header->nextSequence));
+        writer.add_number("abandoned", g_purchaseLog->abandoned);
+    }
+
+    writer.add_number("retryingStoreIds", static_cast<int64_t>(g_purchaseRetries.size()));
+    writer.end_object();
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "msstore_snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/*
+ * Scheduling policy of the background license refresher.
+ *
+ * Decides how long to wait until the next license refresh from what the
+ * refresher observed so far. Pure functions without WinRT dependency, so the
+ * policy can be evaluated offline against simulated clients.
+ *
+ * The delay adapts to:
+ * - the next expiration: refresh shortly after a trial or subscription ends,
+ *   when the Store reports the renewal,
+ * - recent changes: a license that just changed tends to change again (a
+ *   purchase is often followed by more), so refresh more often for a while,
+ * - errors: back off exponentially from the minimum interval.
+ *
+ * Every delay is spread by a jitter that is deterministic per install: the
+ * same install always gets the same sequence, different installs get
+ * different ones, so a fleet started at the same time drifts apart instead
+ * of refreshing in lockstep.
+ */
+
+/* Time after an expiration before the refresh, for the Store to process a renewal. */
+static constexpr int64_t REFRESH_EXPIRATION_GRACE_MILLIS = 5 * 60 * 1000;
+
+/* Expirations beyond this are "never"; the Store reports perpetual licenses as year 9999. */
+static constexpr int64_t REFRESH_EXPIRATION_HORIZON_MILLIS = 365LL * 24 * 60 * 60 * 1000;
+
+/* Delays vary by up to this percentage in both directions. */
+static constexpr int REFRESH_JITTER_PERCENT = 10;
+
+struct RefreshPolicy {
+
+    /* Delay while nothing changes or fails. */
+    int64_t intervalMillis = 0;
+
+    /* Lower bound of every delay. */
+    int64_t minIntervalMillis = 0;
+
+    /* Upper bound of the error backoff. */
+    int64_t maxIntervalMillis = 0;
+};
+
+/* What the refresher knows when scheduling the next refresh. */
+struct RefreshObservation {
+
+    int64_t now = 0;
+
+    /* Earliest upcoming expiration, see next_expiration_at(); 0 if none. */
+    int64_t nextExpirationAt = 0;
+
+    /* Decayed count of recent changes, see decay_change_score(). */
+    double changeScore = 0;
+
+    int consecutiveFailures = 0;
+
+    /* Per-install seed and the number of refreshes scheduled so far. */
+    uint64_t jitterSeed = 0;
+    uint64_t round = 0;
+};
+
+/* Returns whether the bounds of policy are usable. */
+inline bool is_valid_refresh_policy(const RefreshPolicy& policy) {
+
+    return policy.minIntervalMillis > 0 &&
+        policy.minIntervalMillis <= policy.intervalMillis &&
+        policy.intervalMillis <= policy.maxIntervalMillis;
+}
+
+/* splitmix64: well-mixed 64 bits from any seed, so consecutive rounds look unrelated. */
+inline uint64_t refresh_jitter_hash(uint64_t seed, uint64_t round) {
+
+    uint64_t value = seed + (round + 1) * 0x9E3779B97F4A7C15ULL;
+
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+
+    return value ^ (value >> 31);
+}
+
+/* Uniform value in [0, 1) for seed and round. */
+inline double refresh_jitter_fraction(uint64_t seed, uint64_t round) {
+    return static_cast<double>(refresh_jitter_hash(seed, round) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Halves the score and adds 1 for a change; stays below 2. */
+inline double decay_change_score(double score, bool changed) {
+    return score * 0.5 + (changed ? 1.0 : 0.0);
+}
+
+/*
+ * Returns the earliest expiration of the app or an add-on after now, or 0
+ * if nothing expires within REFRESH_EXPIRATION_HORIZON_MILLIS.
+ */
+inline int64_t next_expiration_at(const LicenseSnapshot& snapshot, int64_t now) {
+
+    const int64_t horizon = now + REFRESH_EXPIRATION_HORIZON_MILLIS;
+
+    int64_t next = 0;
+
+    auto consider = [&](int64_t expirationDate) {
+        if (expirationDate > now && expirationDate < horizon && (next == 0 || expirationDate < next))
+            next = expirationDate;
+    };
+
+    consider(snapshot.expirationDate);
+
+    for (const AddOnSnapshot& addOn : snapshot.addOns)
+        consider(addOn.expirationDate);
+
+    return next;
+}
+
+/*
+ * Delay before the first refresh after starting: a per-install fraction of
+ * the interval, so clients launched together don't refresh together.
+ */
+inline int64_t initial_refresh_delay_millis(const RefreshPolicy& policy, uint64_t jitterSeed) {
+
+    const double fraction = refresh_jitter_fraction(jitterSeed, UINT64_MAX);
+
+    return std::max(policy.minIntervalMillis, static_cast<int64_t>(policy.intervalMillis * fraction));
+}
+
+/* Delay until the next refresh. */
+inline int64_t refresh_delay_millis(const RefreshPolicy& policy, const RefreshObservation& observation) {
+
+    const double fraction = refresh_jitter_fraction(observation.jitterSeed, observation.round);
+
+    const double jitter = 1.0 + (fraction * 2.0 - 1.0) * (REFRESH_JITTER_PERCENT / 100.0);
+
+    double delay;
+
+    if (observation.consecutiveFailures > 0) {
+
+        const int doublings = std::min(observation.consecutiveFailures - 1, 30);
+
+        delay = std::min(
+            static_cast<double>(policy.maxIntervalMillis),
+            static_cast<double>(policy.minIntervalMillis) * static_cast<double>(1LL << doublings)
+        ) * jitter;
+
+    } else {
+
+        /* Up to three times as often right after changes. */
+        delay = policy.intervalMillis / (1.0 + observation.changeScore) * jitter;
+
+        /* Never before the expiration: spread over one to two grace periods after it. */
+        if (observation.nextExpirationAt > observation.now) {
+
+            const double untilExpiration = static_cast<double>(observation.nextExpirationAt - observation.now) +
+                REFRESH_EXPIRATION_GRACE_MILLIS * (1.0 + fraction);
+
+            delay = std::min(delay, untilExpiration);
+        }
+    }
+
+    return std::clamp(static_cast<int64_t>(delay), policy.minIntervalMillis, policy.maxIntervalMillis);
+}
@@ -0,0 +1,241 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+#include "msstore_dispatcher.h"
+#include "msstore_refresh_policy.h"
+
+#include <windows.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+/*
+ * Background license refresher.
+ *
+ * Keeps the default user's license snapshot fresh for the cached read path
+ * (msstore_winrt_get_cached_license) on the schedule of
+ * msstore_refresh_policy.h. Refreshes go through the engine, so they join
+ * queries that are already in flight, and ticks are skipped if another
+ * caller refreshed within the minimum interval.
+ *
+ * All state is guarded by g_refresherMutex, which is never held across a
+ * Store call. Like the update checker, every scheduled tick carries the
+ * epoch it was started with, so ticks of a stopped or restarted refresher
+ * end themselves.
+ */
+static std::mutex g_refresherMutex;
+static bool g_refresherRunning = false;
+static uint64_t g_refresherEpoch = 0;
+static RefreshPolicy g_refreshPolicy;
+static RefreshObservation g_refreshObservation;
+static int64_t g_lastRefreshGeneration = 0;
+static int64_t g_nextRefreshAt = 0;
+static uint64_t g_refresherQueries = 0;
+static uint64_t g_refresherSkips = 0;
+
+static uint64_t fnv1a(uint64_t hash, const std::wstring& value) {
+
+    for (wchar_t character : value) {
+        hash ^= static_cast<uint16_t>(character);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * Jitter seed of this install: the machine GUID and the user name, both
+ * stable across restarts. Falls back to the process start if neither can
+ * be read, which still spreads a fleet, just not deterministically.
+ */
+static uint64_t derive_jitter_seed() {
+
+    uint64_t seed = 14695981039346656037ULL;
+    bool stable = false;
+
+    wchar_t machineGuid[64] {};
+    DWORD machineGuidSize = sizeof(machineGuid);
+
+    if (::RegGetValueW(
+            HKEY_LOCAL_MACHINE,
+            L"SOFTWARE\\Microsoft\\Cryptography",
+            L"MachineGuid",
+            RRF_RT_REG_SZ,
+            nullptr,
+            machineGuid,
+            &machineGuidSize) == ERROR_SUCCESS) {
+
+        seed = fnv1a(seed, machineGuid);
+        stable = true;
+    }
+
+    wchar_t userName[257] {};
+    DWORD userNameLength = 257;
+
+    if (::GetUserNameW(userName, &userNameLength)) {
+        seed = fnv1a(seed, userName);
+        stable = true;
+    }
+
+    if (!stable)
+        seed ^= ::GetTickCount64() ^ (static_cast<uint64_t>(::GetCurrentProcessId()) << 32);
+
+    return seed;
+}
+
+static void run_refresh_tick(uint64_t epoch);
+
+/* Updates the observation with the outcome of a tick and schedules the next one. */
+static void finish_refresh_tick(uint64_t epoch, const std::shared_ptr<const LicenseSnapshot>& snapshot, bool skipped) {
+
+    int64_t delayMillis;
+
+    {
+        std::lock_guard<std::mutex> lock(g_refresherMutex);
+
+        if (epoch != g_refresherEpoch)
+            return;
+
+        const int64_t now = current_unix_epoch_millis();
+
+        if (snapshot != nullptr) {
+
+            const bool changed = g_lastRefreshGeneration != 0 && snapshot->generation != g_lastRefreshGeneration;
+
+            g_refreshObservation.changeScore = decay_change_score(g_refreshObservation.changeScore, changed);
+            g_refreshObservation.consecutiveFailures = 0;
+            g_refreshObservation.nextExpirationAt = next_expiration_at(*snapshot, now);
+
+            g_lastRefreshGeneration = snapshot->generation;
+
+        } else {
+
+            g_refreshObservation.consecutiveFailures++;
+        }
+
+        if (skipped)
+            g_refresherSkips++;
+        else
+            g_refresherQueries++;
+
+        g_refreshObservation.now = now;
+
+        delayMillis = refresh_delay_millis(g_refreshPolicy, g_refreshObservation);
+
+        g_refreshObservation.round++;
+
+        g_nextRefreshAt = now + delayMillis;
+    }
+
+    dispatcher_post_delayed(std::chrono::milliseconds(delayMillis), [epoch]() {
+        run_refresh_tick(epoch);
+    });
+}
+
+/* Runs on the dispatcher thread; the Store query completes on the WinRT thread pool. */
+static void run_refresh_tick(uint64_t epoch) {
+
+    int64_t minIntervalMillis;
+
+    {
+        std::lock_guard<std::mutex> lock(g_refresherMutex);
+
+        if (epoch != g_refresherEpoch)
+            return;
+
+        minIntervalMillis = g_refreshPolicy.minIntervalMillis;
+    }
+
+    auto snapshot = current_snapshot();
+
+    /* Another caller refreshed recently; that counts as this tick's refresh. */
+    if (snapshot != nullptr && current_unix_epoch_millis() - snapshot->capturedAt < minIntervalMillis) {
+        finish_refresh_tick(epoch, snapshot, true);
+        return;
+    }
+
+    refresh_license_snapshot_then([epoch](std::shared_ptr<const LicenseSnapshot> refreshed) {
+        finish_refresh_tick(epoch, refreshed, false);
+    });
+}
+
+/*
+ * Starts (or restarts) the background license refresher.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_start_license_refresher(
+    int64_t intervalMillis,
+    int64_t minIntervalMillis,
+    int64_t maxIntervalMillis,
+    uint64_t jitterSeed
+) {
+
+    RefreshPolicy policy;
+    policy.intervalMillis = intervalMillis;
+    policy.minIntervalMillis = minIntervalMillis;
+    policy.maxIntervalMillis = maxIntervalMillis;
+
+    if (!is_valid_refresh_policy(policy)) {
+        g_lastError = "Refresh intervals must be positive with min <= interval <= max.";
+        return -1;
+    }
+
+    if (jitterSeed == 0)
+        jitterSeed = derive_jitter_seed();
+
+    uint64_t epoch;
+    int64_t delayMillis;
+
+    {
+        std::lock_guard<std::mutex> lock(g_refresherMutex);
+
+        g_refreshPolicy = policy;
+        g_refreshObservation = RefreshObservation();
+        g_refreshObservation.jitterSeed = jitterSeed;
+        g_lastRefreshGeneration = 0;
+        g_refresherRunning = true;
+        epoch = ++g_refresherEpoch;
+
+        delayMillis = initial_refresh_delay_millis(policy, jitterSeed);
+
+        g_nextRefreshAt = current_unix_epoch_millis() + delayMillis;
+    }
+
+    dispatcher_post_delayed(std::chrono::milliseconds(delayMillis), [epoch]() {
+        run_refresh_tick(epoch);
+    });
+
+    g_lastError.clear();
+
+    return 0;
+}
+
+/*
+ * Stops the background license refresher.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_stop_license_refresher() {
+
+    std::lock_guard<std::mutex> lock(g_refresherMutex);
+
+    g_refresherRunning = false;
+    ++g_refresherEpoch;
+}
+
+void dump_refresher_state(DiagnosticsWriter& writer) {
+
+    std::lock_guard<std::mutex> lock(g_refresherMutex);
+
+    writer.begin_object("refresher");
+    writer.add_bool("running", g_refresherRunning);
+    writer.add_number("intervalMillis", g_refreshPolicy.intervalMillis);
+    writer.add_number("minIntervalMillis", g_refreshPolicy.minIntervalMillis);
+    writer.add_number("maxIntervalMillis", g_refreshPolicy.maxIntervalMillis);
+    writer.add_number("nextRefreshAt", g_refresherRunning ? g_nextRefreshAt : 0);
+    writer.add_number("nextExpirationAt", g_refreshObservation.nextExpirationAt);
+    writer.add_number("consecutiveFailures", g_refreshObservation.consecutiveFailures);
+    writer.add_number("queries", static_cast<int64_t>(g_refresherQueries));
+    writer.add_number("skipped", static_cast<int64_t>(g_refresherSkips));
+    writer.end_object();
+}
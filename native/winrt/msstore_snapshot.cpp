@@ -0,0 +1,194 @@
+#include "msstore_snapshot.h"
+
+#include <algorithm>
+#include <utility>
+
+/* Number of distinct generations kept for diffing. */
+static constexpr size_t SNAPSHOT_HISTORY_SIZE = 16;
+
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+/* Snapshot history of the default user (StoreContext::GetDefault()). */
+static LicenseSnapshotHistory g_snapshotHistory;
+
+static uint64_t fnv_bytes(uint64_t hash, const void* data, size_t size) {
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    for (size_t index = 0; index < size; ++index) {
+        hash ^= bytes[index];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/* Hashes the string including a terminator so "ab"+"c" differs from "a"+"bc". */
+static uint64_t fnv_string(uint64_t hash, const std::string& value) {
+
+    const unsigned char terminator = 0;
+
+    hash = fnv_bytes(hash, value.data(), value.size());
+
+    return fnv_bytes(hash, &terminator, 1);
+}
+
+/* Hashes the value as little-endian bytes, independent of the host byte order. */
+static uint64_t fnv_uint64(uint64_t hash, uint64_t value) {
+
+    unsigned char bytes[8];
+
+    for (int index = 0; index < 8; ++index)
+        bytes[index] = static_cast<unsigned char>(value >> (index * 8));
+
+    return fnv_bytes(hash, bytes, sizeof(bytes));
+}
+
+void fingerprint_snapshot(LicenseSnapshot& snapshot) {
+
+    std::sort(snapshot.addOns.begin(), snapshot.addOns.end(), [](const AddOnSnapshot& left, const AddOnSnapshot& right) {
+        return left.skuStoreId < right.skuStoreId;
+    });
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    hash = fnv_string(hash, snapshot.skuStoreId);
+    hash = fnv_uint64(hash, snapshot.isActive ? 1 : 0);
+    hash = fnv_uint64(hash, snapshot.isTrial ? 1 : 0);
+    hash = fnv_uint64(hash, static_cast<uint64_t>(snapshot.expirationDate));
+    hash = fnv_uint64(hash, snapshot.addOns.size());
+
+    for (AddOnSnapshot& addOn : snapshot.addOns) {
+
+        uint64_t addOnHash = FNV_OFFSET_BASIS;
+
+        addOnHash = fnv_string(addOnHash, addOn.skuStoreId);
+        addOnHash = fnv_string(addOnHash, addOn.inAppOfferToken);
+        addOnHash = fnv_uint64(addOnHash, static_cast<uint64_t>(addOn.expirationDate));
+
+        addOn.fingerprint = addOnHash;
+
+        hash = fnv_uint64(hash, addOnHash);
+    }
+
+    snapshot.fingerprint = hash;
+}
+
+std::shared_ptr<const LicenseSnapshot> LicenseSnapshotHistory::publish(LicenseSnapshot snapshot) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_snapshots.empty()) {
+
+        snapshot.generation = 1;
+
+    } else {
+
+        const LicenseSnapshot& current = *m_snapshots.back();
+
+        if (current.fingerprint == snapshot.fingerprint) {
+
+            /* Same content: keep the generation, only refresh the capture time. */
+            snapshot.generation = current.generation;
+            m_snapshots.pop_back();
+
+        } else {
+            snapshot.generation = current.generation + 1;
+        }
+    }
+
+    auto published = std::make_shared<const LicenseSnapshot>(std::move(snapshot));
+
+    m_snapshots.push_back(published);
+
+    while (m_snapshots.size() > SNAPSHOT_HISTORY_SIZE)
+        m_snapshots.pop_front();
+
+    return published;
+}
+
+std::shared_ptr<const LicenseSnapshot> LicenseSnapshotHistory::current() const {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_snapshots.empty())
+        return nullptr;
+
+    return m_snapshots.back();
+}
+
+LicenseSnapshotDiff LicenseSnapshotHistory::diff_since(int64_t sinceGeneration) const {
+
+    LicenseSnapshotDiff diff;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_snapshots.empty())
+            return diff;
+
+        diff.current = m_snapshots.back();
+
+        for (auto const& snapshot : m_snapshots)
+            if (snapshot->generation == sinceGeneration)
+                diff.previous = snapshot;
+    }
+
+    const LicenseSnapshot& current = *diff.current;
+
+    if (diff.previous == nullptr) {
+
+        diff.isFullResync = true;
+
+        for (auto const& addOn : current.addOns)
+            diff.added.push_back(&addOn);
+
+        return diff;
+    }
+
+    if (diff.previous->generation == current.generation)
+        return diff;
+
+    /* Both add-on lists are sorted by skuStoreId: merge them in one pass. */
+    const auto& before = diff.previous->addOns;
+    const auto& after = current.addOns;
+
+    size_t beforeIndex = 0;
+    size_t afterIndex = 0;
+
+    while (beforeIndex < before.size() || afterIndex < after.size()) {
+
+        if (afterIndex == after.size() ||
+            (beforeIndex < before.size() && before[beforeIndex].skuStoreId < after[afterIndex].skuStoreId)) {
+
+            diff.removed.push_back(&before[beforeIndex++]);
+
+        } else if (beforeIndex == before.size() || after[afterIndex].skuStoreId < before[beforeIndex].skuStoreId) {
+
+            diff.added.push_back(&after[afterIndex++]);
+
+        } else {
+
+            if (before[beforeIndex].fingerprint != after[afterIndex].fingerprint)
+                diff.changed.push_back(&after[afterIndex]);
+
+            beforeIndex++;
+            afterIndex++;
+        }
+    }
+
+    return diff;
+}
+
+std::shared_ptr<const LicenseSnapshot> publish_snapshot(LicenseSnapshot snapshot) {
+    return g_snapshotHistory.publish(std::move(snapshot));
+}
+
+std::shared_ptr<const LicenseSnapshot> current_snapshot() {
+    return g_snapshotHistory.current();
+}
+
+LicenseSnapshotDiff diff_snapshot_since(int64_t sinceGeneration) {
+    return g_snapshotHistory.diff_since(sinceGeneration);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Native license snapshots with stable fingerprints and generations.
+ *
+ * Every license query produces a LicenseSnapshot. Publishing it compares its
+ * fingerprint with the current one: the generation only advances when the
+ * content changed, so "nothing changed" is a single integer compare for
+ * callers. The last few generations are kept to compute add-on diffs.
+ *
+ * This file has no WinRT dependency; conversion from and to WinRT and the C
+ * structs lives in msstore_winrt.cpp.
+ */
+
+struct AddOnSnapshot {
+    std::string skuStoreId;
+    std::string inAppOfferToken;
+    int64_t expirationDate = 0;
+    uint64_t fingerprint = 0;
+};
+
+struct LicenseSnapshot {
+    std::string skuStoreId;
+    bool isActive = false;
+    bool isTrial = false;
+    int64_t expirationDate = 0;
+
+    /* Sorted by skuStoreId, see fingerprint_snapshot(). */
+    std::vector<AddOnSnapshot> addOns;
+
+    uint64_t fingerprint = 0;
+    int64_t generation = 0;
+    int64_t capturedAt = 0;
+};
+
+/* Add-ons that differ between two generations. Pointers refer into the snapshots. */
+struct LicenseSnapshotDiff {
+    std::shared_ptr<const LicenseSnapshot> current;
+    std::shared_ptr<const LicenseSnapshot> previous;
+    bool isFullResync = false;
+    std::vector<const AddOnSnapshot*> added;
+    std::vector<const AddOnSnapshot*> removed;
+    std::vector<const AddOnSnapshot*> changed;
+};
+
+/*
+ * Sorts the add-ons and computes all fingerprints of the snapshot.
+ *
+ * Fingerprints are 64-bit FNV-1a over the field bytes. They are stable across
+ * processes and library versions as long as the fields stay the same.
+ */
+void fingerprint_snapshot(LicenseSnapshot& snapshot);
+
+/*
+ * The last few published snapshots of one license, oldest first.
+ *
+ * Snapshots are immutable once published, so readers only hold the lock to
+ * copy the shared pointer. The free functions below use the history of the
+ * default user; per-user contexts own their own instance.
+ */
+class LicenseSnapshotHistory {
+
+public:
+
+    /*
+     * Makes snapshot the current one and returns it.
+     *
+     * Assigns the generation: the previous generation if the fingerprint is
+     * unchanged, otherwise the next one. Expects fingerprint_snapshot() to
+     * have been called.
+     */
+    std::shared_ptr<const LicenseSnapshot> publish(LicenseSnapshot snapshot);
+
+    /* Returns the current snapshot, or nullptr if none was published yet. */
+    std::shared_ptr<const LicenseSnapshot> current() const;
+
+    /*
+     * Compares the current snapshot with the one of sinceGeneration.
+     *
+     * If sinceGeneration is no longer (or never was) in the history, the
+     * diff is a full resync that lists every current add-on as added.
+     */
+    LicenseSnapshotDiff diff_since(int64_t sinceGeneration) const;
+
+private:
+
+    mutable std::mutex m_mutex;
+    std::deque<std::shared_ptr<const LicenseSnapshot>> m_snapshots;
+};
+
+/* Publishes to the history of the default user, see LicenseSnapshotHistory::publish(). */
+std::shared_ptr<const LicenseSnapshot> publish_snapshot(LicenseSnapshot snapshot);
+
+/* Returns the current snapshot of the default user, or nullptr if none was published yet. */
+std::shared_ptr<const LicenseSnapshot> current_snapshot();
+
+/* Diffs the history of the default user, see LicenseSnapshotHistory::diff_since(). */
+LicenseSnapshotDiff diff_snapshot_since(int64_t sinceGeneration);
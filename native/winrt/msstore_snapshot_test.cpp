@@ -0,0 +1,146 @@
+#include "msstore_snapshot.h"
+#include "msstore_test.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+
+/*
+ * Tests of license fingerprints, generations and diffs.
+ *
+ * Portable C++20 without WinRT, built with MSSTORE_WINRT_TESTS (see
+ * CMakeLists.txt) and run by ctest.
+ */
+
+static AddOnSnapshot make_add_on(const char* skuStoreId, int64_t expirationDate = 0) {
+
+    AddOnSnapshot addOn;
+    addOn.skuStoreId = skuStoreId;
+    addOn.inAppOfferToken = "pro";
+    addOn.expirationDate = expirationDate;
+
+    return addOn;
+}
+
+static LicenseSnapshot make_license(std::initializer_list<AddOnSnapshot> addOns) {
+
+    LicenseSnapshot license;
+    license.skuStoreId = "9NBLGGH4R315/0010";
+    license.isActive = true;
+    license.addOns = addOns;
+
+    fingerprint_snapshot(license);
+
+    return license;
+}
+
+static void test_fingerprint_ignores_add_on_order() {
+
+    LicenseSnapshot first = make_license({ make_add_on("9NBLGGH4R316"), make_add_on("9NBLGGH4R317") });
+    LicenseSnapshot second = make_license({ make_add_on("9NBLGGH4R317"), make_add_on("9NBLGGH4R316") });
+
+    CHECK(first.fingerprint == second.fingerprint);
+    CHECK(first.addOns[0].skuStoreId == "9NBLGGH4R316");
+    CHECK(first.addOns[0].fingerprint == second.addOns[0].fingerprint);
+}
+
+static void test_fingerprint_covers_every_field() {
+
+    const LicenseSnapshot base = make_license({ make_add_on("9NBLGGH4R316") });
+
+    LicenseSnapshot trial = base;
+    trial.isTrial = true;
+    fingerprint_snapshot(trial);
+
+    LicenseSnapshot expiring = make_license({ make_add_on("9NBLGGH4R316", 1000) });
+
+    /* The terminator keeps field boundaries apart. */
+    AddOnSnapshot shifted = make_add_on("9NBLGGH4R31");
+    shifted.inAppOfferToken = "6pro";
+    LicenseSnapshot boundary = make_license({ shifted });
+
+    CHECK(trial.fingerprint != base.fingerprint);
+    CHECK(expiring.fingerprint != base.fingerprint);
+    CHECK(expiring.addOns[0].fingerprint != base.addOns[0].fingerprint);
+    CHECK(boundary.addOns[0].fingerprint != base.addOns[0].fingerprint);
+}
+
+static void test_fingerprint_is_stable() {
+
+    /* Persisted by callers across processes and library versions: must never change. */
+    LicenseSnapshot empty;
+    fingerprint_snapshot(empty);
+
+    CHECK(empty.fingerprint == 0xcbf7a16bc31f675fULL);
+}
+
+static void test_generation_advances_only_on_change() {
+
+    LicenseSnapshotHistory history;
+
+    CHECK(history.current() == nullptr);
+
+    std::shared_ptr<const LicenseSnapshot> first = history.publish(make_license({ make_add_on("9NBLGGH4R316") }));
+    std::shared_ptr<const LicenseSnapshot> same = history.publish(make_license({ make_add_on("9NBLGGH4R316") }));
+    std::shared_ptr<const LicenseSnapshot> changed = history.publish(make_license({}));
+
+    CHECK(first->generation == 1);
+    CHECK(same->generation == 1);
+    CHECK(changed->generation == 2);
+    CHECK(history.current() == changed);
+}
+
+static void test_diff_lists_added_removed_and_changed() {
+
+    LicenseSnapshotHistory history;
+
+    history.publish(make_license({ make_add_on("9NBLGGH4R316"), make_add_on("9NBLGGH4R317") }));
+    history.publish(make_license({ make_add_on("9NBLGGH4R317", 1000), make_add_on("9NBLGGH4R318") }));
+
+    LicenseSnapshotDiff diff = history.diff_since(1);
+
+    CHECK(!diff.isFullResync);
+    CHECK(diff.current != nullptr && diff.current->generation == 2);
+    CHECK(diff.added.size() == 1 && diff.added[0]->skuStoreId == "9NBLGGH4R318");
+    CHECK(diff.removed.size() == 1 && diff.removed[0]->skuStoreId == "9NBLGGH4R316");
+    CHECK(diff.changed.size() == 1 && diff.changed[0]->expirationDate == 1000);
+
+    LicenseSnapshotDiff unchanged = history.diff_since(2);
+
+    CHECK(!unchanged.isFullResync);
+    CHECK(unchanged.added.empty() && unchanged.removed.empty() && unchanged.changed.empty());
+}
+
+static void test_diff_of_unknown_generation_is_full_resync() {
+
+    LicenseSnapshotHistory history;
+
+    CHECK(history.diff_since(1).current == nullptr);
+
+    /* Generations 1..20; the history keeps only the last 16. */
+    for (int index = 0; index < 20; ++index)
+        history.publish(make_license({ make_add_on("9NBLGGH4R316", index) }));
+
+    LicenseSnapshotDiff evicted = history.diff_since(2);
+
+    CHECK(evicted.isFullResync);
+    CHECK(evicted.added.size() == 1);
+    CHECK(evicted.removed.empty());
+
+    CHECK(!history.diff_since(10).isFullResync);
+    CHECK(history.diff_since(42).isFullResync);
+}
+
+int main() {
+
+    test_fingerprint_ignores_add_on_order();
+    test_fingerprint_covers_every_field();
+    test_fingerprint_is_stable();
+    test_generation_advances_only_on_change();
+    test_diff_lists_added_removed_and_changed();
+    test_diff_of_unknown_generation_is_full_resync();
+
+    return test_result("msstore_snapshot_test");
+}
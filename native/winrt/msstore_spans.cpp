@@ -0,0 +1,114 @@
+#include "msstore_winrt.h"
+#include "msstore_spans.h"
+#include "msstore_diagnostics.h"
+
+#include <atomic>
+#include <cstdint>
+
+/* Number of slow calls kept; older ones are overwritten. */
+static constexpr uint32_t SLOW_CALL_RING_CAPACITY = 64;
+
+static std::atomic<int64_t> g_slowCallThresholdMicros { 0 };
+static SlowCallRing<SLOW_CALL_RING_CAPACITY> g_slowCalls;
+
+/*
+ * Last completed call of this thread, if it was not recorded yet.
+ *
+ * Waits for msstore_winrt_commit_slow_call() to add the caller's decoding
+ * time, so the record carries JvmDecodeMicros and a call that only became
+ * slow through that decoding is recorded as well.
+ */
+static thread_local MsStoreSlowCallNative t_lastCall {};
+static thread_local bool t_lastCallPending = false;
+
+/*
+ * Set once this thread called msstore_winrt_commit_slow_call(). Until then
+ * slow calls are recorded right away, as nothing would commit them.
+ */
+static thread_local bool t_callerCommits = false;
+
+static bool is_slow(const MsStoreSlowCallNative& record) {
+
+    const int64_t threshold = slow_call_threshold_micros();
+
+    return threshold > 0 && record.TotalMicros >= threshold;
+}
+
+int64_t slow_call_threshold_micros() {
+    return g_slowCallThresholdMicros.load(std::memory_order_relaxed);
+}
+
+void finish_call_span(const MsStoreSlowCallNative& record) {
+
+    /* The previous call was never committed. */
+    flush_last_call_span();
+
+    if (!t_callerCommits) {
+
+        if (is_slow(record))
+            g_slowCalls.push(record);
+
+        return;
+    }
+
+    t_lastCall = record;
+    t_lastCallPending = true;
+}
+
+void flush_last_call_span() {
+
+    if (!t_lastCallPending)
+        return;
+
+    t_lastCallPending = false;
+
+    if (is_slow(t_lastCall))
+        g_slowCalls.push(t_lastCall);
+}
+
+void dump_slow_call_state(DiagnosticsWriter& writer) {
+
+    writer.begin_object("slowCalls");
+    writer.add_number("thresholdMicros", slow_call_threshold_micros());
+    writer.add_number("recorded", g_slowCalls.pushed());
+    writer.add_number("capacity", SLOW_CALL_RING_CAPACITY);
+    writer.end_object();
+}
+
+/*
+ * Sets the slow-call threshold in microseconds; 0 disables recording.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_set_slow_call_threshold(int64_t thresholdMicros) {
+    g_slowCallThresholdMicros.store(thresholdMicros > 0 ? thresholdMicros : 0, std::memory_order_relaxed);
+}
+
+/*
+ * Records the last call of this thread if it was slow including the caller's decoding.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_commit_slow_call(int64_t jvmDecodeMicros) {
+
+    t_callerCommits = true;
+
+    if (!t_lastCallPending)
+        return;
+
+    t_lastCall.JvmDecodeMicros = jvmDecodeMicros;
+    t_lastCall.TotalMicros += jvmDecodeMicros;
+
+    flush_last_call_span();
+}
+
+/*
+ * Copies slow-call records newer than sinceSequence, oldest first.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_read_slow_calls(
+    int64_t sinceSequence,
+    MsStoreSlowCallNative* buffer,
+    int capacity
+) {
+
+    if (buffer == nullptr || capacity <= 0)
+        return 0;
+
+    return g_slowCalls.read(sinceSequence, buffer, capacity);
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "msstore_winrt.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Slow-call forensics.
+ *
+ * Every instrumented license call carries a CallSpan that times its phases.
+ * When the call ends, the span is kept until the caller commits its decoding
+ * time; if the call took at least the configured threshold, it is then
+ * written into a SlowCallRing together with its error. Callers that never
+ * commit get slow calls recorded as soon as they end. With the threshold at
+ * 0 spans are inactive and no clock is read at all.
+ *
+ * This file has no WinRT dependency.
+ */
+
+/* Operation codes of MsStoreSlowCallNative. */
+static constexpr int CALL_GET_LICENSE = 1;
+static constexpr int CALL_GET_LICENSE_CHANGES = 2;
+static constexpr int CALL_GET_USER_LICENSE = 3;
+static constexpr int CALL_GET_USER_LICENSE_CHANGES = 4;
+static constexpr int CALL_BROKER_READ_LICENSE = 5;
+
+using SpanClock = std::chrono::steady_clock;
+
+inline int64_t micros_between(SpanClock::time_point from, SpanClock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+/* Timing of one Store query; every call that waited for it gets a copy. */
+struct RefreshTiming {
+    int64_t queueWaitMicros = 0;
+    int64_t storeMicros = 0;
+    bool joined = false;
+};
+
+/*
+ * Fixed-size ring of slow-call records.
+ *
+ * Lock-free: writers claim a sequence number with one atomic increment and
+ * the slot with a try-lock. A writer never waits; if the slot is busy (a
+ * reader is copying it or another writer lapped the ring) the record is
+ * dropped. Readers skip busy slots the same way.
+ */
+template <uint32_t Capacity>
+class SlowCallRing {
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "Ring capacity must be a power of two.");
+
+public:
+
+    /* Stores record under the next Sequence. */
+    void push(MsStoreSlowCallNative record) {
+
+        const int64_t sequence = m_nextSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        Slot& slot = m_slots[static_cast<uint64_t>(sequence - 1) & (Capacity - 1)];
+
+        if (slot.busy.exchange(true, std::memory_order_acquire))
+            return;
+
+        record.Sequence = sequence;
+        slot.record = record;
+
+        slot.busy.store(false, std::memory_order_release);
+    }
+
+    /* Copies up to capacity records newer than sinceSequence, oldest first. */
+    int read(int64_t sinceSequence, MsStoreSlowCallNative* buffer, int capacity) {
+
+        std::vector<MsStoreSlowCallNative> records;
+        records.reserve(Capacity);
+
+        for (Slot& slot : m_slots) {
+
+            if (slot.busy.exchange(true, std::memory_order_acquire))
+                continue;
+
+            if (slot.record.Sequence > sinceSequence)
+                records.push_back(slot.record);
+
+            slot.busy.store(false, std::memory_order_release);
+        }
+
+        std::sort(records.begin(), records.end(),
+            [](const MsStoreSlowCallNative& left, const MsStoreSlowCallNative& right) {
+                return left.Sequence < right.Sequence;
+            });
+
+        const int count = static_cast<int>(std::min<size_t>(records.size(), static_cast<size_t>(capacity)));
+
+        std::copy(records.begin(), records.begin() + count, buffer);
+
+        return count;
+    }
+
+    /* Number of records pushed so far, including overwritten and dropped ones. */
+    int64_t pushed() const {
+        return m_nextSequence.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    struct Slot {
+        std::atomic<bool> busy { false };
+        MsStoreSlowCallNative record {};
+    };
+
+    std::atomic<int64_t> m_nextSequence { 0 };
+    Slot m_slots[Capacity];
+};
+
+class DiagnosticsWriter;
+
+/* Diagnostics section for msstore_winrt_dump_state(). Defined in msstore_spans.cpp. */
+void dump_slow_call_state(DiagnosticsWriter& writer);
+
+/* Current threshold in microseconds, 0 if disabled. Defined in msstore_spans.cpp. */
+int64_t slow_call_threshold_micros();
+
+/*
+ * Completes a span: keeps it as the calling thread's last call until the
+ * caller commits, or records it right away if it was slow and the thread
+ * never commits. Defined in msstore_spans.cpp.
+ */
+void finish_call_span(const MsStoreSlowCallNative& record);
+
+/*
+ * Ends the wait for a commit of the calling thread's last call, recording
+ * it if it was slow, so no stale call gets committed.
+ */
+void flush_last_call_span();
+
+/*
+ * Times one exported call from construction to destruction.
+ *
+ * error is the calling thread's last error; it is read when the span ends,
+ * so a failed call is recorded with its message. All members are no-ops on
+ * an inactive span.
+ */
+class CallSpan {
+
+public:
+
+    CallSpan(int operation, const std::string& error) : m_error(error) {
+
+        flush_last_call_span();
+
+        if (slow_call_threshold_micros() <= 0)
+            return;
+
+        m_active = true;
+        m_started = SpanClock::now();
+
+        m_record.Operation = operation;
+        m_record.StartedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    CallSpan(const CallSpan&) = delete;
+    CallSpan& operator=(const CallSpan&) = delete;
+
+    ~CallSpan() {
+
+        if (!m_active)
+            return;
+
+        m_record.TotalMicros = micros_between(m_started, SpanClock::now());
+        m_record.Failed = !m_error.empty();
+
+        if (m_record.Failed) {
+            const size_t length = std::min(m_error.size(), sizeof(m_record.Error) - 1);
+            std::memcpy(m_record.Error, m_error.data(), length);
+        }
+
+        finish_call_span(m_record);
+    }
+
+    /* Start of a phase; pass the result to the matching end_*() call. */
+    SpanClock::time_point now() const {
+        return m_active ? SpanClock::now() : SpanClock::time_point();
+    }
+
+    void end_apartment(SpanClock::time_point start) {
+        if (m_active)
+            m_record.ApartmentMicros += micros_between(start, SpanClock::now());
+    }
+
+    void end_store(SpanClock::time_point start) {
+        if (m_active)
+            m_record.StoreMicros += micros_between(start, SpanClock::now());
+    }
+
+    void end_marshal(SpanClock::time_point start) {
+        if (m_active)
+            m_record.MarshalMicros += micros_between(start, SpanClock::now());
+    }
+
+    void set_refresh(const RefreshTiming& timing) {
+
+        if (!m_active)
+            return;
+
+        m_record.QueueWaitMicros = timing.queueWaitMicros;
+        m_record.StoreMicros = timing.storeMicros;
+        m_record.Joined = timing.joined;
+    }
+
+    void set_add_on_count(size_t count) {
+        if (m_active)
+            m_record.AddOnCount = static_cast<int>(count);
+    }
+
+private:
+
+    const std::string& m_error;
+    bool m_active = false;
+    SpanClock::time_point m_started;
+    MsStoreSlowCallNative m_record {};
+};
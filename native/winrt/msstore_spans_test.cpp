@@ -0,0 +1,135 @@
+#include "msstore_winrt.h"
+#include "msstore_spans.h"
+#include "msstore_test.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/*
+ * Tests of slow-call recording and the caller's decode-time commit.
+ *
+ * Each test runs on its own thread, as the commit state is per thread.
+ *
+ * Portable C++20 without WinRT, built with MSSTORE_WINRT_TESTS (see
+ * CMakeLists.txt) and run by ctest.
+ */
+
+static constexpr int64_t THRESHOLD_MICROS = 1000;
+
+static int64_t g_lastSequence = 0;
+
+static MsStoreSlowCallNative make_call(int64_t totalMicros) {
+
+    MsStoreSlowCallNative record {};
+    record.Operation = CALL_GET_LICENSE;
+    record.TotalMicros = totalMicros;
+
+    return record;
+}
+
+/* Returns the number of calls recorded since the last read; the newest in last. */
+static int read_new_calls(MsStoreSlowCallNative& last) {
+
+    MsStoreSlowCallNative buffer[64];
+
+    const int count = msstore_winrt_read_slow_calls(g_lastSequence, buffer, 64);
+
+    if (count > 0) {
+        last = buffer[count - 1];
+        g_lastSequence = last.Sequence;
+    }
+
+    return count;
+}
+
+static void run_on_thread(void (*test)()) {
+    std::thread(test).join();
+}
+
+static void test_slow_call_of_committing_caller_gets_decode_time() {
+
+    MsStoreSlowCallNative last {};
+
+    msstore_winrt_commit_slow_call(0);
+
+    /* Already slow natively: must still wait for the decode time. */
+    finish_call_span(make_call(THRESHOLD_MICROS * 2));
+
+    CHECK(read_new_calls(last) == 0);
+
+    msstore_winrt_commit_slow_call(300);
+
+    CHECK(read_new_calls(last) == 1);
+    CHECK(last.JvmDecodeMicros == 300);
+    CHECK(last.TotalMicros == THRESHOLD_MICROS * 2 + 300);
+}
+
+static void test_call_slow_only_through_decoding_is_recorded() {
+
+    MsStoreSlowCallNative last {};
+
+    msstore_winrt_commit_slow_call(0);
+
+    finish_call_span(make_call(THRESHOLD_MICROS - 100));
+    msstore_winrt_commit_slow_call(200);
+
+    CHECK(read_new_calls(last) == 1);
+    CHECK(last.JvmDecodeMicros == 200);
+
+    finish_call_span(make_call(THRESHOLD_MICROS - 100));
+    msstore_winrt_commit_slow_call(50);
+
+    CHECK(read_new_calls(last) == 0);
+}
+
+static void test_caller_without_commit_is_recorded_right_away() {
+
+    MsStoreSlowCallNative last {};
+
+    finish_call_span(make_call(THRESHOLD_MICROS * 2));
+
+    CHECK(read_new_calls(last) == 1);
+    CHECK(last.JvmDecodeMicros == 0);
+
+    finish_call_span(make_call(THRESHOLD_MICROS - 100));
+
+    CHECK(read_new_calls(last) == 0);
+}
+
+static void test_uncommitted_slow_call_is_recorded_by_next_call() {
+
+    MsStoreSlowCallNative last {};
+
+    msstore_winrt_commit_slow_call(0);
+
+    /* Decoding failed before the commit. */
+    finish_call_span(make_call(THRESHOLD_MICROS * 2));
+
+    CHECK(read_new_calls(last) == 0);
+
+    {
+        CallSpan span(CALL_GET_LICENSE_CHANGES, std::string());
+
+        CHECK(read_new_calls(last) == 1);
+        CHECK(last.Operation == CALL_GET_LICENSE);
+        CHECK(last.TotalMicros == THRESHOLD_MICROS * 2);
+    }
+
+    /* The fast span itself is pending and dropped on commit. */
+    msstore_winrt_commit_slow_call(0);
+
+    CHECK(read_new_calls(last) == 0);
+}
+
+int main() {
+
+    msstore_winrt_set_slow_call_threshold(THRESHOLD_MICROS);
+
+    run_on_thread(test_slow_call_of_committing_caller_gets_decode_time);
+    run_on_thread(test_call_slow_only_through_decoding_is_recorded);
+    run_on_thread(test_caller_without_commit_is_recorded_right_away);
+    run_on_thread(test_uncommitted_slow_call_is_recorded_by_next_call);
+
+    return test_result("msstore_spans_test");
+}
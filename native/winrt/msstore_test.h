@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+
+/*
+ * Minimal checks for the portable native tests (MSSTORE_WINRT_TESTS).
+ *
+ * A failed CHECK prints its expression and line and the test continues;
+ * main() returns test_result(), which ctest reads as the outcome.
+ */
+
+inline int g_testFailures = 0;
+
+#define CHECK(condition) test_check((condition), #condition, __FILE__, __LINE__)
+
+inline void test_check(bool condition, const char* expression, const char* file, int line) {
+
+    if (condition)
+        return;
+
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    g_testFailures++;
+}
+
+/* Prints a summary and returns the exit code: the number of failed checks. */
+inline int test_result(const char* name) {
+
+    if (g_testFailures == 0)
+        std::printf("%s: all checks passed\n", name);
+    else
+        std::printf("%s: %d checks failed\n", name, g_testFailures);
+
+    return g_testFailures;
+}
@@ -0,0 +1,519 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+#include "msstore_dispatcher.h"
+#include "msstore_engine.h"
+
+#include <windows.h>
+#include <ShObjIdl_core.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <winrt/base.h>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Services.Store.h>
+
+using namespace winrt;
+using namespace Windows::Foundation;
+using namespace Windows::Foundation::Collections;
+using namespace Windows::Services::Store;
+
+/*
+ * State of the background package update checker.
+ *
+ * All fields are guarded by g_updatesMutex. The lock is only held to copy
+ * values, never across a Store call.
+ */
+static std::mutex g_updatesMutex;
+static MsStorePendingUpdatesNative g_pendingUpdates {};
+static IVectorView<StorePackageUpdate> g_pendingUpdatePackages { nullptr };
+static int64_t g_updateCheckIntervalMillis = 0;
+static bool g_updateCheckerRunning = false;
+
+/*
+ * Incremented on every start and stop.
+ *
+ * Each scheduled check carries the epoch it was started with, so checks of a
+ * stopped or restarted checker end themselves instead of rescheduling.
+ */
+static uint64_t g_updateCheckerEpoch = 0;
+
+/*
+ * Runs one update check and schedules the next one.
+ *
+ * Starts on the dispatcher thread and awaits the Store query instead of
+ * blocking, so the dispatcher stays free for other work meanwhile.
+ */
+static DetachedTask run_update_check(uint64_t epoch) {
+
+    {
+        std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+        if (epoch != g_updateCheckerEpoch)
+            co_return;
+    }
+
+    IVectorView<StorePackageUpdate> updates { nullptr };
+    int updateCount = 0;
+    int mandatoryCount = 0;
+
+    try {
+
+        StoreContext context = StoreContext::GetDefault();
+
+        updates = co_await context.GetAppAndOptionalStorePackageUpdatesAsync();
+
+        for (auto const& update : updates)
+            if (update.Mandatory())
+                mandatoryCount++;
+
+        updateCount = static_cast<int>(updates.Size());
+
+    } catch (...) {
+        updates = nullptr;
+    }
+
+    /*
+     * Nobody awaits this task, and after the co_await it runs on a thread-pool
+     * thread, so g_lastError would reach nobody. A failed reschedule ends the
+     * checker; its state and the detached task failures show that.
+     */
+    try {
+
+        int64_t intervalMillis;
+
+        {
+            std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+            if (epoch != g_updateCheckerEpoch)
+                co_return;
+
+            g_pendingUpdates.Generation++;
+            g_pendingUpdates.CheckedAt = current_unix_epoch_millis();
+            g_pendingUpdates.LastCheckFailed = updates == nullptr;
+
+            /* Keep the last known updates if this check failed. */
+            if (updates != nullptr) {
+                g_pendingUpdates.UpdateCount = updateCount;
+                g_pendingUpdates.MandatoryUpdateCount = mandatoryCount;
+                g_pendingUpdatePackages = updates;
+            }
+
+            intervalMillis = g_updateCheckIntervalMillis;
+        }
+
+        dispatcher_post_delayed(std::chrono::milliseconds(intervalMillis), [epoch]() {
+            run_update_check(epoch);
+        });
+
+    } catch (...) {
+
+        {
+            std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+            if (epoch == g_updateCheckerEpoch)
+                g_updateCheckerRunning = false;
+        }
+
+        record_detached_task_failure(std::current_exception());
+    }
+}
+
+/*
+ * Starts (or restarts) the background package update checker.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_start_update_checker(int64_t intervalMillis) {
+
+    if (intervalMillis <= 0) {
+        g_lastError = "Update check interval must be positive.";
+        return -1;
+    }
+
+    uint64_t epoch;
+
+    {
+        std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+        g_updateCheckIntervalMillis = intervalMillis;
+        g_updateCheckerRunning = true;
+        epoch = ++g_updateCheckerEpoch;
+    }
+
+    dispatcher_post([epoch]() {
+        run_update_check(epoch);
+    });
+
+    g_lastError.clear();
+
+    return 0;
+}
+
+/*
+ * Stops the background package update checker.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_stop_update_checker() {
+
+    std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+    g_updateCheckerRunning = false;
+    ++g_updateCheckerEpoch;
+}
+
+/*
+ * Copies the cached update check result without touching the Store.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_get_pending_updates(MsStorePendingUpdatesNative* result) {
+
+    if (result == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+    *result = g_pendingUpdates;
+}
+
+/*
+ * Progress ring for the running package update installation.
+ *
+ * Single producer (the WinRT progress and completion handlers, which are
+ * invoked one after another for one operation) and single consumer (the
+ * thread draining via msstore_winrt_wait_update_progress). Records that do
+ * not fit are dropped: the next record supersedes them anyway.
+ *
+ * The final record is kept outside of the ring so it can never be dropped.
+ */
+static constexpr uint32_t UPDATE_PROGRESS_RING_CAPACITY = 256;
+
+static_assert((UPDATE_PROGRESS_RING_CAPACITY & (UPDATE_PROGRESS_RING_CAPACITY - 1)) == 0,
+              "Ring capacity must be a power of two.");
+
+static MsStoreUpdateProgressNative g_progressRing[UPDATE_PROGRESS_RING_CAPACITY];
+static std::atomic<uint32_t> g_progressHead { 0 };
+static std::atomic<uint32_t> g_progressTail { 0 };
+
+static MsStoreUpdateProgressNative g_installFinalRecord {};
+static std::atomic<bool> g_installRunning { false };
+static std::atomic<bool> g_installFinished { false };
+static std::atomic<bool> g_installFinalDelivered { true };
+
+/*
+ * Serializes starts against each other and against the copy step of
+ * msstore_winrt_wait_update_progress(). A finished but undrained
+ * installation may be replaced, but never while a drain reads the ring.
+ */
+static std::mutex g_installMutex;
+
+/* Auto-reset event that wakes the draining thread after each write. */
+static HANDLE g_progressEvent = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+static void push_progress(const MsStoreUpdateProgressNative& record) {
+
+    const uint32_t head = g_progressHead.load(std::memory_order_relaxed);
+    const uint32_t tail = g_progressTail.load(std::memory_order_acquire);
+
+    if (head - tail < UPDATE_PROGRESS_RING_CAPACITY) {
+        g_progressRing[head & (UPDATE_PROGRESS_RING_CAPACITY - 1)] = record;
+        g_progressHead.store(head + 1, std::memory_order_release);
+    }
+
+    ::SetEvent(g_progressEvent);
+}
+
+static void finish_install(int state) {
+
+    g_installFinalRecord = MsStoreUpdateProgressNative {};
+    g_installFinalRecord.State = state;
+    g_installFinalRecord.IsFinal = true;
+
+    if (state == static_cast<int>(StorePackageUpdateState::Completed))
+        g_installFinalRecord.TotalDownloadProgress = 1.0;
+
+    g_installFinished.store(true, std::memory_order_release);
+
+    ::SetEvent(g_progressEvent);
+}
+
+static MsStoreUpdateProgressNative to_progress_record(const StorePackageUpdateStatus& status) {
+
+    MsStoreUpdateProgressNative record {};
+
+    record.PackageBytesDownloaded = status.PackageBytesDownloaded;
+    record.PackageDownloadSizeInBytes = status.PackageDownloadSizeInBytes;
+    record.PackageDownloadProgress = status.PackageDownloadProgress;
+    record.TotalDownloadProgress = status.TotalDownloadProgress;
+    record.State = static_cast<int>(status.PackageUpdateState);
+
+    /* Truncate rather than allocate: family names are far below the limit. */
+    const std::string familyName = to_string(status.PackageFamilyName);
+    const size_t length = (std::min)(familyName.size(), sizeof(record.PackageFamilyName) - 1);
+    std::memcpy(record.PackageFamilyName, familyName.data(), length);
+
+    return record;
+}
+
+/*
+ * Queries the pending package updates on the dispatcher thread.
+ *
+ * Like run_update_check, awaits the Store query instead of blocking the
+ * dispatcher; result is completed from the thread-pool thread that resumed
+ * the task.
+ */
+static DetachedTask query_update_packages(std::shared_ptr<AsyncResult<IVectorView<StorePackageUpdate>>> result) {
+
+    try {
+
+        StoreContext context = StoreContext::GetDefault();
+
+        result->complete(co_await context.GetAppAndOptionalStorePackageUpdatesAsync());
+
+    } catch (const hresult_error& ex) {
+        result->fail(to_string(ex.message()));
+    } catch (const std::exception& ex) {
+        result->fail(ex.what());
+    } catch (...) {
+        result->fail("Unknown native error.");
+    }
+}
+
+/*
+ * Returns the packages found by the last update check, or queries them.
+ *
+ * Blocks the calling thread, not the dispatcher, while querying.
+ */
+static IVectorView<StorePackageUpdate> pending_update_packages() {
+
+    {
+        std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+        if (g_pendingUpdatePackages != nullptr)
+            return g_pendingUpdatePackages;
+    }
+
+    auto result = std::make_shared<AsyncResult<IVectorView<StorePackageUpdate>>>();
+
+    dispatcher_post([result]() {
+        query_update_packages(result);
+    });
+
+    IVectorView<StorePackageUpdate> updates { nullptr };
+    std::string error;
+
+    if (!result->wait(updates, error))
+        throw std::runtime_error(error);
+
+    return updates;
+}
+
+/*
+ * Starts the installation operation on the calling thread.
+ *
+ * The Store may show UI (for example a restart prompt), so the operation is
+ * started from a single-threaded apartment with an owner window, the same
+ * way as purchases. Only progress and completion are delivered off-thread
+ * by WinRT handlers.
+ */
+static void start_install_operation(HWND ownerWindow) {
+
+    init_apartment(apartment_type::single_threaded);
+
+    StoreContext context = StoreContext::GetDefault();
+
+    auto initWindow = context.as<IInitializeWithWindow>();
+    initWindow->Initialize(ownerWindow);
+
+    IVectorView<StorePackageUpdate> updates = pending_update_packages();
+
+    if (updates.Size() == 0) {
+        finish_install(static_cast<int>(StorePackageUpdateState::Completed));
+        return;
+    }
+
+    auto operation = context.RequestDownloadAndInstallStorePackageUpdatesAsync(updates);
+
+    operation.Progress([](auto const&, StorePackageUpdateStatus const& status) {
+        push_progress(to_progress_record(status));
+    });
+
+    operation.Completed([](auto const& sender, AsyncStatus status) {
+
+        int state = static_cast<int>(StorePackageUpdateState::OtherError);
+
+        try {
+
+            if (status == AsyncStatus::Completed)
+                state = static_cast<int>(sender.GetResults().OverallState());
+            else if (status == AsyncStatus::Canceled)
+                state = static_cast<int>(StorePackageUpdateState::Canceled);
+
+        } catch (...) {
+            /* Report as OtherError. */
+        }
+
+        finish_install(state);
+    });
+}
+
+/*
+ * Marks an installation that failed to start as over, so the next one can
+ * start and no drain waits for it.
+ */
+static void abandon_install() {
+
+    std::lock_guard<std::mutex> lock(g_installMutex);
+
+    g_installFinished.store(true, std::memory_order_release);
+    g_installFinalDelivered.store(true);
+    g_installRunning.store(false);
+}
+
+/*
+ * Starts downloading and installing all pending package updates.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_start_update_install() {
+
+    if (g_progressEvent == nullptr) {
+        g_lastError = "Could not create the update progress event.";
+        return -1;
+    }
+
+    HWND ownerWindow = ::GetForegroundWindow();
+
+    if (ownerWindow == nullptr) {
+        g_lastError = "No foreground window handle available for Store UI.";
+        return -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_installMutex);
+
+        if (g_installRunning.load() && !g_installFinished.load()) {
+            g_lastError = "An update installation is already running.";
+            return -1;
+        }
+
+        /*
+         * No handler of a previous installation is alive anymore at this point,
+         * and no drain can read the ring while g_installMutex is held.
+         */
+        g_progressHead.store(0, std::memory_order_relaxed);
+        g_progressTail.store(0, std::memory_order_relaxed);
+        g_installFinished.store(false, std::memory_order_relaxed);
+        g_installFinalDelivered.store(false);
+        g_installRunning.store(true);
+        ::ResetEvent(g_progressEvent);
+    }
+
+    /* The lock is not held here: querying may take seconds and drains need it. */
+    try {
+
+        start_install_operation(ownerWindow);
+
+        g_lastError.clear();
+
+        return 0;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    abandon_install();
+
+    return -1;
+}
+
+/*
+ * Drains buffered progress records of the running installation.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_wait_update_progress(
+    MsStoreUpdateProgressNative* buffer,
+    int capacity,
+    int timeoutMillis
+) {
+
+    if (buffer == nullptr || capacity <= 0) {
+        g_lastError = "Progress buffer is null or empty.";
+        return -1;
+    }
+
+    if (g_installFinalDelivered.load()) {
+        g_lastError = "No update installation was started.";
+        return -1;
+    }
+
+    if (g_progressHead.load(std::memory_order_acquire) == g_progressTail.load(std::memory_order_relaxed) &&
+        !g_installFinished.load(std::memory_order_acquire))
+        ::WaitForSingleObject(g_progressEvent, timeoutMillis < 0 ? 0 : static_cast<DWORD>(timeoutMillis));
+
+    /* A restart may have reset the ring during the wait; copy only under the lock that prevents it. */
+    std::lock_guard<std::mutex> lock(g_installMutex);
+
+    if (g_installFinalDelivered.load()) {
+        g_lastError = "No update installation was started.";
+        return -1;
+    }
+
+    uint32_t tail = g_progressTail.load(std::memory_order_relaxed);
+
+    /* Read the finished flag before the ring so no record after it is missed. */
+    const bool finished = g_installFinished.load(std::memory_order_acquire);
+    const uint32_t head = g_progressHead.load(std::memory_order_acquire);
+
+    int count = 0;
+
+    while (tail != head && count < capacity) {
+        buffer[count++] = g_progressRing[tail & (UPDATE_PROGRESS_RING_CAPACITY - 1)];
+        tail++;
+    }
+
+    g_progressTail.store(tail, std::memory_order_release);
+
+    if (finished && tail == head && count < capacity) {
+
+        buffer[count++] = g_installFinalRecord;
+
+        g_installFinalDelivered.store(true);
+        g_installRunning.store(false);
+    }
+
+    g_lastError.clear();
+
+    return count;
+}
+
+void dump_update_state(DiagnosticsWriter& writer) {
+
+    {
+        std::lock_guard<std::mutex> lock(g_updatesMutex);
+
+        writer.begin_object("updateChecker");
+        writer.add_bool("running", g_updateCheckerRunning);
+        writer.add_number("intervalMillis", g_updateCheckIntervalMillis);
+        writer.add_number("generation", g_pendingUpdates.Generation);
+        writer.add_number("checkedAt", g_pendingUpdates.CheckedAt);
+        writer.add_bool("lastCheckFailed", g_pendingUpdates.LastCheckFailed);
+        writer.add_number("updateCount", g_pendingUpdates.UpdateCount);
+        writer.end_object();
+    }
+
+    const uint32_t head = g_progressHead.load(std::memory_order_acquire);
+    const uint32_t tail = g_progressTail.load(std::memory_order_acquire);
+
+    writer.begin_object("updateInstall");
+    writer.add_bool("running", g_installRunning.load() && !g_installFinished.load());
+    writer.add_bool("finalDelivered", g_installFinalDelivered.load());
+    writer.add_number("progressQueued", static_cast<int64_t>(head - tail));
+    writer.add_number("progressCapacity", UPDATE_PROGRESS_RING_CAPACITY);
+    writer.end_object();
+}
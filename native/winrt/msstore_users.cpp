@@ -0,0 +1,303 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+#include "msstore_snapshot.h"
+
+#include <windows.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <winrt/base.h>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Services.Store.h>
+#include <winrt/Windows.System.h>
+
+using namespace winrt;
+using namespace Windows::Services::Store;
+using namespace Windows::System;
+
+/* Number of user contexts kept before the least recently used is dropped. */
+static constexpr size_t USER_CONTEXT_CACHE_SIZE = 8;
+
+/*
+ * StoreContext of one user together with its license snapshots.
+ *
+ * Entries are shared: a call keeps using its entry even if it gets evicted
+ * meanwhile.
+ */
+struct UserContextEntry {
+    std::string userId;
+    StoreContext context { nullptr };
+    LicenseSnapshotHistory history;
+};
+
+/*
+ * User contexts, most recently used first. Guarded by g_userContextsMutex.
+ *
+ * Switching between a handful of users on a shared device then neither
+ * rebuilds the StoreContext nor loses the cached license of a user.
+ */
+static std::mutex g_userContextsMutex;
+static std::list<std::shared_ptr<UserContextEntry>> g_userContexts;
+
+/*
+ * Returns the cached entry of userId as most recently used, or nullptr.
+ *
+ * Caller must hold g_userContextsMutex.
+ */
+static std::shared_ptr<UserContextEntry> find_user_context(const char* userId) {
+
+    for (auto it = g_userContexts.begin(); it != g_userContexts.end(); ++it) {
+
+        if ((*it)->userId == userId) {
+
+            /* Move to the front without reallocating the node. */
+            g_userContexts.splice(g_userContexts.begin(), g_userContexts, it);
+
+            return g_userContexts.front();
+        }
+    }
+
+    return nullptr;
+}
+
+/*
+ * Returns the entry of userId, creating it on first use.
+ *
+ * userId is the User.NonRoamableId. Throws if no such user is signed in.
+ *
+ * The StoreContext is created without holding g_userContextsMutex, so calls
+ * for cached users never wait for it. If another call created the same
+ * user's entry meanwhile, that entry wins.
+ */
+static std::shared_ptr<UserContextEntry> acquire_user_context(const char* userId) {
+
+    {
+        std::lock_guard<std::mutex> lock(g_userContextsMutex);
+
+        if (auto cached = find_user_context(userId))
+            return cached;
+    }
+
+    User user = User::GetFromId(to_hstring(std::string_view(userId)));
+
+    if (!user)
+        throw std::runtime_error("No signed-in user with this ID.");
+
+    auto entry = std::make_shared<UserContextEntry>();
+    entry->userId = userId;
+    entry->context = StoreContext::GetForUser(user);
+
+    std::lock_guard<std::mutex> lock(g_userContextsMutex);
+
+    if (auto cached = find_user_context(userId))
+        return cached;
+
+    g_userContexts.push_front(entry);
+
+    while (g_userContexts.size() > USER_CONTEXT_CACHE_SIZE)
+        g_userContexts.pop_back();
+
+    return entry;
+}
+
+static bool is_valid_user_id(const char* userId) {
+
+    if (userId == nullptr || *userId == '\0') {
+        g_lastError = "User ID is null or empty.";
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Returns the license of a user, from its cache if fresh enough.
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_user_license(const char* userId, int64_t maxAgeMillis) {
+
+    CallSpan span(CALL_GET_USER_LICENSE, g_lastError);
+
+    try {
+
+        if (!is_valid_user_id(userId))
+            return nullptr;
+
+        const SpanClock::time_point apartmentStart = span.now();
+
+        init_apartment(apartment_type::single_threaded);
+
+        span.end_apartment(apartmentStart);
+
+        auto entry = acquire_user_context(userId);
+
+        auto snapshot = entry->history.current();
+
+        if (snapshot == nullptr || maxAgeMillis <= 0 ||
+            current_unix_epoch_millis() - snapshot->capturedAt > maxAgeMillis) {
+
+            const SpanClock::time_point storeStart = span.now();
+
+            LicenseSnapshot queried = query_license_snapshot(entry->context, false);
+
+            span.end_store(storeStart);
+
+            snapshot = entry->history.publish(std::move(queried));
+        }
+
+        span.set_add_on_count(snapshot->addOns.size());
+
+        const SpanClock::time_point marshalStart = span.now();
+
+        MsStoreLicenseV2Native* licensePointer = marshal_license(*snapshot);
+
+        span.end_marshal(marshalStart);
+
+        if (licensePointer == nullptr)
+            return nullptr;
+
+        g_lastError.clear();
+
+        return licensePointer;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return nullptr;
+}
+
+/*
+ * Queries the license of a user and returns the add-on changes since sinceGeneration.
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseChangesNative* msstore_winrt_get_user_license_changes(
+    const char* userId,
+    int64_t sinceGeneration
+) {
+
+    CallSpan span(CALL_GET_USER_LICENSE_CHANGES, g_lastError);
+
+    try {
+
+        if (!is_valid_user_id(userId))
+            return nullptr;
+
+        const SpanClock::time_point apartmentStart = span.now();
+
+        init_apartment(apartment_type::single_threaded);
+
+        span.end_apartment(apartmentStart);
+
+        auto entry = acquire_user_context(userId);
+
+        const SpanClock::time_point storeStart = span.now();
+
+        LicenseSnapshot queried = query_license_snapshot(entry->context, false);
+
+        span.end_store(storeStart);
+
+        entry->history.publish(std::move(queried));
+
+        LicenseSnapshotDiff diff = entry->history.diff_since(sinceGeneration);
+
+        span.set_add_on_count(diff.added.size() + diff.removed.size() + diff.changed.size());
+
+        const SpanClock::time_point marshalStart = span.now();
+
+        MsStoreLicenseChangesNative* changesPointer = marshal_license_changes(diff);
+
+        span.end_marshal(marshalStart);
+
+        if (changesPointer == nullptr)
+            return nullptr;
+
+        g_lastError.clear();
+
+        return changesPointer;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return nullptr;
+}
+
+/*
+ * Requests a purchase for the given Store ID on behalf of a user.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_request_user_purchase(const char* userId, const char* storeId) {
+
+    try {
+
+        if (!is_valid_user_id(userId))
+            return -1;
+
+        if (storeId == nullptr || *storeId == '\0') {
+            g_lastError = "Store ID is null or empty.";
+            return -1;
+        }
+
+        init_apartment(apartment_type::single_threaded);
+
+        auto entry = acquire_user_context(userId);
+
+        if (is_owned_in_snapshot(entry->history.current().get(), storeId)) {
+
+            const int64_t now = current_unix_epoch_millis();
+
+            log_purchase_attempt(storeId, now, now, 1 /* AlreadyPurchased */, 0, true, true);
+
+            g_lastError.clear();
+            return 1; /* AlreadyPurchased */
+        }
+
+        return request_purchase_in_context(entry->context, storeId, true);
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return -1;
+}
+
+/*
+ * Drops the cached context and license of a user.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_forget_user(const char* userId) {
+
+    if (userId == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_userContextsMutex);
+
+    g_userContexts.remove_if([userId](const std::shared_ptr<UserContextEntry>& entry) {
+        return entry->userId == userId;
+    });
+}
+
+void dump_user_state(DiagnosticsWriter& writer) {
+
+    std::lock_guard<std::mutex> lock(g_userContextsMutex);
+
+    writer.begin_object("users");
+    writer.add_number("cached", static_cast<int64_t>(g_userContexts.size()));
+    writer.add_number("capacity", static_cast<int64_t>(USER_CONTEXT_CACHE_SIZE));
+    writer.end_object();
+}
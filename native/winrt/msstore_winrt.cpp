@@ -1,13 +1,22 @@
 #include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_diagnostics.h"
+#include "msstore_snapshot.h"
 
 #include <windows.h>
 #include <objbase.h>
 #include <ShObjIdl_core.h>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <winrt/base.h>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Foundation.Collections.h>
@@ -22,7 +31,17 @@ using namespace Windows::Services::Store;
  * We use thread_local so that concurrent calls from different JVM threads do
  * not overwrite each other's error messages.
  */
-static thread_local std::string g_lastError;
+thread_local std::string g_lastError;
+
+/*
+ * Allocations handed out to callers and not freed yet, for diagnostics.
+ *
+ * A count that only grows means the caller leaks results.
+ */
+static std::atomic<int64_t> g_liveStrings { 0 };
+static std::atomic<int64_t> g_liveAddOnArrays { 0 };
+static std::atomic<int64_t> g_liveLicenses { 0 };
+static std::atomic<int64_t> g_liveLicenseChanges { 0 };
 
 /*
  * Allocates a UTF-8 string via CoTaskMemAlloc for cross-module ownership.
@@ -30,7 +49,7 @@ static thread_local std::string g_lastError;
  * CoTaskMemAlloc + CoTaskMemFree is the safest cross-DLL contract on Windows
  * when the caller is not compiled with the same CRT.
  */
-static const char* dup_string(const std::string& value) {
+const char* dup_string(const std::string& value) {
 
     const size_t size = value.size() + 1;
 
@@ -39,11 +58,18 @@ static const char* dup_string(const std::string& value) {
     if (buffer == nullptr)
         return nullptr;
 
+    g_liveStrings.fetch_add(1, std::memory_order_relaxed);
+
     std::memcpy(buffer, value.c_str(), size);
 
     return buffer;
 }
 
+/*
+ * Maximum snapshot age for answering purchase requests locally, 0 if disabled.
+ */
+static std::atomic<int64_t> g_purchaseShortCircuitMaxAgeMillis { 0 };
+
 /*
  * Maps StorePurchaseStatus into stable numeric codes exposed to the JVM.
  */
@@ -66,7 +92,7 @@ static int map_purchase_status(StorePurchaseStatus status) {
 }
 
 /* Converts a WinRT DateTime to Unix epoch milliseconds */
-static int64_t to_unix_epoch_millis(winrt::Windows::Foundation::DateTime dateTime) {
+int64_t to_unix_epoch_millis(winrt::Windows::Foundation::DateTime dateTime) {
 
     /* Convert WinRT DateTime (ticks since 1601) to system_clock time_point */
     const auto sysTime = winrt::clock::to_sys(dateTime);
@@ -77,6 +103,283 @@ static int64_t to_unix_epoch_millis(winrt::Windows::Foundation::DateTime dateTim
     ).count();
 }
 
+/* Returns the current wall-clock time as Unix epoch milliseconds */
+int64_t current_unix_epoch_millis() {
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+/*
+ * Converts a queried app license into a fingerprinted snapshot.
+ *
+ * Throws on WinRT errors; callers translate exceptions into g_lastError.
+ */
+LicenseSnapshot license_snapshot_from(const StoreAppLicense& license, bool keepExtendedJson) {
+
+    if (!license)
+        throw std::runtime_error("StoreAppLicense is null.");
+
+    LicenseSnapshot snapshot;
+
+    snapshot.skuStoreId = to_string(license.SkuStoreId());
+    snapshot.isActive = license.IsActive();
+    snapshot.isTrial = license.IsTrial();
+    snapshot.expirationDate = to_unix_epoch_millis(license.ExpirationDate());
+    snapshot.capturedAt = current_unix_epoch_millis();
+
+    auto addOnLicenses = license.AddOnLicenses();
+
+    snapshot.addOns.reserve(addOnLicenses.Size());
+
+    for (auto const& pair : addOnLicenses) {
+
+        auto const& addOn = pair.Value();
+
+        AddOnSnapshot addOnSnapshot;
+        addOnSnapshot.skuStoreId = to_string(addOn.SkuStoreId());
+        addOnSnapshot.inAppOfferToken = to_string(addOn.InAppOfferToken());
+        addOnSnapshot.expirationDate = to_unix_epoch_millis(addOn.ExpirationDate());
+
+        snapshot.addOns.push_back(std::move(addOnSnapshot));
+    }
+
+    /* Opt-in: keep ExtendedJsonData for on-demand field lookups. */
+    if (keepExtendedJson && is_extended_json_kept()) {
+
+        std::vector<std::pair<std::string, std::string>> addOnJson;
+        addOnJson.reserve(addOnLicenses.Size());
+
+        for (auto const& pair : addOnLicenses)
+            addOnJson.emplace_back(to_string(pair.Value().SkuStoreId()), to_string(pair.Value().ExtendedJsonData()));
+
+        keep_extended_json(to_string(license.ExtendedJsonData()), std::move(addOnJson));
+    }
+
+    fingerprint_snapshot(snapshot);
+
+    return snapshot;
+}
+
+/*
+ * Queries the app license through the given context and converts it into a
+ * fingerprinted snapshot.
+ *
+ * Blocks the calling thread; the default user's license goes through the
+ * coroutine engine instead (see refresh_license_snapshot()).
+ */
+LicenseSnapshot query_license_snapshot(const StoreContext& context, bool keepExtendedJson) {
+
+    return license_snapshot_from(context.GetAppLicenseAsync().get(), keepExtendedJson);
+}
+
+/*
+ * Copies add-on snapshots into a CoTaskMemAlloc'ed array of AddOnLicense
+ * (MsStoreAddOnLicenseNative or MsStoreAddOnLicenseV2Native).
+ *
+ * Returns nullptr for an empty list. On allocation failure returns nullptr
+ * as well; callers then report zero add-ons, as before.
+ */
+template <typename AddOnLicense>
+static AddOnLicense* marshal_addon_licenses(const std::vector<const AddOnSnapshot*>& addOns) {
+
+    if (addOns.empty())
+        return nullptr;
+
+    AddOnLicense* array = static_cast<AddOnLicense*>(
+        ::CoTaskMemAlloc(sizeof(AddOnLicense) * addOns.size()));
+
+    if (array == nullptr)
+        return nullptr;
+
+    g_liveAddOnArrays.fetch_add(1, std::memory_order_relaxed);
+
+    std::memset(array, 0, sizeof(AddOnLicense) * addOns.size());
+
+    for (size_t index = 0; index < addOns.size(); ++index) {
+
+        array[index].SkuStoreId = dup_string(addOns[index]->skuStoreId);
+        array[index].InAppOfferToken = dup_string(addOns[index]->inAppOfferToken);
+        array[index].ExpirationDate = addOns[index]->expirationDate;
+
+        if constexpr (std::is_same_v<AddOnLicense, MsStoreAddOnLicenseV2Native>)
+            array[index].Fingerprint = addOns[index]->fingerprint;
+    }
+
+    return array;
+}
+
+template <typename AddOnLicense>
+static void free_addon_licenses(AddOnLicense* array, int count) {
+
+    if (array == nullptr)
+        return;
+
+    for (int index = 0; index < count; ++index) {
+        msstore_winrt_free(array[index].SkuStoreId);
+        msstore_winrt_free(array[index].InAppOfferToken);
+    }
+
+    g_liveAddOnArrays.fetch_sub(1, std::memory_order_relaxed);
+
+    ::CoTaskMemFree(array);
+}
+
+/*
+ * Converts a snapshot into License (MsStoreLicenseNative or
+ * MsStoreLicenseV2Native). The legacy struct leaves out the fingerprints
+ * and the generation.
+ *
+ * Returns nullptr and sets g_lastError if the allocation fails.
+ */
+template <typename License>
+static License* marshal_license_as(const LicenseSnapshot& snapshot) {
+
+    using AddOnLicense = std::remove_pointer_t<decltype(License::AddOnLicenses)>;
+
+    License* licensePointer = static_cast<License*>(::CoTaskMemAlloc(sizeof(License)));
+
+    if (licensePointer == nullptr) {
+        g_lastError = "Out of memory allocating the license struct.";
+        return nullptr;
+    }
+
+    g_liveLicenses.fetch_add(1, std::memory_order_relaxed);
+
+    std::memset(licensePointer, 0, sizeof(License));
+
+    licensePointer->SkuStoreId = dup_string(snapshot.skuStoreId);
+    licensePointer->IsActive = snapshot.isActive;
+    licensePointer->IsTrial = snapshot.isTrial;
+    licensePointer->ExpirationDate = snapshot.expirationDate;
+
+    if constexpr (std::is_same_v<License, MsStoreLicenseV2Native>) {
+        licensePointer->Fingerprint = snapshot.fingerprint;
+        licensePointer->Generation = snapshot.generation;
+    }
+
+    std::vector<const AddOnSnapshot*> addOns;
+    addOns.reserve(snapshot.addOns.size());
+
+    for (auto const& addOn : snapshot.addOns)
+        addOns.push_back(&addOn);
+
+    licensePointer->AddOnLicenses = marshal_addon_licenses<AddOnLicense>(addOns);
+
+    if (licensePointer->AddOnLicenses != nullptr)
+        licensePointer->AddOnLicensesCount = static_cast<int>(addOns.size());
+
+    return licensePointer;
+}
+
+/*
+ * Converts a snapshot into the C struct handed out to callers.
+ *
+ * Returns nullptr and sets g_lastError if the allocation fails.
+ */
+MsStoreLicenseV2Native* marshal_license(const LicenseSnapshot& snapshot) {
+
+    return marshal_license_as<MsStoreLicenseV2Native>(snapshot);
+}
+
+std::shared_ptr<const LicenseSnapshot> publish_license_snapshot(LicenseSnapshot snapshot) {
+
+    auto published = publish_snapshot(std::move(snapshot));
+
+    broker_publish(*published);
+
+    return published;
+}
+
+/*
+ * Converts a snapshot diff into the C struct handed out to callers.
+ *
+ * Returns nullptr and sets g_lastError if the allocation fails.
+ */
+MsStoreLicenseChangesNative* marshal_license_changes(const LicenseSnapshotDiff& diff) {
+
+    MsStoreLicenseChangesNative* changesPointer =
+        static_cast<MsStoreLicenseChangesNative*>(::CoTaskMemAlloc(sizeof(MsStoreLicenseChangesNative)));
+
+    if (changesPointer == nullptr) {
+        g_lastError = "Out of memory allocating MsStoreLicenseChangesNative.";
+        return nullptr;
+    }
+
+    g_liveLicenseChanges.fetch_add(1, std::memory_order_relaxed);
+
+    std::memset(changesPointer, 0, sizeof(MsStoreLicenseChangesNative));
+
+    const LicenseSnapshot& current = *diff.current;
+
+    changesPointer->Generation = current.generation;
+    changesPointer->Fingerprint = current.fingerprint;
+    changesPointer->SkuStoreId = dup_string(current.skuStoreId);
+    changesPointer->ExpirationDate = current.expirationDate;
+    changesPointer->IsActive = current.isActive;
+    changesPointer->IsTrial = current.isTrial;
+    changesPointer->IsFullResync = diff.isFullResync;
+
+    changesPointer->Added = marshal_addon_licenses<MsStoreAddOnLicenseV2Native>(diff.added);
+    changesPointer->Removed = marshal_addon_licenses<MsStoreAddOnLicenseV2Native>(diff.removed);
+    changesPointer->Changed = marshal_addon_licenses<MsStoreAddOnLicenseV2Native>(diff.changed);
+
+    if (changesPointer->Added != nullptr)
+        changesPointer->AddedCount = static_cast<int>(diff.added.size());
+
+    if (changesPointer->Removed != nullptr)
+        changesPointer->RemovedCount = static_cast<int>(diff.removed.size());
+
+    if (changesPointer->Changed != nullptr)
+        changesPointer->ChangedCount = static_cast<int>(diff.changed.size());
+
+    return changesPointer;
+}
+
+/*
+ * Queries the license through the engine and marshals it as License, or
+ * returns nullptr on error.
+ */
+template <typename License>
+static License* get_license_as() {
+
+    CallSpan span(CALL_GET_LICENSE, g_lastError);
+
+    try {
+
+        RefreshTiming timing;
+
+        /* Joins a query already in flight instead of starting another one. */
+        auto snapshot = refresh_license_snapshot(&timing);
+
+        span.set_refresh(timing);
+        span.set_add_on_count(snapshot->addOns.size());
+
+        const SpanClock::time_point marshalStart = span.now();
+
+        License* licensePointer = marshal_license_as<License>(*snapshot);
+
+        span.end_marshal(marshalStart);
+
+        if (licensePointer == nullptr)
+            return nullptr;
+
+        g_lastError.clear();
+
+        return licensePointer;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return nullptr;
+}
+
 /*
  * Returns the StoreAppLicense information directly, or nullptr on error.
  *
@@ -85,18 +388,85 @@ static int64_t to_unix_epoch_millis(winrt::Windows::Foundation::DateTime dateTim
  */
 extern "C" MSSTORE_WINRT_API MsStoreLicenseNative* msstore_winrt_get_license() {
 
+    return get_license_as<MsStoreLicenseNative>();
+}
+
+/*
+ * Returns the license with fingerprints and the generation, or nullptr on error.
+ *
+ * Free the result with msstore_winrt_free_license_v2().
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_license_v2() {
+
+    return get_license_as<MsStoreLicenseV2Native>();
+}
+
+/*
+ * Returns the license from the last snapshot if fresh enough, otherwise queries it.
+ *
+ * Free the result with msstore_winrt_free_license_v2().
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_cached_license(int64_t maxAgeMillis) {
+
+    CallSpan span(CALL_GET_LICENSE, g_lastError);
+
+    try {
+
+        auto snapshot = current_snapshot();
+
+        if (snapshot == nullptr || maxAgeMillis <= 0 ||
+            current_unix_epoch_millis() - snapshot->capturedAt > maxAgeMillis) {
+
+            RefreshTiming timing;
+
+            snapshot = refresh_license_snapshot(&timing);
+
+            span.set_refresh(timing);
+        }
+
+        span.set_add_on_count(snapshot->addOns.size());
+
+        const SpanClock::time_point marshalStart = span.now();
+
+        MsStoreLicenseV2Native* licensePointer = marshal_license(*snapshot);
+
+        span.end_marshal(marshalStart);
+
+        if (licensePointer == nullptr)
+            return nullptr;
+
+        g_lastError.clear();
+
+        return licensePointer;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return nullptr;
+}
+
+/*
+ * Returns the license marshalled straight from StoreAppLicense, or nullptr on error.
+ *
+ * This is the code path of DLLs before license snapshots: no engine, no
+ * snapshot, no sorting and no fingerprints (Fingerprint and Generation stay
+ * 0). Shadow mode compares the snapshot paths against it.
+ *
+ * Free the result with msstore_winrt_free_license_v2().
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_license_direct() {
+
     try {
 
-        /*
-         * Initialize the apartment for the current thread as STA. This keeps
-         * the thread compatible with Store UI calls later on.
-         */
         init_apartment(apartment_type::single_threaded);
 
-        /* StoreContext::GetDefault uses the identity of the current package. */
         StoreContext context = StoreContext::GetDefault();
 
-        /* Bridge the async WinRT call into a synchronous result for the JVM. */
         StoreAppLicense license = context.GetAppLicenseAsync().get();
 
         if (!license) {
@@ -104,15 +474,17 @@ extern "C" MSSTORE_WINRT_API MsStoreLicenseNative* msstore_winrt_get_license() {
             return nullptr;
         }
 
-        MsStoreLicenseNative* licensePointer =
-            static_cast<MsStoreLicenseNative*>(::CoTaskMemAlloc(sizeof(MsStoreLicenseNative)));
+        MsStoreLicenseV2Native* licensePointer =
+            static_cast<MsStoreLicenseV2Native*>(::CoTaskMemAlloc(sizeof(MsStoreLicenseV2Native)));
 
         if (licensePointer == nullptr) {
-            g_lastError = "Out of memory allocating MsStoreLicenseNative.";
+            g_lastError = "Out of memory allocating MsStoreLicenseV2Native.";
             return nullptr;
         }
 
-        std::memset(licensePointer, 0, sizeof(MsStoreLicenseNative));
+        g_liveLicenses.fetch_add(1, std::memory_order_relaxed);
+
+        std::memset(licensePointer, 0, sizeof(MsStoreLicenseV2Native));
 
         licensePointer->SkuStoreId = dup_string(to_string(license.SkuStoreId()));
         licensePointer->IsActive = license.IsActive();
@@ -120,33 +492,37 @@ extern "C" MSSTORE_WINRT_API MsStoreLicenseNative* msstore_winrt_get_license() {
         licensePointer->ExpirationDate = to_unix_epoch_millis(license.ExpirationDate());
 
         auto addOnLicenses = license.AddOnLicenses();
-        licensePointer->AddOnLicensesCount = static_cast<int>(addOnLicenses.Size());
 
-        if (licensePointer->AddOnLicensesCount > 0) {
+        const int addOnCount = static_cast<int>(addOnLicenses.Size());
 
-            licensePointer->AddOnLicenses = static_cast<MsStoreAddOnLicenseNative*>(
-                ::CoTaskMemAlloc(sizeof(MsStoreAddOnLicenseNative) * licensePointer->AddOnLicensesCount));
+        if (addOnCount > 0) {
 
-            if (licensePointer->AddOnLicenses == nullptr) {
+            licensePointer->AddOnLicenses = static_cast<MsStoreAddOnLicenseV2Native*>(
+                ::CoTaskMemAlloc(sizeof(MsStoreAddOnLicenseV2Native) * addOnCount));
 
-                licensePointer->AddOnLicensesCount = 0;
+            if (licensePointer->AddOnLicenses != nullptr) {
 
-            } else {
+                g_liveAddOnArrays.fetch_add(1, std::memory_order_relaxed);
 
-                std::memset(licensePointer->AddOnLicenses, 0,
-                            sizeof(MsStoreAddOnLicenseNative) * licensePointer->AddOnLicensesCount);
+                std::memset(licensePointer->AddOnLicenses, 0, sizeof(MsStoreAddOnLicenseV2Native) * addOnCount);
+
+                licensePointer->AddOnLicensesCount = addOnCount;
 
                 int index = 0;
+
                 for (auto const& pair : addOnLicenses) {
+
+                    if (index == addOnCount)
+                        break;
+
                     auto const& addOn = pair.Value();
+
                     licensePointer->AddOnLicenses[index].SkuStoreId = dup_string(to_string(addOn.SkuStoreId()));
                     licensePointer->AddOnLicenses[index].InAppOfferToken = dup_string(to_string(addOn.InAppOfferToken()));
                     licensePointer->AddOnLicenses[index].ExpirationDate = to_unix_epoch_millis(addOn.ExpirationDate());
                     index++;
                 }
             }
-        } else {
-            licensePointer->AddOnLicenses = nullptr;
         }
 
         g_lastError.clear();
@@ -164,6 +540,252 @@ extern "C" MSSTORE_WINRT_API MsStoreLicenseNative* msstore_winrt_get_license() {
     return nullptr;
 }
 
+/*
+ * Queries the license and returns the add-on changes since sinceGeneration.
+ *
+ * The returned pointer and all nested strings/arrays are allocated with
+ * CoTaskMemAlloc and must be released via msstore_winrt_free_license_changes().
+ */
+extern "C" MSSTORE_WINRT_API MsStoreLicenseChangesNative* msstore_winrt_get_license_changes(int64_t sinceGeneration) {
+
+    CallSpan span(CALL_GET_LICENSE_CHANGES, g_lastError);
+
+    try {
+
+        RefreshTiming timing;
+
+        refresh_license_snapshot(&timing);
+
+        span.set_refresh(timing);
+
+        /* A concurrent query may have published in between; diff whatever is current. */
+        LicenseSnapshotDiff diff = diff_snapshot_since(sinceGeneration);
+
+        span.set_add_on_count(diff.added.size() + diff.removed.size() + diff.changed.size());
+
+        const SpanClock::time_point marshalStart = span.now();
+
+        MsStoreLicenseChangesNative* changesPointer = marshal_license_changes(diff);
+
+        span.end_marshal(marshalStart);
+
+        if (changesPointer == nullptr)
+            return nullptr;
+
+        g_lastError.clear();
+
+        return changesPointer;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return nullptr;
+}
+
+/* Returns whether skuStoreId ("9NBLGGH4R315/0010") belongs to storeId. */
+static bool sku_matches_store_id(const std::string& skuStoreId, std::string_view storeId) {
+
+    return skuStoreId.compare(0, storeId.size(), storeId) == 0 &&
+           (skuStoreId.size() == storeId.size() || skuStoreId[storeId.size()] == '/');
+}
+
+bool is_owned_in_snapshot(const LicenseSnapshot* snapshot, const char* storeId) {
+
+    const int64_t maxAgeMillis = g_purchaseShortCircuitMaxAgeMillis.load(std::memory_order_relaxed);
+
+    if (maxAgeMillis <= 0 || snapshot == nullptr)
+        return false;
+
+    const int64_t now = current_unix_epoch_millis();
+
+    if (now - snapshot->capturedAt > maxAgeMillis)
+        return false;
+
+    const std::string_view id(storeId);
+
+    /* The full app license, not a trial, counts as owned for the app's own Store ID. */
+    if (sku_matches_store_id(snapshot->skuStoreId, id))
+        return snapshot->isActive && !snapshot->isTrial && snapshot->expirationDate > now;
+
+    for (auto const& addOn : snapshot->addOns)
+        if (sku_matches_store_id(addOn.skuStoreId, id))
+            return addOn.expirationDate > now;
+
+    return false;
+}
+
+/*
+ * Purchase context prepared by msstore_winrt_prepare_purchase(), bound to
+ * its owner window. Guarded by g_preparedPurchaseMutex, which is only held
+ * to copy or replace it.
+ *
+ * prefetch keeps the product query alive; nobody waits for it, it only
+ * warms the Store's product cache for the dialog.
+ */
+struct PreparedPurchase {
+    StoreContext context { nullptr };
+    HWND ownerWindow = nullptr;
+    Windows::Foundation::IAsyncOperation<StoreProductQueryResult> prefetch { nullptr };
+    std::string prefetchedStoreId;
+    int64_t preparedAt = 0;
+};
+
+static std::mutex g_preparedPurchaseMutex;
+static PreparedPurchase g_preparedPurchase;
+static std::atomic<int64_t> g_preparedPurchasesUsed { 0 };
+
+/*
+ * Shows the Store purchase UI of a context whose owner window is set.
+ *
+ * Returns the mapped status code, or -1 with g_lastError set. Throws on
+ * WinRT errors.
+ */
+static int show_purchase_dialog(const StoreContext& context, const char* storeId, bool forUser) {
+
+    const int64_t dialogOpenedAt = current_unix_epoch_millis();
+
+    StorePurchaseResult result { nullptr };
+
+    try {
+
+        result = context.RequestPurchaseAsync(to_hstring(std::string_view(storeId))).get();
+
+    } catch (const hresult_error& ex) {
+
+        log_purchase_attempt(storeId, dialogOpenedAt, current_unix_epoch_millis(), -1, ex.code().value, false, forUser);
+
+        throw;
+    }
+
+    const int64_t dialogClosedAt = current_unix_epoch_millis();
+
+    if (!result) {
+
+        log_purchase_attempt(storeId, dialogOpenedAt, dialogClosedAt, -1, 0, false, forUser);
+
+        g_lastError = "StorePurchaseResult is null.";
+        return -1;
+    }
+
+    const int statusCode = map_purchase_status(result.Status());
+
+    log_purchase_attempt(storeId, dialogOpenedAt, dialogClosedAt, statusCode, result.ExtendedError().value, false, forUser);
+
+    g_lastError.clear();
+
+    return statusCode;
+}
+
+/*
+ * Shows the Store purchase UI of the given context for storeId, owned by
+ * the foreground window.
+ *
+ * Returns the mapped status code, or -1 with g_lastError set. Throws on
+ * WinRT errors.
+ */
+int request_purchase_in_context(const StoreContext& context, const char* storeId, bool forUser) {
+
+    HWND ownerWindow = ::GetForegroundWindow();
+
+    if (ownerWindow == nullptr) {
+
+        const int64_t now = current_unix_epoch_millis();
+
+        log_purchase_attempt(storeId, now, now, -1, 0, false, forUser);
+
+        g_lastError = "No foreground window handle available for Store UI.";
+        return -1;
+    }
+
+    /*
+     * Desktop apps must provide an owner HWND for Store modal UI.
+     * This avoids ERROR_INVALID_WINDOW_HANDLE and UI-thread errors.
+     */
+    auto initWindow = context.as<IInitializeWithWindow>();
+    initWindow->Initialize(ownerWindow);
+
+    return show_purchase_dialog(context, storeId, forUser);
+}
+
+/*
+ * Returns the prepared purchase context, or nullptr if there is none or its
+ * window is gone.
+ */
+static StoreContext take_prepared_context() {
+
+    std::lock_guard<std::mutex> lock(g_preparedPurchaseMutex);
+
+    if (!g_preparedPurchase.context)
+        return nullptr;
+
+    if (!::IsWindow(g_preparedPurchase.ownerWindow)) {
+        g_preparedPurchase = PreparedPurchase();
+        return nullptr;
+    }
+
+    return g_preparedPurchase.context;
+}
+
+/*
+ * Prepares purchases for the given owner window.
+ */
+extern "C" MSSTORE_WINRT_API int msstore_winrt_prepare_purchase(void* windowHandle, const char* storeId) {
+
+    try {
+
+        HWND ownerWindow = static_cast<HWND>(windowHandle);
+
+        if (ownerWindow == nullptr || !::IsWindow(ownerWindow)) {
+            g_lastError = "Window handle is null or not a window.";
+            return -1;
+        }
+
+        init_apartment(apartment_type::single_threaded);
+
+        PreparedPurchase prepared;
+        prepared.ownerWindow = ownerWindow;
+        prepared.preparedAt = current_unix_epoch_millis();
+        prepared.context = StoreContext::GetDefault();
+
+        prepared.context.as<IInitializeWithWindow>()->Initialize(ownerWindow);
+
+        if (storeId != nullptr && *storeId != '\0') {
+
+            /* Starts the query without waiting; the operation object keeps it running. */
+            prepared.prefetch = prepared.context.GetStoreProductsAsync(
+                { L"Application", L"Game", L"Durable", L"Consumable", L"UnmanagedConsumable" },
+                { to_hstring(std::string_view(storeId)) }
+            );
+
+            prepared.prefetchedStoreId = storeId;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_preparedPurchaseMutex);
+
+            g_preparedPurchase = std::move(prepared);
+        }
+
+        g_lastError.clear();
+
+        return 0;
+
+    } catch (const hresult_error& ex) {
+        g_lastError = to_string(ex.message());
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return -1;
+}
+
 /*
  * Requests a purchase for the given Store ID.
  *
@@ -178,35 +800,41 @@ extern "C" MSSTORE_WINRT_API int msstore_winrt_request_purchase(const char* stor
             return -1;
         }
 
-        init_apartment(apartment_type::single_threaded);
+        /* Skip the modal Store UI if a fresh snapshot already shows the product as owned. */
+        if (is_owned_in_snapshot(current_snapshot().get(), storeId)) {
 
-        StoreContext context = StoreContext::GetDefault();
+            const int64_t now = current_unix_epoch_millis();
+            const int statusCode = map_purchase_status(StorePurchaseStatus::AlreadyPurchased);
 
-        HWND ownerWindow = ::GetForegroundWindow();
+            log_purchase_attempt(storeId, now, now, statusCode, 0, true, false);
 
-        if (ownerWindow == nullptr) {
-            g_lastError = "No foreground window handle available for Store UI.";
-            return -1;
+            g_lastError.clear();
+            return statusCode;
         }
 
-        /*
-         * Desktop apps must provide an owner HWND for Store modal UI.
-         * This avoids ERROR_INVALID_WINDOW_HANDLE and UI-thread errors.
-         */
-        auto initWindow = context.as<IInitializeWithWindow>();
-        initWindow->Initialize(ownerWindow);
+        init_apartment(apartment_type::single_threaded);
+
+        int statusCode;
 
-        StorePurchaseResult result =
-            context.RequestPurchaseAsync(to_hstring(std::string_view(storeId))).get();
+        /* A prepared context already has its owner window; only the dialog is left. */
+        if (StoreContext prepared = take_prepared_context()) {
 
-        if (!result) {
-            g_lastError = "StorePurchaseResult is null.";
-            return -1;
+            g_preparedPurchasesUsed.fetch_add(1, std::memory_order_relaxed);
+
+            statusCode = show_purchase_dialog(prepared, storeId, false);
+
+        } else {
+
+            StoreContext context = StoreContext::GetDefault();
+
+            statusCode = request_purchase_in_context(context, storeId, false);
         }
 
-        g_lastError.clear();
+        /* Bring the snapshot up to date in the background, e.g. for the short-circuit. */
+        if (statusCode == map_purchase_status(StorePurchaseStatus::Succeeded))
+            refresh_license_snapshot_async();
 
-        return map_purchase_status(result.Status());
+        return statusCode;
 
     } catch (const hresult_error& ex) {
         g_lastError = to_string(ex.message());
@@ -219,25 +847,61 @@ extern "C" MSSTORE_WINRT_API int msstore_winrt_request_purchase(const char* stor
     return -1;
 }
 
+/*
+ * Enables answering purchase requests from a fresh license snapshot.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_set_purchase_short_circuit(int64_t maxAgeMillis) {
+
+    g_purchaseShortCircuitMaxAgeMillis.store(maxAgeMillis > 0 ? maxAgeMillis : 0, std::memory_order_relaxed);
+}
+
+template <typename License>
+static void free_license_as(License* pointer) {
+
+    if (pointer == nullptr)
+        return;
+
+    msstore_winrt_free(pointer->SkuStoreId);
+
+    free_addon_licenses(pointer->AddOnLicenses, pointer->AddOnLicensesCount);
+
+    g_liveLicenses.fetch_sub(1, std::memory_order_relaxed);
+
+    ::CoTaskMemFree(pointer);
+}
+
 /*
  * Frees memory allocated by msstore_winrt_get_license().
  */
 extern "C" MSSTORE_WINRT_API void msstore_winrt_free_license(MsStoreLicenseNative* pointer) {
 
+    free_license_as(pointer);
+}
+
+/*
+ * Frees memory allocated by msstore_winrt_get_license_v2() and the other
+ * calls returning MsStoreLicenseV2Native.
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_free_license_v2(MsStoreLicenseV2Native* pointer) {
+
+    free_license_as(pointer);
+}
+
+/*
+ * Frees memory allocated by msstore_winrt_get_license_changes().
+ */
+extern "C" MSSTORE_WINRT_API void msstore_winrt_free_license_changes(MsStoreLicenseChangesNative* pointer) {
+
     if (pointer == nullptr)
         return;
 
     msstore_winrt_free(pointer->SkuStoreId);
 
-    if (pointer->AddOnLicenses != nullptr) {
-
-        for (int index = 0; index < pointer->AddOnLicensesCount; ++index) {
-            msstore_winrt_free(pointer->AddOnLicenses[index].SkuStoreId);
-            msstore_winrt_free(pointer->AddOnLicenses[index].InAppOfferToken);
-        }
+    free_addon_licenses(pointer->Added, pointer->AddedCount);
+    free_addon_licenses(pointer->Removed, pointer->RemovedCount);
+    free_addon_licenses(pointer->Changed, pointer->ChangedCount);
 
-        ::CoTaskMemFree(pointer->AddOnLicenses);
-    }
+    g_liveLicenseChanges.fetch_sub(1, std::memory_order_relaxed);
 
     ::CoTaskMemFree(pointer);
 }
@@ -247,8 +911,12 @@ extern "C" MSSTORE_WINRT_API void msstore_winrt_free_license(MsStoreLicenseNativ
  */
 extern "C" MSSTORE_WINRT_API void msstore_winrt_free(const char* pointer) {
 
-    if (pointer != nullptr)
-        ::CoTaskMemFree(reinterpret_cast<LPVOID>(const_cast<char*>(pointer)));
+    if (pointer == nullptr)
+        return;
+
+    g_liveStrings.fetch_sub(1, std::memory_order_relaxed);
+
+    ::CoTaskMemFree(reinterpret_cast<LPVOID>(const_cast<char*>(pointer)));
 }
 
 /*
@@ -257,3 +925,30 @@ extern "C" MSSTORE_WINRT_API void msstore_winrt_free(const char* pointer) {
 extern "C" MSSTORE_WINRT_API const char* msstore_winrt_get_last_error() {
     return dup_string(g_lastError);
 }
+
+void dump_allocation_state(DiagnosticsWriter& writer) {
+
+    writer.begin_object("allocations");
+    writer.add_number("strings", g_liveStrings.load(std::memory_order_relaxed));
+    writer.add_number("addOnArrays", g_liveAddOnArrays.load(std::memory_order_relaxed));
+    writer.add_number("licenses", g_liveLicenses.load(std::memory_order_relaxed));
+    writer.add_number("licenseChanges", g_liveLicenseChanges.load(std::memory_order_relaxed));
+    writer.end_object();
+
+    writer.begin_object("purchase");
+    writer.add_number("shortCircuitMaxAgeMillis", g_purchaseShortCircuitMaxAgeMillis.load(std::memory_order_relaxed));
+    writer.add_number("preparedUsed", g_preparedPurchasesUsed.load(std::memory_order_relaxed));
+
+    {
+        std::lock_guard<std::mutex> lock(g_preparedPurchaseMutex);
+
+        writer.add_bool("prepared", static_cast<bool>(g_preparedPurchase.context));
+
+        if (g_preparedPurchase.context) {
+            writer.add_number("preparedAt", g_preparedPurchase.preparedAt);
+            writer.add_string("prefetchedStoreId", g_preparedPurchase.prefetchedStoreId);
+        }
+    }
+
+    writer.end_object();
+}
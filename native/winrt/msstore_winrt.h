@@ -1,12 +1,18 @@
 #pragma once
 
-#include <cstdint>
+#ifdef __cplusplus
+  #include <cstdint>
+#else
+  #include <stdbool.h>
+  #include <stdint.h>
+#endif
 
 /*
  * C ABI surface for the msstore_winrt.dll.
  *
  * This header intentionally exposes a C-compatible interface so the JVM can
- * call into the DLL via FFM without C++ name mangling issues.
+ * call into the DLL via FFM without C++ name mangling issues. It also
+ * compiles as plain C, e.g. for Kotlin/Native cinterop.
  *
  * Memory ownership contract:
  * - All returned strings are UTF-8 and allocated with CoTaskMemAlloc.
@@ -23,7 +29,93 @@
   #define MSSTORE_WINRT_API
 #endif
 
+/*
+ * ABI version of this header. Version 1 is the original five-function ABI
+ * without msstore_winrt_get_abi_info().
+ */
+#define MSSTORE_WINRT_ABI_VERSION 2
+
+/*
+ * Capability bits reported by msstore_winrt_get_abi_info().
+ *
+ * Callers bind the functions of a capability only if its bit is set, so a
+ * newer caller keeps working with an older DLL.
+ */
+
+/*
+ * Reserved for asynchronous license calls with completion callbacks. Not
+ * reported yet: the engine only backs the synchronous exports so far.
+ */
+#define MSSTORE_WINRT_CAP_ASYNC (1ULL << 0)
+
+/* Packed binary export of the license into a caller buffer, msstore_winrt_export_license(). */
+#define MSSTORE_WINRT_CAP_PACKED_BLOB (1ULL << 1)
+
+/* License snapshots with fingerprints and generations, msstore_winrt_get_license_changes(). */
+#define MSSTORE_WINRT_CAP_CACHE (1ULL << 2)
+
+/* Update installation progress events, msstore_winrt_wait_update_progress(). */
+#define MSSTORE_WINRT_CAP_EVENTS (1ULL << 3)
+
+/* Background update checker. */
+#define MSSTORE_WINRT_CAP_UPDATE_CHECKER (1ULL << 4)
+
+/* On-demand ExtendedJsonData field lookup. */
+#define MSSTORE_WINRT_CAP_EXTENDED_JSON (1ULL << 5)
+
+/* Cross-process license broker. */
+#define MSSTORE_WINRT_CAP_BROKER (1ULL << 6)
+
+/* Per-user StoreContexts. */
+#define MSSTORE_WINRT_CAP_USERS (1ULL << 7)
+
+/* Purchase short-circuit from a fresh license snapshot. */
+#define MSSTORE_WINRT_CAP_PURCHASE_SHORT_CIRCUIT (1ULL << 8)
+
+/* msstore_winrt_dump_state(). */
+#define MSSTORE_WINRT_CAP_DIAGNOSTICS (1ULL << 9)
+
+/* Slow-call records, msstore_winrt_read_slow_calls(). */
+#define MSSTORE_WINRT_CAP_SLOW_CALLS (1ULL << 10)
+
+/* Memory-mapped purchase attempt log, msstore_winrt_purchase_log_open(). */
+#define MSSTORE_WINRT_CAP_PURCHASE_LOG (1ULL << 11)
+
+/* Background license refresher and msstore_winrt_get_cached_license(). */
+#define MSSTORE_WINRT_CAP_REFRESHER (1ULL << 12)
+
+/* Purchases prepared for an explicit owner window, msstore_winrt_prepare_purchase(). */
+#define MSSTORE_WINRT_CAP_PREPARED_PURCHASE (1ULL << 13)
+
+/* The license without snapshots, msstore_winrt_get_license_direct(), for shadow mode. */
+#define MSSTORE_WINRT_CAP_DIRECT_LICENSE (1ULL << 14)
+
+/* Fingerprinted license structs, msstore_winrt_get_license_v2() and msstore_winrt_free_license_v2(). */
+#define MSSTORE_WINRT_CAP_LICENSE_V2 (1ULL << 15)
+
+/*
+ * Schema ID written by msstore_winrt_export_license(). Bumped whenever keys
+ * change meaning; new keys may be added without a bump.
+ */
+#define MSSTORE_WINRT_LICENSE_EXPORT_SCHEMA 1
+
+/*
+ * Indices into MsStoreAbiInfoNative.StructLayoutHashes. Only ever appended.
+ */
+#define MSSTORE_WINRT_STRUCT_ADD_ON_LICENSE 0
+#define MSSTORE_WINRT_STRUCT_LICENSE 1
+#define MSSTORE_WINRT_STRUCT_LICENSE_CHANGES 2
+#define MSSTORE_WINRT_STRUCT_PENDING_UPDATES 3
+#define MSSTORE_WINRT_STRUCT_UPDATE_PROGRESS 4
+#define MSSTORE_WINRT_STRUCT_SLOW_CALL 5
+#define MSSTORE_WINRT_STRUCT_PURCHASE_ATTEMPT 6
+#define MSSTORE_WINRT_STRUCT_ADD_ON_LICENSE_V2 7
+#define MSSTORE_WINRT_STRUCT_LICENSE_V2 8
+#define MSSTORE_WINRT_STRUCT_LAYOUT_SLOTS 16
+
+#ifdef __cplusplus
 extern "C" {
+#endif
 
     /*
      * C-compatible structures for Microsoft Store license data.
@@ -34,6 +126,11 @@ extern "C" {
      * Note: All strings are UTF-8 and must be freed via msstore_winrt_free().
      */
 
+    /*
+     * MsStoreAddOnLicenseNative and MsStoreLicenseNative are the structs of
+     * msstore_winrt_get_license() and must never change: callers built
+     * against the original header read them with these exact layouts.
+     */
     typedef struct {
         const char* SkuStoreId;
         const char* InAppOfferToken;
@@ -49,6 +146,196 @@ extern "C" {
         int AddOnLicensesCount;
     } MsStoreLicenseNative;
 
+    /*
+     * MsStoreAddOnLicenseNative with a fingerprint.
+     *
+     * Fingerprint is a stable 64-bit hash over all fields of the add-on.
+     */
+    typedef struct {
+        const char* SkuStoreId;
+        const char* InAppOfferToken;
+        int64_t ExpirationDate;
+        uint64_t Fingerprint;
+    } MsStoreAddOnLicenseV2Native;
+
+    /*
+     * MsStoreLicenseNative with a fingerprint and a generation, returned by
+     * msstore_winrt_get_license_v2() and all later license calls.
+     *
+     * Fingerprint is a stable 64-bit hash over the app license fields and all
+     * add-on fingerprints. Generation starts at 1 and only advances when the
+     * fingerprint changes between two license queries.
+     *
+     * Add-on licenses are sorted by SkuStoreId.
+     */
+    typedef struct {
+        const char* SkuStoreId;
+        bool IsActive;
+        bool IsTrial;
+        int64_t ExpirationDate;
+        MsStoreAddOnLicenseV2Native* AddOnLicenses;
+        int AddOnLicensesCount;
+        uint64_t Fingerprint;
+        int64_t Generation;
+    } MsStoreLicenseV2Native;
+
+    /*
+     * Add-on changes between a previous license generation and the current one.
+     *
+     * The app license fields always describe the current license. Removed
+     * entries describe the add-on as it was in the previous generation.
+     *
+     * IsFullResync is set when the previous generation is unknown (too old or
+     * never seen). All current add-ons are then listed as added.
+     */
+    typedef struct {
+        int64_t Generation;
+        uint64_t Fingerprint;
+        const char* SkuStoreId;
+        int64_t ExpirationDate;
+        bool IsActive;
+        bool IsTrial;
+        bool IsFullResync;
+        MsStoreAddOnLicenseV2Native* Added;
+        int AddedCount;
+        MsStoreAddOnLicenseV2Native* Removed;
+        int RemovedCount;
+        MsStoreAddOnLicenseV2Native* Changed;
+        int ChangedCount;
+    } MsStoreLicenseChangesNative;
+
+    /*
+     * Cached result of the background package update check.
+     *
+     * Generation is 0 until the first check completed and is incremented on
+     * every completed check (successful or not).
+     */
+    typedef struct {
+        int64_t Generation;
+        int64_t CheckedAt;
+        int UpdateCount;
+        int MandatoryUpdateCount;
+        bool LastCheckFailed;
+    } MsStorePendingUpdatesNative;
+
+    /*
+     * One progress record of a running package update installation.
+     *
+     * State maps to StorePackageUpdateState:
+     * 0 = Pending
+     * 1 = Downloading
+     * 2 = Deploying
+     * 3 = Completed
+     * 4 = Canceled
+     * 5 = OtherError
+     * 6 = ErrorLowBattery
+     * 7 = ErrorWiFiRecommended
+     * 8 = ErrorWiFiRequired
+     *
+     * The last record of an installation has IsFinal set and carries the
+     * overall state. PackageFamilyName is empty for that record.
+     */
+    typedef struct {
+        uint64_t PackageBytesDownloaded;
+        uint64_t PackageDownloadSizeInBytes;
+        double PackageDownloadProgress;
+        double TotalDownloadProgress;
+        int State;
+        bool IsFinal;
+        char PackageFamilyName[128];
+    } MsStoreUpdateProgressNative;
+
+    /*
+     * Phase breakdown of one license call that took longer than the
+     * slow-call threshold.
+     *
+     * Operation:
+     * 1 = msstore_winrt_get_license
+     * 2 = msstore_winrt_get_license_changes
+     * 3 = msstore_winrt_get_user_license
+     * 4 = msstore_winrt_get_user_license_changes
+     * 5 = msstore_winrt_broker_read_license
+     *
+     * StartedAt is a Unix epoch timestamp in milliseconds, all other times
+     * are microseconds. QueueWaitMicros and StoreMicros belong to the Store
+     * query the call waited for; Joined is set if that query was already in
+     * flight when the call arrived. JvmDecodeMicros is only set for records
+     * committed with msstore_winrt_commit_slow_call(). Error is the error
+     * message, truncated, if Failed is set.
+     */
+    typedef struct {
+        int64_t Sequence;
+        int64_t StartedAt;
+        int64_t TotalMicros;
+        int64_t QueueWaitMicros;
+        int64_t ApartmentMicros;
+        int64_t StoreMicros;
+        int64_t MarshalMicros;
+        int64_t JvmDecodeMicros;
+        int Operation;
+        int AddOnCount;
+        bool Failed;
+        bool Joined;
+        char Error[128];
+    } MsStoreSlowCallNative;
+
+    /*
+     * One purchase attempt in the purchase log.
+     *
+     * DialogOpenedAt and DialogClosedAt are Unix epoch timestamps in
+     * milliseconds taken right before the Store purchase UI was requested
+     * and after it returned. For short-circuited attempts, which never show
+     * the UI, both are the time of the attempt.
+     *
+     * Status is the purchase status code as returned by
+     * msstore_winrt_request_purchase(), or -1 if the attempt failed. HResult
+     * is the extended error of the purchase result or the error of a failed
+     * attempt, 0 if there was none. RetryCount is the number of attempts for
+     * the same StoreId since its last successful one (in this process).
+     */
+    typedef struct {
+        int64_t Sequence;
+        int64_t DialogOpenedAt;
+        int64_t DialogClosedAt;
+        int Status;
+        int HResult;
+        int RetryCount;
+        bool ShortCircuited;
+        bool ForUser;
+        char StoreId[24];
+    } MsStorePurchaseAttemptNative;
+
+    /*
+     * Describes the ABI of the loaded DLL.
+     *
+     * Layouts are hashed with 64-bit FNV-1a over the struct size and then
+     * every field offset, each as 4 little-endian bytes.
+     *
+     * LayoutHash covers MsStoreAddOnLicenseNative followed by
+     * MsStoreLicenseNative, the structs of msstore_winrt_get_license().
+     * Callers compare it with their own expectation before reading a license.
+     *
+     * StructLayoutHashes holds the hash of each struct on its own, indexed by
+     * MSSTORE_WINRT_STRUCT_*; 0 for structs this DLL doesn't have. Callers
+     * check the one struct they are about to read, so a DLL that lacks or
+     * changed an unrelated struct still serves everything else.
+     */
+    typedef struct {
+        uint32_t AbiVersion;
+        uint32_t StructSize;
+        uint64_t LayoutHash;
+        uint64_t Capabilities;
+        uint64_t StructLayoutHashes[MSSTORE_WINRT_STRUCT_LAYOUT_SLOTS];
+    } MsStoreAbiInfoNative;
+
+    /*
+     * Returns the ABI description of this DLL.
+     *
+     * The pointer refers to static memory and must not be freed. Fields may
+     * be appended in later versions; StructSize tells how many are present.
+     */
+    MSSTORE_WINRT_API const MsStoreAbiInfoNative* msstore_winrt_get_abi_info();
+
     /*
      * Returns the current app license information.
      *
@@ -59,6 +346,52 @@ extern "C" {
      */
     MSSTORE_WINRT_API MsStoreLicenseNative* msstore_winrt_get_license();
 
+    /*
+     * Returns the current app license information with fingerprints and the
+     * generation, otherwise like msstore_winrt_get_license().
+     *
+     * The caller must release the result using msstore_winrt_free_license_v2().
+     */
+    MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_license_v2();
+
+    /*
+     * Returns the license from the last snapshot if it is at most
+     * maxAgeMillis old, otherwise queries it like msstore_winrt_get_license_v2().
+     *
+     * With the background license refresher running, most calls are
+     * answered without waiting for the Store. 0 always queries.
+     *
+     * The caller must release the result using msstore_winrt_free_license_v2().
+     */
+    MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_cached_license(int64_t maxAgeMillis);
+
+    /*
+     * Queries the current app license and marshals it straight from the
+     * Store's result, bypassing the engine and the snapshots: the code path
+     * of DLLs without snapshots. Add-ons come in the Store's order, and
+     * Fingerprint and Generation are 0.
+     *
+     * Meant as a reference for comparisons (shadow mode), not for regular
+     * reads: every call blocks on its own Store query.
+     *
+     * The caller must release the result using msstore_winrt_free_license_v2().
+     */
+    MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_license_direct();
+
+    /*
+     * Queries the current app license and returns the changes since the given
+     * generation.
+     *
+     * If nothing changed, Generation equals sinceGeneration and all lists are
+     * empty. Pass 0 to get a full resync.
+     *
+     * On success: returns a non-null pointer to MsStoreLicenseChangesNative.
+     * The caller must release it using msstore_winrt_free_license_changes().
+     * On failure: returns nullptr. Use msstore_winrt_get_last_error() to read
+     * the error message.
+     */
+    MSSTORE_WINRT_API MsStoreLicenseChangesNative* msstore_winrt_get_license_changes(int64_t sinceGeneration);
+
     /*
      * Requests a purchase for the given Store ID.
      *
@@ -75,11 +408,366 @@ extern "C" {
      */
     MSSTORE_WINRT_API int msstore_winrt_request_purchase(const char* storeId);
 
+    /*
+     * Enables or disables the purchase short-circuit.
+     *
+     * With maxAgeMillis > 0, purchase requests first consult the last license
+     * snapshot. If it is at most maxAgeMillis old and shows the product as
+     * owned and unexpired, 1 (AlreadyPurchased) is returned right away
+     * without showing the Store UI. Pass 0 to disable (the default).
+     */
+    MSSTORE_WINRT_API void msstore_winrt_set_purchase_short_circuit(int64_t maxAgeMillis);
+
+    /*
+     * Prepares purchases for the given owner window (an HWND).
+     *
+     * Creates the StoreContext, binds it to windowHandle and keeps it, so a
+     * later msstore_winrt_request_purchase() only has to open the dialog and
+     * no longer guesses the owner from the foreground window. If storeId is
+     * not null, the product is queried in the background to warm the Store's
+     * cache. The prepared context is dropped once the window is destroyed;
+     * calling again replaces it.
+     *
+     * Call on the thread that later requests the purchase.
+     *
+     * Returns 0 on success, or -1 if windowHandle is not a window or the
+     * context could not be created.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_prepare_purchase(void* windowHandle, const char* storeId);
+
+    /*
+     * Starts (or restarts) the background package update checker.
+     *
+     * The checker calls GetAppAndOptionalStorePackageUpdatesAsync on the
+     * native dispatcher thread right away and then every intervalMillis
+     * milliseconds. Results are cached, see msstore_winrt_get_pending_updates().
+     *
+     * Returns 0 on success and -1 on failure (for example a non-positive
+     * interval). Use msstore_winrt_get_last_error() to read the error message.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_start_update_checker(int64_t intervalMillis);
+
+    /*
+     * Stops the background package update checker.
+     *
+     * A check that is already running completes, but its result is discarded.
+     * The last cached result stays readable.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_stop_update_checker();
+
+    /*
+     * Copies the cached result of the last package update check into result.
+     *
+     * Never calls into the Store and never waits for a running check, so it is
+     * safe to call from UI threads.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_get_pending_updates(MsStorePendingUpdatesNative* result);
+
+    /*
+     * Starts (or restarts) the background license refresher.
+     *
+     * The refresher keeps the license snapshot fresh from the native
+     * dispatcher thread, so msstore_winrt_get_cached_license() rarely has to
+     * wait for the Store. The delay between refreshes adapts: intervalMillis
+     * while nothing happens, shorter right after the license changed, just
+     * after the next trial or subscription expiration, and exponential
+     * backoff from minIntervalMillis up to maxIntervalMillis after errors.
+     *
+     * Every delay, including the first, is spread by a jitter derived from
+     * jitterSeed, so a fleet of installs does not refresh in lockstep. Pass 0
+     * to derive a seed that is stable per install (machine and user).
+     *
+     * Returns 0 on success or -1 with the last error set unless
+     * 0 < minIntervalMillis <= intervalMillis <= maxIntervalMillis.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_start_license_refresher(
+        int64_t intervalMillis,
+        int64_t minIntervalMillis,
+        int64_t maxIntervalMillis,
+        uint64_t jitterSeed
+    );
+
+    /*
+     * Stops the background license refresher. The snapshot stays cached.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_stop_license_refresher();
+
+    /*
+     * Starts downloading and installing all pending package updates.
+     *
+     * Uses the packages found by the last background update check, or queries
+     * them first if no check completed yet, blocking until the query is done.
+     * The Store may show UI, so the installation is started from the calling
+     * thread's single-threaded apartment, like msstore_winrt_request_purchase();
+     * this call returns once it is started.
+     *
+     * Progress records are written into a fixed-size lock-free ring buffer and
+     * read with msstore_winrt_wait_update_progress(). Once the previous
+     * installation finished, a new one may start even if its final record
+     * was never read; the ring is then reset between two drains.
+     *
+     * Returns 0 on success and -1 on failure (for example when an installation
+     * is already running). Use msstore_winrt_get_last_error() to read the error
+     * message.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_start_update_install();
+
+    /*
+     * Drains buffered progress records of the running installation.
+     *
+     * Blocks for up to timeoutMillis milliseconds if no record is buffered,
+     * then copies up to capacity records into buffer. Only one thread may
+     * drain at a time.
+     *
+     * Returns the number of records copied (0 on timeout) or -1 if no
+     * installation was started. Use msstore_winrt_get_last_error() to read
+     * the error message.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_wait_update_progress(
+        MsStoreUpdateProgressNative* buffer,
+        int capacity,
+        int timeoutMillis
+    );
+
+    /*
+     * Enables or disables keeping ExtendedJsonData for on-demand field access.
+     *
+     * Disabled by default. When enabled, each msstore_winrt_get_license() call
+     * keeps the ExtendedJsonData of the app license and of every add-on
+     * license in native memory, replacing the previously kept documents.
+     * Disabling drops the kept documents.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_set_keep_extended_json(bool keep);
+
+    /*
+     * Returns one field of the kept app license ExtendedJsonData.
+     *
+     * The path uses dots for object keys and [index] for array elements, for
+     * example "skuItems[0].skuId". The document is scanned on demand without
+     * building a tree; only the value found is copied.
+     *
+     * On success: returns the raw JSON text of the value (strings keep their
+     * quotes and escapes). Caller must free via msstore_winrt_free().
+     * If the field does not exist: returns nullptr and the last error is empty.
+     * On failure: returns nullptr. Use msstore_winrt_get_last_error() to read
+     * the error message.
+     */
+    MSSTORE_WINRT_API const char* msstore_winrt_get_json_field(const char* path);
+
+    /*
+     * Returns one field of the kept ExtendedJsonData of an add-on license.
+     *
+     * The add-on is selected by its 12-character Store ID. Path syntax and
+     * result semantics are the same as for msstore_winrt_get_json_field().
+     */
+    MSSTORE_WINRT_API const char* msstore_winrt_get_addon_json_field(const char* storeId, const char* path);
+
+    /*
+     * Opens the cross-process license broker with the given name.
+     *
+     * All processes of an app suite that use the same name share one session
+     * local shared memory segment. The owner (owner = true) publishes every
+     * license snapshot it queries there; clients read it with
+     * msstore_winrt_broker_read_license() instead of asking the Store.
+     *
+     * Only one process can own a broker at a time. If the owner exits, the
+     * next process that opens as owner takes over. Ownership belongs to the
+     * process, not the calling thread: open and close may be called from
+     * any thread, and the opening thread may exit meanwhile.
+     *
+     * The name may contain A-Z, a-z, 0-9, '.', '_' and '-' (1-64 characters).
+     * Opening again closes the previous broker first.
+     *
+     * Returns 0 on success, or -1 on failure (use msstore_winrt_get_last_error()).
+     */
+    MSSTORE_WINRT_API int msstore_winrt_broker_open(const char* name, bool owner);
+
+    /*
+     * Closes the license broker. An owner gives up ownership; the last
+     * published snapshot stays readable for clients until all close.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_broker_close();
+
+    /*
+     * Returns the snapshot last published by the broker owner.
+     *
+     * Fails if no snapshot was published yet or, for maxAgeMillis >= 0, if it
+     * was published more than maxAgeMillis ago. Pass -1 to accept any age.
+     *
+     * On success: returns a non-null pointer to MsStoreLicenseV2Native.
+     * The caller must release it using msstore_winrt_free_license_v2().
+     * On failure: returns nullptr. Use msstore_winrt_get_last_error() to read
+     * the error message.
+     */
+    MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_broker_read_license(int64_t maxAgeMillis);
+
+    /*
+     * Returns the app license of another signed-in user.
+     *
+     * userId is the User.NonRoamableId. StoreContexts of the most recently
+     * used users are cached together with their last license, so switching
+     * users does not rebuild the context. If that license is at most
+     * maxAgeMillis old it is returned without a Store query; pass 0 to
+     * always query.
+     *
+     * ExtendedJsonData is never kept for other users.
+     *
+     * On success: returns a non-null pointer to MsStoreLicenseV2Native.
+     * The caller must release it using msstore_winrt_free_license_v2().
+     * On failure: returns nullptr. Use msstore_winrt_get_last_error() to read
+     * the error message.
+     */
+    MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_user_license(const char* userId, int64_t maxAgeMillis);
+
+    /*
+     * Like msstore_winrt_get_license_changes(), for another signed-in user.
+     *
+     * Generations are counted per user.
+     */
+    MSSTORE_WINRT_API MsStoreLicenseChangesNative* msstore_winrt_get_user_license_changes(
+        const char* userId,
+        int64_t sinceGeneration
+    );
+
+    /*
+     * Like msstore_winrt_request_purchase(), on behalf of another signed-in user.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_request_user_purchase(const char* userId, const char* storeId);
+
+    /*
+     * Drops the cached StoreContext and license of a user, for example after
+     * the user signed out.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_forget_user(const char* userId);
+
+    /*
+     * Writes a JSON document describing the internal state of the DLL.
+     *
+     * Covers the cached license (generation, age), the refresh engine
+     * (in-flight query, failures, last error), dispatcher queue depth,
+     * allocations not freed by the caller yet, update checker and installer
+     * state, broker and user caches, and the backend identity. Never calls
+     * the Store, so it also answers while a Store call hangs.
+     *
+     * Returns the document length in bytes, without the terminating zero.
+     * The document is written (zero-terminated) only if size is larger than
+     * that; call with buffer = nullptr and size = 0 to query the length.
+     * Returns -1 on error.
+     */
+    MSSTORE_WINRT_API int64_t msstore_winrt_dump_state(char* buffer, int64_t size);
+
+    /*
+     * Sets the latency threshold for slow-call records in microseconds.
+     *
+     * License calls taking at least this long are recorded with their phase
+     * breakdown into a fixed-size ring; see MsStoreSlowCallNative. 0 (the
+     * default) disables recording, so calls skip all timing.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_set_slow_call_threshold(int64_t thresholdMicros);
+
+    /*
+     * Adds the caller's decoding time to the last license call of this thread.
+     *
+     * For callers that convert the returned structs into their own objects
+     * (like the JVM): once a thread called this, its license calls wait for
+     * the commit and are recorded here if they were slow including
+     * jvmDecodeMicros. A call that is never committed is recorded when the
+     * thread starts its next license call.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_commit_slow_call(int64_t jvmDecodeMicros);
+
+    /*
+     * Copies slow-call records with a Sequence larger than sinceSequence into
+     * buffer, oldest first.
+     *
+     * Returns the number of records copied, at most capacity. Pass the last
+     * Sequence seen to continue where the previous read stopped. Records that
+     * were overwritten in the ring in between are lost.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_read_slow_calls(
+        int64_t sinceSequence,
+        MsStoreSlowCallNative* buffer,
+        int capacity
+    );
+
+    /*
+     * Opens (or creates) the purchase log at path (UTF-8).
+     *
+     * The log is a memory-mapped file of capacity fixed-size records. Every
+     * purchase attempt is appended with a few stores into the mapping, the
+     * operating system writes the pages back to disk in the background, so
+     * the purchase path never waits for I/O. Once full, the oldest records
+     * are overwritten. An existing log is continued; it must have been
+     * created with the same capacity. Records that a previous process
+     * claimed but never finished writing are skipped from then on.
+     *
+     * Returns 0 on success or -1 with the last error set.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_purchase_log_open(const char* path, int capacity);
+
+    /*
+     * Flushes and closes the purchase log. Attempts are not logged anymore.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_purchase_log_close();
+
+    /*
+     * Copies purchase attempts with a Sequence larger than sinceSequence into
+     * buffer, oldest first.
+     *
+     * Returns the number of records copied, at most capacity, or -1 with the
+     * last error set if no log is open. Pass the last Sequence seen to
+     * continue where the previous read stopped.
+     */
+    MSSTORE_WINRT_API int msstore_winrt_purchase_log_read(
+        int64_t sinceSequence,
+        MsStorePurchaseAttemptNative* buffer,
+        int capacity
+    );
+
+    /*
+     * Writes the license as a CBOR document (RFC 8949) into buffer, for
+     * sending it on as is.
+     *
+     * Uses the cached license if it is at most maxAgeMillis old, otherwise
+     * queries the Store (joining a query already in flight); 0 always
+     * queries. Nothing is allocated: the document is encoded straight from
+     * the snapshot.
+     *
+     * The document is a map with unsigned integer keys:
+     * 0: schema ID (MSSTORE_WINRT_LICENSE_EXPORT_SCHEMA)
+     * 1: SkuStoreId (text)
+     * 2: IsActive (bool)
+     * 3: IsTrial (bool)
+     * 4: ExpirationDate (int, Unix epoch millis)
+     * 5: Fingerprint (uint)
+     * 6: Generation (int)
+     * 7: CapturedAt (int, Unix epoch millis of the Store query)
+     * 8: add-ons (array of maps, sorted by SkuStoreId):
+     *    0: SkuStoreId (text), 1: InAppOfferToken (text),
+     *    2: ExpirationDate (int), 3: Fingerprint (uint)
+     *
+     * Returns the document length in bytes. The document is written only if
+     * size is at least that; call with buffer = nullptr and size = 0 to query
+     * the length. Returns -1 on error.
+     */
+    MSSTORE_WINRT_API int64_t msstore_winrt_export_license(uint8_t* buffer, int64_t size, int64_t maxAgeMillis);
+
     /*
      * Frees memory allocated by msstore_winrt_get_license().
      */
     MSSTORE_WINRT_API void msstore_winrt_free_license(MsStoreLicenseNative* ptr);
 
+    /*
+     * Frees memory allocated by msstore_winrt_get_license_v2() and every
+     * other call returning MsStoreLicenseV2Native.
+     */
+    MSSTORE_WINRT_API void msstore_winrt_free_license_v2(MsStoreLicenseV2Native* ptr);
+
+    /*
+     * Frees memory allocated by msstore_winrt_get_license_changes().
+     */
+    MSSTORE_WINRT_API void msstore_winrt_free_license_changes(MsStoreLicenseChangesNative* ptr);
+
     /*
      * Frees memory allocated by msstore_winrt_get_last_error() and individual
      * string fields returned inside MsStoreLicenseNative structures.
@@ -93,4 +781,6 @@ extern "C" {
      * Caller must free via msstore_winrt_free().
      */
     MSSTORE_WINRT_API const char* msstore_winrt_get_last_error();
+#ifdef __cplusplus
 }
+#endif
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "msstore_winrt.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+  #include <span>
+  #define MSSTORE_WINRT_HAS_SPAN 1
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+  #include <coroutine>
+  #include <thread>
+  #define MSSTORE_WINRT_HAS_COROUTINES 1
+#endif
+
+/*
+ * Header-only C++ client for msstore_winrt.dll.
+ *
+ * Wraps the C ABI of msstore_winrt.h for native C++ tools that link the DLL
+ * directly:
+ * - Results are move-only RAII handles that release the native memory with
+ *   the matching msstore_winrt_free_* function.
+ * - Accessors return std::string_view and std::span (Span in C++17) views
+ *   into that memory. Nothing is copied; views are valid as long as the
+ *   handle lives.
+ * - Failures throw msstore::Error with the native last error message.
+ * - With C++20 coroutines, the *_async functions return awaitables that run
+ *   the blocking call on a separate thread and resume the coroutine there.
+ *
+ * Requires C++17.
+ */
+
+namespace msstore {
+
+/* Thrown when a native call fails. what() is the native error message. */
+class Error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/* Mirrors the status codes of msstore_winrt_request_purchase(). */
+enum class PurchaseStatus : int {
+    Succeeded = 0,
+    AlreadyPurchased = 1,
+    NotPurchased = 2,
+    NetworkError = 3,
+    ServerError = 4,
+    Unknown = 5
+};
+
+namespace detail {
+
+    /* Returns and frees the native last error message of this thread. */
+    inline std::string take_last_error() {
+
+        const char* text = msstore_winrt_get_last_error();
+
+        std::string message = text != nullptr ? text : "";
+
+        msstore_winrt_free(text);
+
+        return message;
+    }
+
+    [[noreturn]] inline void throw_last_error(const char* fallback) {
+
+        std::string message = take_last_error();
+
+        throw Error(message.empty() ? fallback : message);
+    }
+
+    inline std::string_view view(const char* value) noexcept {
+        return value != nullptr ? std::string_view(value) : std::string_view();
+    }
+
+    /* Minimal read-only std::span stand-in for C++17. */
+    template <typename T>
+    class ArrayView {
+    public:
+        constexpr ArrayView() noexcept = default;
+        constexpr ArrayView(const T* data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+        constexpr const T* data() const noexcept { return m_data; }
+        constexpr std::size_t size() const noexcept { return m_size; }
+        constexpr bool empty() const noexcept { return m_size == 0; }
+        constexpr const T* begin() const noexcept { return m_data; }
+        constexpr const T* end() const noexcept { return m_data + m_size; }
+        constexpr const T& operator[](std::size_t index) const noexcept { return m_data[index]; }
+
+    private:
+        const T* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+
+} // namespace detail
+
+#ifdef MSSTORE_WINRT_HAS_SPAN
+template <typename T>
+using Span = std::span<const T>;
+#else
+template <typename T>
+using Span = detail::ArrayView<T>;
+#endif
+
+namespace detail {
+
+    template <typename T>
+    inline Span<T> span(const T* data, int count) noexcept {
+
+        if (data == nullptr || count <= 0)
+            return Span<T>();
+
+        return Span<T>(data, static_cast<std::size_t>(count));
+    }
+
+    /* Splits "9NBLGGH4R315/0010" into Store ID and SKU ID views. */
+    inline std::string_view store_id_part(std::string_view skuStoreId) noexcept {
+        return skuStoreId.substr(0, skuStoreId.find('/'));
+    }
+
+    inline std::string_view sku_id_part(std::string_view skuStoreId) noexcept {
+
+        const std::size_t separator = skuStoreId.find('/');
+
+        return separator == std::string_view::npos ? std::string_view() : skuStoreId.substr(separator + 1);
+    }
+
+} // namespace detail
+
+// region Add-on views
+
+inline std::string_view sku_store_id(const MsStoreAddOnLicenseV2Native& addOn) noexcept {
+    return detail::view(addOn.SkuStoreId);
+}
+
+inline std::string_view store_id(const MsStoreAddOnLicenseV2Native& addOn) noexcept {
+    return detail::store_id_part(sku_store_id(addOn));
+}
+
+inline std::string_view sku_id(const MsStoreAddOnLicenseV2Native& addOn) noexcept {
+    return detail::sku_id_part(sku_store_id(addOn));
+}
+
+inline std::string_view in_app_offer_token(const MsStoreAddOnLicenseV2Native& addOn) noexcept {
+    return detail::view(addOn.InAppOfferToken);
+}
+
+// endregion
+
+namespace detail {
+
+    /*
+     * Deleters are types rather than function pointer template arguments:
+     * addresses of dllimport functions are no constant expressions.
+     */
+    struct FreeString {
+        void operator()(const char* value) const noexcept { msstore_winrt_free(value); }
+    };
+
+    struct FreeLicense {
+        void operator()(MsStoreLicenseV2Native* value) const noexcept { msstore_winrt_free_license_v2(value); }
+    };
+
+    struct FreeLicenseChanges {
+        void operator()(MsStoreLicenseChangesNative* value) const noexcept { msstore_winrt_free_license_changes(value); }
+    };
+
+} // namespace detail
+
+/*
+ * Move-only owner of a native pointer, released with Free on destruction.
+ */
+template <typename T, typename Free>
+class Handle {
+public:
+    Handle() noexcept = default;
+    explicit Handle(T* pointer) noexcept : m_pointer(pointer) {}
+
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    Handle(Handle&& other) noexcept : m_pointer(std::exchange(other.m_pointer, nullptr)) {}
+
+    Handle& operator=(Handle&& other) noexcept {
+
+        if (this != &other)
+            reset(std::exchange(other.m_pointer, nullptr));
+
+        return *this;
+    }
+
+    ~Handle() { reset(); }
+
+    explicit operator bool() const noexcept { return m_pointer != nullptr; }
+
+    /* The raw C struct, still owned by this handle. */
+    const T* native() const noexcept { return m_pointer; }
+
+    /* Gives up ownership; the caller must free the pointer. */
+    T* release() noexcept { return std::exchange(m_pointer, nullptr); }
+
+    void reset(T* pointer = nullptr) noexcept {
+
+        if (m_pointer != nullptr)
+            Free()(m_pointer);
+
+        m_pointer = pointer;
+    }
+
+protected:
+    T* m_pointer = nullptr;
+};
+
+/* A UTF-8 string allocated by the DLL. */
+class String : public Handle<const char, detail::FreeString> {
+public:
+    using Handle::Handle;
+
+    std::string_view view() const noexcept { return detail::view(m_pointer); }
+    operator std::string_view() const noexcept { return view(); }
+};
+
+/* The app license, see msstore_winrt_get_license_v2(). */
+class License : public Handle<MsStoreLicenseV2Native, detail::FreeLicense> {
+public:
+    using Handle::Handle;
+
+    std::string_view sku_store_id() const noexcept { return detail::view(m_pointer->SkuStoreId); }
+    std::string_view store_id() const noexcept { return detail::store_id_part(sku_store_id()); }
+    std::string_view sku_id() const noexcept { return detail::sku_id_part(sku_store_id()); }
+    bool is_active() const noexcept { return m_pointer->IsActive; }
+    bool is_trial() const noexcept { return m_pointer->IsTrial; }
+    int64_t expiration_date() const noexcept { return m_pointer->ExpirationDate; }
+    uint64_t fingerprint() const noexcept { return m_pointer->Fingerprint; }
+    int64_t generation() const noexcept { return m_pointer->Generation; }
+
+    /* Sorted by SkuStoreId. */
+    Span<MsStoreAddOnLicenseV2Native> add_ons() const noexcept {
+        return detail::span(m_pointer->AddOnLicenses, m_pointer->AddOnLicensesCount);
+    }
+};
+
+/* Add-on changes between two generations, see msstore_winrt_get_license_changes(). */
+class LicenseChanges : public Handle<MsStoreLicenseChangesNative, detail::FreeLicenseChanges> {
+public:
+    using Handle::Handle;
+
+    int64_t generation() const noexcept { return m_pointer->Generation; }
+    uint64_t fingerprint() const noexcept { return m_pointer->Fingerprint; }
+    std::string_view sku_store_id() const noexcept { return detail::view(m_pointer->SkuStoreId); }
+    int64_t expiration_date() const noexcept { return m_pointer->ExpirationDate; }
+    bool is_active() const noexcept { return m_pointer->IsActive; }
+    bool is_trial() const noexcept { return m_pointer->IsTrial; }
+    bool is_full_resync() const noexcept { return m_pointer->IsFullResync; }
+
+    Span<MsStoreAddOnLicenseV2Native> added() const noexcept {
+        return detail::span(m_pointer->Added, m_pointer->AddedCount);
+    }
+
+    Span<MsStoreAddOnLicenseV2Native> removed() const noexcept {
+        return detail::span(m_pointer->Removed, m_pointer->RemovedCount);
+    }
+
+    Span<MsStoreAddOnLicenseV2Native> changed() const noexcept {
+        return detail::span(m_pointer->Changed, m_pointer->ChangedCount);
+    }
+};
+
+// region Calls
+
+inline License get_license() {
+
+    MsStoreLicenseV2Native* pointer = msstore_winrt_get_license_v2();
+
+    if (pointer == nullptr)
+        detail::throw_last_error("Native license query failed.");
+
+    return License(pointer);
+}
+
+inline LicenseChanges get_license_changes(int64_t sinceGeneration) {
+
+    MsStoreLicenseChangesNative* pointer = msstore_winrt_get_license_changes(sinceGeneration);
+
+    if (pointer == nullptr)
+        detail::throw_last_error("Native license query failed.");
+
+    return LicenseChanges(pointer);
+}
+
+inline License get_user_license(const std::string& userId, int64_t maxAgeMillis = 0) {
+
+    MsStoreLicenseV2Native* pointer = msstore_winrt_get_user_license(userId.c_str(), maxAgeMillis);
+
+    if (pointer == nullptr)
+        detail::throw_last_error("Native license query failed.");
+
+    return License(pointer);
+}
+
+inline PurchaseStatus request_purchase(const std::string& storeId) {
+
+    const int statusCode = msstore_winrt_request_purchase(storeId.c_str());
+
+    if (statusCode < 0)
+        detail::throw_last_error("Native purchase request failed.");
+
+    return statusCode <= static_cast<int>(PurchaseStatus::Unknown)
+        ? static_cast<PurchaseStatus>(statusCode)
+        : PurchaseStatus::Unknown;
+}
+
+inline MsStorePendingUpdatesNative get_pending_updates() noexcept {
+
+    MsStorePendingUpdatesNative result {};
+
+    msstore_winrt_get_pending_updates(&result);
+
+    return result;
+}
+
+/* Returns the raw JSON value at path, or std::nullopt if the field does not exist. */
+inline std::optional<String> get_json_field(const std::string& path) {
+
+    const char* value = msstore_winrt_get_json_field(path.c_str());
+
+    if (value != nullptr)
+        return String(value);
+
+    std::string message = detail::take_last_error();
+
+    /* An empty last error means "field missing". */
+    if (!message.empty())
+        throw Error(message);
+
+    return std::nullopt;
+}
+
+// endregion
+
+#ifdef MSSTORE_WINRT_HAS_COROUTINES
+
+namespace detail {
+
+    /*
+     * Awaitable that runs a blocking call on a new thread and resumes the
+     * awaiting coroutine on that thread with the result.
+     *
+     * The native layer initializes the COM apartment of that thread itself.
+     */
+    template <typename T, typename Call>
+    class BlockingCallAwaiter {
+    public:
+        explicit BlockingCallAwaiter(Call call) : m_call(std::move(call)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+
+            std::thread([this, handle]() {
+
+                try {
+                    m_result.emplace(m_call());
+                } catch (...) {
+                    m_exception = std::current_exception();
+                }
+
+                handle.resume();
+
+            }).detach();
+        }
+
+        T await_resume() {
+
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+
+            return std::move(*m_result);
+        }
+
+    private:
+        Call m_call;
+        std::optional<T> m_result;
+        std::exception_ptr m_exception;
+    };
+
+    template <typename T, typename Call>
+    BlockingCallAwaiter<T, Call> run_blocking(Call call) {
+        return BlockingCallAwaiter<T, Call>(std::move(call));
+    }
+
+} // namespace detail
+
+inline auto get_license_async() {
+    return detail::run_blocking<License>([]() { return get_license(); });
+}
+
+inline auto get_license_changes_async(int64_t sinceGeneration) {
+    return detail::run_blocking<LicenseChanges>([sinceGeneration]() { return get_license_changes(sinceGeneration); });
+}
+
+inline auto get_user_license_async(std::string userId, int64_t maxAgeMillis = 0) {
+    return detail::run_blocking<License>([userId = std::move(userId), maxAgeMillis]() {
+        return get_user_license(userId, maxAgeMillis);
+    });
+}
+
+/* The Store UI needs a foreground window; the native layer looks it up on the worker thread. */
+inline auto request_purchase_async(std::string storeId) {
+    return detail::run_blocking<PurchaseStatus>([storeId = std::move(storeId)]() {
+        return request_purchase(storeId);
+    });
+}
+
+#endif
+
+} // namespace msstore
@@ -0,0 +1,472 @@
+#include "msstore_winrt.hpp"
+#include "msstore_test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef MSSTORE_WINRT_HAS_COROUTINES
+  #include <future>
+#endif
+
+/*
+ * Tests of the header-only C++ client (msstore_winrt.hpp).
+ *
+ * The client is linked against fake exports defined below instead of the
+ * DLL. They hand out tracked allocations, so the tests see every leak and
+ * every pointer freed twice or with the wrong function.
+ *
+ * Built twice, as C++17 and as C++20 (std::span and coroutines), with
+ * MSSTORE_WINRT_TESTS (see CMakeLists.txt) and run by ctest.
+ */
+
+// region Fake exports
+
+/* Kind of a tracked allocation, so a pointer must go back to its own free function. */
+enum class Allocation { String, License, LicenseChanges };
+
+static std::mutex g_allocationsMutex;
+static std::set<std::pair<const void*, Allocation>> g_allocations;
+static int g_badFrees = 0;
+
+static thread_local std::string t_lastError;
+
+/* Answers of the fake calls; an empty error means success. */
+static std::string g_queryError;
+static int g_purchaseStatus = 0;
+
+static void track(const void* pointer, Allocation kind) {
+
+    std::lock_guard<std::mutex> lock(g_allocationsMutex);
+
+    g_allocations.insert({ pointer, kind });
+}
+
+static void untrack(const void* pointer, Allocation kind) {
+
+    std::lock_guard<std::mutex> lock(g_allocationsMutex);
+
+    if (g_allocations.erase({ pointer, kind }) == 0)
+        g_badFrees++;
+}
+
+static size_t live_allocations() {
+
+    std::lock_guard<std::mutex> lock(g_allocationsMutex);
+
+    return g_allocations.size();
+}
+
+static const char* fake_string(std::string_view value) {
+
+    char* copy = static_cast<char*>(std::malloc(value.size() + 1));
+    std::memcpy(copy, value.data(), value.size());
+    copy[value.size()] = '\0';
+
+    track(copy, Allocation::String);
+
+    return copy;
+}
+
+/* The strings of add-ons belong to their license, like in the DLL. */
+static MsStoreAddOnLicenseV2Native* fake_add_ons(std::initializer_list<const char*> skuStoreIds) {
+
+    if (skuStoreIds.size() == 0)
+        return nullptr;
+
+    auto* addOns = new MsStoreAddOnLicenseV2Native[skuStoreIds.size()] {};
+
+    int index = 0;
+
+    for (const char* skuStoreId : skuStoreIds) {
+        addOns[index].SkuStoreId = skuStoreId;
+        addOns[index].InAppOfferToken = "pro";
+        addOns[index].ExpirationDate = 1000 + index;
+        index++;
+    }
+
+    return addOns;
+}
+
+/* Returns true if the call should fail, with the last error set. */
+static bool fail_query() {
+
+    if (g_queryError.empty())
+        return false;
+
+    t_lastError = g_queryError;
+
+    return true;
+}
+
+extern "C" MSSTORE_WINRT_API const char* msstore_winrt_get_last_error() {
+    return fake_string(t_lastError);
+}
+
+extern "C" MSSTORE_WINRT_API void msstore_winrt_free(const char* ptr) {
+
+    if (ptr == nullptr)
+        return;
+
+    untrack(ptr, Allocation::String);
+
+    std::free(const_cast<char*>(ptr));
+}
+
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_license_v2() {
+
+    if (fail_query())
+        return nullptr;
+
+    auto* license = new MsStoreLicenseV2Native {};
+    license->SkuStoreId = "9NBLGGH4R315/0010";
+    license->IsActive = true;
+    license->ExpirationDate = 42;
+    license->AddOnLicenses = fake_add_ons({ "9NBLGGH4R316/0010", "9NBLGGH4R317/0011" });
+    license->AddOnLicensesCount = 2;
+    license->Fingerprint = 0x1234;
+    license->Generation = 3;
+
+    track(license, Allocation::License);
+
+    t_lastError.clear();
+
+    return license;
+}
+
+extern "C" MSSTORE_WINRT_API MsStoreLicenseV2Native* msstore_winrt_get_user_license(const char* userId, int64_t) {
+
+    if (userId == nullptr || *userId == '\0') {
+        t_lastError = "User ID is null or empty.";
+        return nullptr;
+    }
+
+    return msstore_winrt_get_license_v2();
+}
+
+extern "C" MSSTORE_WINRT_API void msstore_winrt_free_license_v2(MsStoreLicenseV2Native* ptr) {
+
+    if (ptr == nullptr)
+        return;
+
+    untrack(ptr, Allocation::License);
+
+    delete[] ptr->AddOnLicenses;
+    delete ptr;
+}
+
+extern "C" MSSTORE_WINRT_API MsStoreLicenseChangesNative* msstore_winrt_get_license_changes(int64_t sinceGeneration) {
+
+    if (fail_query())
+        return nullptr;
+
+    auto* changes = new MsStoreLicenseChangesNative {};
+    changes->Generation = sinceGeneration + 1;
+    changes->SkuStoreId = "9NBLGGH4R315/0010";
+    changes->IsActive = true;
+    changes->Added = fake_add_ons({ "9NBLGGH4R318/0010" });
+    changes->AddedCount = 1;
+    changes->Removed = fake_add_ons({ "9NBLGGH4R316/0010", "9NBLGGH4R317/0011" });
+    changes->RemovedCount = 2;
+
+    track(changes, Allocation::LicenseChanges);
+
+    t_lastError.clear();
+
+    return changes;
+}
+
+extern "C" MSSTORE_WINRT_API void msstore_winrt_free_license_changes(MsStoreLicenseChangesNative* ptr) {
+
+    if (ptr == nullptr)
+        return;
+
+    untrack(ptr, Allocation::LicenseChanges);
+
+    delete[] ptr->Added;
+    delete[] ptr->Removed;
+    delete[] ptr->Changed;
+    delete ptr;
+}
+
+extern "C" MSSTORE_WINRT_API int msstore_winrt_request_purchase(const char*) {
+
+    if (fail_query())
+        return -1;
+
+    return g_purchaseStatus;
+}
+
+extern "C" MSSTORE_WINRT_API void msstore_winrt_get_pending_updates(MsStorePendingUpdatesNative* result) {
+
+    result->Generation = 7;
+    result->UpdateCount = 2;
+    result->MandatoryUpdateCount = 1;
+}
+
+extern "C" MSSTORE_WINRT_API const char* msstore_winrt_get_json_field(const char* path) {
+
+    if (fail_query())
+        return nullptr;
+
+    /* A missing field is no error. */
+    t_lastError.clear();
+
+    if (std::string_view(path) == "skuItems[0].skuId")
+        return fake_string("\"0010\"");
+
+    return nullptr;
+}
+
+// endregion
+
+/* Resets the fake calls to succeed. */
+static void reset_fake() {
+    g_queryError.clear();
+    g_purchaseStatus = 0;
+}
+
+static void test_license_views_point_into_native_memory() {
+
+    {
+        msstore::License license = msstore::get_license();
+
+        CHECK(static_cast<bool>(license));
+        CHECK(license.sku_store_id() == "9NBLGGH4R315/0010");
+        CHECK(license.store_id() == "9NBLGGH4R315");
+        CHECK(license.sku_id() == "0010");
+        CHECK(license.is_active());
+        CHECK(!license.is_trial());
+        CHECK(license.expiration_date() == 42);
+        CHECK(license.fingerprint() == 0x1234);
+        CHECK(license.generation() == 3);
+
+        /* Views, not copies. */
+        CHECK(license.sku_store_id().data() == license.native()->SkuStoreId);
+        CHECK(license.add_ons().data() == license.native()->AddOnLicenses);
+
+        CHECK(license.add_ons().size() == 2);
+
+        int count = 0;
+
+        for (const MsStoreAddOnLicenseV2Native& addOn : license.add_ons()) {
+            CHECK(msstore::in_app_offer_token(addOn) == "pro");
+            count++;
+        }
+
+        CHECK(count == 2);
+        CHECK(msstore::store_id(license.add_ons()[1]) == "9NBLGGH4R317");
+        CHECK(msstore::sku_id(license.add_ons()[1]) == "0011");
+
+        CHECK(live_allocations() == 1);
+    }
+
+    CHECK(live_allocations() == 0);
+}
+
+static void test_handles_free_exactly_once() {
+
+    msstore::License first = msstore::get_license();
+    const MsStoreLicenseV2Native* pointer = first.native();
+
+    msstore::License second = std::move(first);
+
+    CHECK(!first);
+    CHECK(second.native() == pointer);
+
+    /* Move assignment frees the license it replaces. */
+    second = msstore::get_license();
+
+    CHECK(live_allocations() == 1);
+
+    MsStoreLicenseV2Native* released = second.release();
+
+    CHECK(!second);
+    CHECK(live_allocations() == 1);
+
+    msstore_winrt_free_license_v2(released);
+
+    CHECK(live_allocations() == 0);
+    CHECK(g_badFrees == 0);
+}
+
+static void test_license_changes() {
+
+    msstore::LicenseChanges changes = msstore::get_license_changes(4);
+
+    CHECK(changes.generation() == 5);
+    CHECK(changes.added().size() == 1);
+    CHECK(msstore::sku_store_id(changes.added()[0]) == "9NBLGGH4R318/0010");
+    CHECK(changes.removed().size() == 2);
+
+    /* Null arrays become empty views. */
+    CHECK(changes.changed().empty());
+    CHECK(changes.changed().begin() == changes.changed().end());
+}
+
+static void test_failures_throw_native_error() {
+
+    g_queryError = "Store unavailable.";
+
+    bool thrown = false;
+
+    try {
+        msstore::get_license();
+    } catch (const msstore::Error& ex) {
+        thrown = std::string_view(ex.what()) == "Store unavailable.";
+    }
+
+    CHECK(thrown);
+
+    thrown = false;
+
+    try {
+        msstore::get_user_license("");
+    } catch (const msstore::Error& ex) {
+        thrown = std::string_view(ex.what()) == "User ID is null or empty.";
+    }
+
+    CHECK(thrown);
+
+    thrown = false;
+
+    try {
+        msstore::get_json_field("skuItems[0].skuId");
+    } catch (const msstore::Error&) {
+        thrown = true;
+    }
+
+    CHECK(thrown);
+
+    reset_fake();
+
+    /* The last error strings were freed as well. */
+    CHECK(live_allocations() == 0);
+}
+
+static void test_purchase_status() {
+
+    g_purchaseStatus = 1;
+    CHECK(msstore::request_purchase("9NBLGGH4R316") == msstore::PurchaseStatus::AlreadyPurchased);
+
+    /* Codes of newer DLLs map to Unknown. */
+    g_purchaseStatus = 17;
+    CHECK(msstore::request_purchase("9NBLGGH4R316") == msstore::PurchaseStatus::Unknown);
+
+    reset_fake();
+}
+
+static void test_json_field_and_pending_updates() {
+
+    {
+        std::optional<msstore::String> skuId = msstore::get_json_field("skuItems[0].skuId");
+
+        CHECK(skuId.has_value() && skuId->view() == "\"0010\"");
+        CHECK(!msstore::get_json_field("missing").has_value());
+    }
+
+    MsStorePendingUpdatesNative updates = msstore::get_pending_updates();
+
+    CHECK(updates.Generation == 7);
+    CHECK(updates.MandatoryUpdateCount == 1);
+
+    CHECK(live_allocations() == 0);
+}
+
+#ifdef MSSTORE_WINRT_HAS_COROUTINES
+
+/* Starts eagerly and is never awaited; results go through a promise. */
+struct DetachedCoroutine {
+
+    struct promise_type {
+        DetachedCoroutine get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+static DetachedCoroutine await_license(std::promise<std::string>& done) {
+
+    try {
+
+        std::string storeId;
+
+        {
+            msstore::License license = co_await msstore::get_license_async();
+
+            storeId = license.store_id();
+        }
+
+        /* The license is freed before the test looks at the allocations. */
+        done.set_value(storeId);
+
+    } catch (const msstore::Error& ex) {
+        done.set_value(std::string("error: ") + ex.what());
+    }
+}
+
+static DetachedCoroutine await_purchase(std::promise<msstore::PurchaseStatus>& done) {
+    done.set_value(co_await msstore::request_purchase_async("9NBLGGH4R316"));
+}
+
+static void test_awaitables() {
+
+    std::promise<std::string> license;
+
+    await_license(license);
+
+    CHECK(license.get_future().get() == "9NBLGGH4R315");
+
+    /* The error is set and read on the worker thread. */
+    g_queryError = "Store unavailable.";
+
+    std::promise<std::string> failed;
+
+    await_license(failed);
+
+    CHECK(failed.get_future().get() == "error: Store unavailable.");
+
+    reset_fake();
+
+    std::promise<msstore::PurchaseStatus> purchase;
+
+    await_purchase(purchase);
+
+    CHECK(purchase.get_future().get() == msstore::PurchaseStatus::Succeeded);
+
+    CHECK(live_allocations() == 0);
+}
+
+#endif
+
+int main() {
+
+    test_license_views_point_into_native_memory();
+    test_handles_free_exactly_once();
+    test_license_changes();
+    test_failures_throw_native_error();
+    test_purchase_status();
+    test_json_field_and_pending_updates();
+
+#ifdef MSSTORE_WINRT_HAS_COROUTINES
+    test_awaitables();
+#endif
+
+    CHECK(live_allocations() == 0);
+    CHECK(g_badFrees == 0);
+
+#if __cplusplus >= 202002L
+    return test_result("msstore_winrt_client_test (C++20)");
+#else
+    return test_result("msstore_winrt_client_test (C++17)");
+#endif
+}
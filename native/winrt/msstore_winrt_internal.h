@@ -0,0 +1,185 @@
+#pragma once
+
+#include "msstore_winrt.h"
+#include "msstore_snapshot.h"
+#include "msstore_spans.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Services.Store.h>
+
+/*
+ * Helpers shared between the translation units of msstore_winrt.dll.
+ *
+ * Nothing in here is exported from the DLL.
+ */
+
+/*
+ * Thread-local error storage for the last failure in this DLL.
+ *
+ * Defined in msstore_winrt.cpp.
+ */
+extern thread_local std::string g_lastError;
+
+/*
+ * Allocates a UTF-8 string via CoTaskMemAlloc for cross-module ownership.
+ */
+const char* dup_string(const std::string& value);
+
+/* Converts a WinRT DateTime to Unix epoch milliseconds */
+int64_t to_unix_epoch_millis(winrt::Windows::Foundation::DateTime dateTime);
+
+/* Returns the current wall-clock time as Unix epoch milliseconds */
+int64_t current_unix_epoch_millis();
+
+/*
+ * Converts a queried app license into a fingerprinted snapshot. Throws on
+ * WinRT errors or a null license.
+ *
+ * keepExtendedJson allows keeping ExtendedJsonData if that is enabled; only
+ * the default user's documents are kept.
+ */
+LicenseSnapshot license_snapshot_from(
+    const winrt::Windows::Services::Store::StoreAppLicense& license,
+    bool keepExtendedJson
+);
+
+/*
+ * Queries the app license through the given context and converts it into a
+ * fingerprinted snapshot, blocking the calling thread. Throws on WinRT errors.
+ *
+ * keepExtendedJson allows keeping ExtendedJsonData if that is enabled; only
+ * the default user's documents are kept.
+ */
+LicenseSnapshot query_license_snapshot(
+    const winrt::Windows::Services::Store::StoreContext& context,
+    bool keepExtendedJson
+);
+
+/*
+ * Converts a snapshot into a CoTaskMemAlloc'ed MsStoreLicenseV2Native.
+ *
+ * Returns nullptr and sets g_lastError if the allocation fails.
+ */
+MsStoreLicenseV2Native* marshal_license(const LicenseSnapshot& snapshot);
+
+/*
+ * Converts a snapshot diff into a CoTaskMemAlloc'ed MsStoreLicenseChangesNative.
+ *
+ * Returns nullptr and sets g_lastError if the allocation fails.
+ */
+MsStoreLicenseChangesNative* marshal_license_changes(const LicenseSnapshotDiff& diff);
+
+/*
+ * Returns whether snapshot proves storeId as owned and unexpired.
+ *
+ * Only true if the purchase short-circuit is enabled and the snapshot is
+ * within its freshness bound. storeId may be the app itself (full, non-trial
+ * license) or a durable add-on.
+ */
+bool is_owned_in_snapshot(const LicenseSnapshot* snapshot, const char* storeId);
+
+/*
+ * Encodes snapshot as the CBOR document of msstore_winrt_export_license().
+ *
+ * Writes at most size bytes into buffer and returns the full document
+ * length, which is larger if it did not fit. Never allocates. Defined in
+ * msstore_export.cpp.
+ */
+size_t encode_license_cbor(const LicenseSnapshot& snapshot, uint8_t* buffer, size_t size);
+
+/*
+ * Shows the Store purchase UI of the given context for storeId.
+ *
+ * Returns a status code (0..5), or -1 with g_lastError set. Throws on WinRT
+ * errors. The attempt is written to the purchase log; forUser tells whether
+ * the context belongs to a specific user.
+ */
+int request_purchase_in_context(
+    const winrt::Windows::Services::Store::StoreContext& context,
+    const char* storeId,
+    bool forUser
+);
+
+/*
+ * Appends a purchase attempt to the purchase log if one is open.
+ *
+ * Only copies the record into the mapped file; never waits for I/O. Status
+ * is the purchase status code or -1. Defined in msstore_purchase_log.cpp.
+ */
+void log_purchase_attempt(
+    const char* storeId,
+    int64_t dialogOpenedAt,
+    int64_t dialogClosedAt,
+    int status,
+    int32_t hresult,
+    bool shortCircuited,
+    bool forUser
+);
+
+/*
+ * Publishes a freshly queried snapshot and returns the published one.
+ *
+ * Besides publish_snapshot() this shares the snapshot through the license
+ * broker if this process owns it.
+ */
+std::shared_ptr<const LicenseSnapshot> publish_license_snapshot(LicenseSnapshot snapshot);
+
+/*
+ * Queries and publishes the default user's license through the coroutine
+ * engine and waits for the result. Joins a query already in flight.
+ *
+ * timing, if given, receives the queue wait and Store time of that query,
+ * also on failure. Throws std::runtime_error with the error message on
+ * failure. Must not be called on the dispatcher thread. Defined in
+ * msstore_engine.cpp.
+ */
+std::shared_ptr<const LicenseSnapshot> refresh_license_snapshot(RefreshTiming* timing = nullptr);
+
+/* Like refresh_license_snapshot(), without waiting for the result. */
+void refresh_license_snapshot_async();
+
+/*
+ * Like refresh_license_snapshot_async(), then calls done with the published
+ * snapshot, or nullptr if the query failed. done runs on the thread that
+ * completed the query and must not block. Defined in msstore_engine.cpp.
+ */
+void refresh_license_snapshot_then(std::function<void(std::shared_ptr<const LicenseSnapshot>)> done);
+
+/*
+ * Writes the snapshot into the broker segment if this process is the broker
+ * owner; does nothing otherwise. Defined in msstore_broker.cpp.
+ */
+void broker_publish(const LicenseSnapshot& snapshot);
+
+/* Returns whether ExtendedJsonData should be kept for on-demand field access. */
+bool is_extended_json_kept();
+
+/*
+ * Replaces the kept ExtendedJsonData documents.
+ *
+ * addOnJson pairs the add-on SkuStoreId with its document.
+ */
+void keep_extended_json(std::string appJson, std::vector<std::pair<std::string, std::string>> addOnJson);
+
+/*
+ * Sections of msstore_winrt_dump_state(), each defined next to the state it
+ * reports. They only copy values under the owning module's lock and never
+ * call the Store.
+ */
+class DiagnosticsWriter;
+
+void dump_allocation_state(DiagnosticsWriter& writer);  /* msstore_winrt.cpp */
+void dump_engine_state(DiagnosticsWriter& writer);      /* msstore_engine.cpp */
+void dump_dispatcher_state(DiagnosticsWriter& writer);  /* msstore_dispatcher.cpp */
+void dump_update_state(DiagnosticsWriter& writer);      /* msstore_updates.cpp */
+void dump_broker_state(DiagnosticsWriter& writer);      /* msstore_broker.cpp */
+void dump_user_state(DiagnosticsWriter& writer);        /* msstore_users.cpp */
+void dump_extended_json_state(DiagnosticsWriter& writer); /* msstore_extended_json.cpp */
+void dump_purchase_log_state(DiagnosticsWriter& writer); /* msstore_purchase_log.cpp */
+void dump_refresher_state(DiagnosticsWriter& writer);    /* msstore_refresher.cpp */
@@ -0,0 +1,92 @@
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+
+/*
+ * Driver for msstore_winrt_run_workload() of a DLL built with
+ * MSSTORE_WINRT_WORKLOAD.
+ *
+ *   msstore_winrt_workload <dll> train <iterations>
+ *       Runs the workload. With an instrumented DLL (MSSTORE_WINRT_PGO=GENERATE)
+ *       the profile is written next to the DLL when the process exits.
+ *
+ *   msstore_winrt_workload <dll> bench <iterations>
+ *       Prints the DLL load time, the first round and the mean of the
+ *       remaining rounds in microseconds. Every process is one cold-start
+ *       sample, so run it several times per DLL.
+ */
+
+using WorkloadClock = std::chrono::steady_clock;
+using RunWorkload = int64_t (*)(int iterations);
+
+static int64_t micros_since(WorkloadClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(WorkloadClock::now() - start).count();
+}
+
+int wmain(int argc, wchar_t** argv) {
+
+    if (argc != 4 || (std::wcscmp(argv[2], L"train") != 0 && std::wcscmp(argv[2], L"bench") != 0)) {
+        std::fwprintf(stderr, L"Usage: %ls <dll> train|bench <iterations>\n", argv[0]);
+        return 2;
+    }
+
+    const bool bench = std::wcscmp(argv[2], L"bench") == 0;
+    const int iterations = std::max(1, _wtoi(argv[3]));
+
+    const WorkloadClock::time_point loadStart = WorkloadClock::now();
+
+    HMODULE library = ::LoadLibraryW(argv[1]);
+
+    if (library == nullptr) {
+        std::fwprintf(stderr, L"Could not load %ls (error %lu).\n", argv[1], ::GetLastError());
+        return 1;
+    }
+
+    auto runWorkload = reinterpret_cast<RunWorkload>(::GetProcAddress(library, "msstore_winrt_run_workload"));
+
+    if (runWorkload == nullptr) {
+        std::fwprintf(stderr, L"%ls was built without MSSTORE_WINRT_WORKLOAD.\n", argv[1]);
+        return 1;
+    }
+
+    const int64_t loadMicros = micros_since(loadStart);
+
+    if (!bench) {
+
+        const int64_t result = runWorkload(iterations);
+
+        ::FreeLibrary(library);
+
+        return result < 0 ? 1 : 0;
+    }
+
+    const WorkloadClock::time_point firstStart = WorkloadClock::now();
+
+    if (runWorkload(1) < 0)
+        return 1;
+
+    const int64_t firstMicros = micros_since(firstStart);
+
+    double meanMicros = 0;
+
+    if (iterations > 1) {
+
+        const WorkloadClock::time_point restStart = WorkloadClock::now();
+
+        if (runWorkload(iterations - 1) < 0)
+            return 1;
+
+        meanMicros = static_cast<double>(micros_since(restStart)) / (iterations - 1);
+    }
+
+    std::printf("loadMicros=%lld firstMicros=%lld meanMicros=%.2f\n",
+        static_cast<long long>(loadMicros), static_cast<long long>(firstMicros), meanMicros);
+
+    ::FreeLibrary(library);
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "msstore_winrt.h"
+#include "msstore_winrt_internal.h"
+#include "msstore_json.h"
+#include "msstore_snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * Training and benchmark workload for profile-guided builds.
+ *
+ * Runs the conversion code behind the license exports (fingerprinting,
+ * publishing, diffing, marshalling, freeing, CBOR export and JSON field
+ * lookup) on
+ * synthetic licenses shaped like the ones seen in the field, without calling
+ * the Store. Only compiled with MSSTORE_WINRT_WORKLOAD, see CMakeLists.txt;
+ * msstore_winrt_workload.exe drives it.
+ */
+
+static constexpr int64_t DAY_MILLIS = 24LL * 60 * 60 * 1000;
+
+/* Expiration date of perpetual licenses as the Store reports it (year 9999). */
+static constexpr int64_t PERPETUAL_EXPIRATION = 253402300799000LL;
+
+/* Shapes in roughly the proportion they show up: most apps have no or few add-ons. */
+struct LicenseShape {
+    int addOnCount;
+    bool isTrial;
+    bool withOfferTokens;
+};
+
+static constexpr LicenseShape LICENSE_SHAPES[] = {
+    { 0, false, false },  /* paid app, no add-ons */
+    { 0, true, false },   /* trial */
+    { 0, false, false },
+    { 3, false, true },   /* subscription plus two durables */
+    { 3, false, true },
+    { 12, false, true },  /* content packs */
+    { 40, false, true }   /* power user */
+};
+
+/* Abbreviated ExtendedJsonData of a product, in the shape the Store returns. */
+static constexpr std::string_view EXTENDED_JSON =
+    R"({"productId":"9NBLGGH4R315","productType":"Durable","title":"Pro features",)"
+    R"("skuItems":[{"skuId":"0010","title":"Pro","isTrial":false,)"
+    R"("availabilities":[{"availabilityId":"9RJ8CKPDR3JX","orderManagementData":)"
+    R"({"price":{"currencyCode":"EUR","listPrice":4.99,"msrp":4.99}}}],)"
+    R"("collectionData":{"acquiredDate":"2024-03-01T10:00:00Z","quantity":1}}],)"
+    R"("properties":{"packageFamilyName":"Example.App_8wekyb3d8bbwe","isConsumable":false}})";
+
+static constexpr std::string_view JSON_PATHS[] = {
+    "productId",
+    "skuItems[0].skuId",
+    "skuItems[0].availabilities[0].orderManagementData.price.listPrice",
+    "properties.isConsumable",
+    "skuItems[1].skuId" /* missing */
+};
+
+/* Builds a fingerprinted snapshot; round moves one subscription forward to produce changes. */
+static LicenseSnapshot make_license(const LicenseShape& shape, int round, int64_t now) {
+
+    LicenseSnapshot snapshot;
+    snapshot.skuStoreId = "9NBLGGH4R315/0010";
+    snapshot.isActive = true;
+    snapshot.isTrial = shape.isTrial;
+    snapshot.expirationDate = shape.isTrial ? now + 7 * DAY_MILLIS : PERPETUAL_EXPIRATION;
+    snapshot.capturedAt = now;
+
+    char skuStoreId[32];
+
+    for (int index = 0; index < shape.addOnCount; ++index) {
+
+        std::snprintf(skuStoreId, sizeof(skuStoreId), "9P%010d/0010", 1000 + index);
+
+        AddOnSnapshot addOn;
+        addOn.skuStoreId = skuStoreId;
+
+        if (shape.withOfferTokens)
+            addOn.inAppOfferToken = "addon_" + std::to_string(index);
+
+        /* The first add-on is a subscription, renewed every other round. */
+        addOn.expirationDate = index == 0 ? now + (30 + round / 2) * DAY_MILLIS : PERPETUAL_EXPIRATION;
+
+        snapshot.addOns.push_back(std::move(addOn));
+    }
+
+    fingerprint_snapshot(snapshot);
+
+    return snapshot;
+}
+
+/*
+ * Runs iterations rounds over all license shapes.
+ *
+ * Returns a checksum of the results, so nothing is optimized away, or -1
+ * with the last error set.
+ */
+extern "C" MSSTORE_WINRT_API int64_t msstore_winrt_run_workload(int iterations) {
+
+    try {
+
+        int64_t checksum = 0;
+
+        const int64_t now = current_unix_epoch_millis();
+
+        for (int round = 0; round < iterations; ++round) {
+
+            for (const LicenseShape& shape : LICENSE_SHAPES) {
+
+                /* A fresh history per shape, like a process asking for its license. */
+                LicenseSnapshotHistory history;
+
+                history.publish(make_license(shape, round, now));
+
+                const int64_t firstGeneration = history.current()->generation;
+
+                auto snapshot = history.publish(make_license(shape, round + 1, now));
+
+                MsStoreLicenseV2Native* license = marshal_license(*snapshot);
+
+                if (license == nullptr)
+                    return -1;
+
+                checksum += license->AddOnLicensesCount;
+
+                msstore_winrt_free_license_v2(license);
+
+                uint8_t exported[4096];
+
+                checksum += static_cast<int64_t>(encode_license_cbor(*snapshot, exported, sizeof(exported)));
+
+                for (int64_t since : { firstGeneration, snapshot->generation, int64_t(0) }) {
+
+                    MsStoreLicenseChangesNative* changes = marshal_license_changes(history.diff_since(since));
+
+                    if (changes == nullptr)
+                        return -1;
+
+                    checksum += changes->AddedCount + changes->ChangedCount;
+
+                    msstore_winrt_free_license_changes(changes);
+                }
+            }
+
+            std::string_view value;
+
+            for (std::string_view path : JSON_PATHS)
+                if (json_find_path(EXTENDED_JSON, path, value))
+                    checksum += static_cast<int64_t>(value.size());
+        }
+
+        g_lastError.clear();
+
+        return checksum;
+
+    } catch (const std::exception& ex) {
+        g_lastError = ex.what();
+    } catch (...) {
+        g_lastError = "Unknown native error.";
+    }
+
+    return -1;
+}
@@ -13,3 +13,6 @@ plugins {
 
 /* Published project name. */
 rootProject.name = "msstorelib"
+
+/* Kotlin/Native binding for command-line tools, see kotlin-native/build.gradle.kts. */
+include(":kotlin-native")
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+/*
+ * Cold-start probe, run once per fresh JVM by the benchmarkColdStart task.
+ *
+ * Forces the steps that the first MsStore.getLicenseInfo() otherwise does
+ * implicitly, one after the other, and times each of them:
+ *
+ *   launchMillis    JVM start until main() (millisecond clock of the process start)
+ *   classInitMicros initializing the library's entry-point classes
+ *   loaderMicros    MsStoreNativeLoader: resolving, extracting and loading the DLL
+ *   bindMicros      MsStoreNative: reading the ABI and binding all downcalls
+ *   callMicros      the first getLicenseInfo() itself
+ *   totalMicros     main() until the first result
+ *
+ * Prints one line of key=value pairs. A failing license query still counts
+ * as a first result (result=error), since outside a Store-installed package
+ * that is what the native call returns.
+ */
+public fun main() {
+
+    val mainEnteredMillis = System.currentTimeMillis()
+    val startNanos = System.nanoTime()
+
+    for (className in ENTRY_POINT_CLASSES)
+        Class.forName(className)
+
+    val classInitNanos = System.nanoTime()
+
+    /* Any symbol will do; the lookup is created on first access. */
+    MsStoreNativeLoader.lookup.find("msstore_winrt_get_license")
+
+    val loaderNanos = System.nanoTime()
+
+    /* Initializing MsStoreNative reads the ABI and binds every handle. */
+    MsStoreNative.abi.has(MsStoreAbi.CAP_CACHE)
+
+    val bindNanos = System.nanoTime()
+
+    val result = try {
+        MsStore.getLicenseInfo()
+        "ok"
+    } catch (_: MsStoreLicenseException) {
+        "error"
+    }
+
+    val callNanos = System.nanoTime()
+
+    /* After the measured phases: the process handle pulls in classes of its own. */
+    val launchMillis = ProcessHandle.current().info().startInstant()
+        .map { mainEnteredMillis - it.toEpochMilli() }
+        .orElse(-1L)
+
+    println(
+        "launchMillis=$launchMillis" +
+            " classInitMicros=${micros(startNanos, classInitNanos)}" +
+            " loaderMicros=${micros(classInitNanos, loaderNanos)}" +
+            " bindMicros=${micros(loaderNanos, bindNanos)}" +
+            " callMicros=${micros(bindNanos, callNanos)}" +
+            " totalMicros=${micros(startNanos, callNanos)}" +
+            " result=$result"
+    )
+}
+
+private val ENTRY_POINT_CLASSES = listOf(
+    "de.stefan_oltmann.msstore.MsStore",
+    "de.stefan_oltmann.msstore.MsStoreLicense",
+    "de.stefan_oltmann.msstore.MsStoreNativeLoader"
+)
+
+private fun micros(startNanos: Long, endNanos: Long): Long =
+    (endNanos - startNanos) / 1000
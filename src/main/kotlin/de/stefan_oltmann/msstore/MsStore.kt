@@ -16,8 +16,18 @@
  */
 package de.stefan_oltmann.msstore
 
+import de.stefan_oltmann.msstore.model.MsStoreLicenseChanges
 import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStorePendingUpdates
+import de.stefan_oltmann.msstore.model.MsStorePurchaseAttempt
 import de.stefan_oltmann.msstore.model.MsStorePurchaseStatus
+import de.stefan_oltmann.msstore.model.MsStoreShadowPath
+import de.stefan_oltmann.msstore.model.MsStoreShadowStats
+import de.stefan_oltmann.msstore.model.MsStoreSlowCall
+import de.stefan_oltmann.msstore.model.MsStoreUpdateProgress
+import kotlinx.coroutines.flow.Flow
+import java.nio.ByteBuffer
+import java.nio.file.Path
 
 /**
  * Public API entry-point for Microsoft Store license info and purchases.
@@ -32,6 +42,252 @@ public object MsStore {
     public fun getLicenseInfo(): MsStoreLicenseInfo =
         MsStoreLicense.getLicenseInfo()
 
+    /**
+     * Returns the app license info, from the last native snapshot if it is at
+     * most [maxAgeMillis] old. Only queries the Store if it is older.
+     *
+     * Use together with [startLicenseRefresher] instead of polling
+     * [getLicenseInfo] on a timer: the refresher keeps the snapshot fresh, and
+     * this call returns without waiting for the Store.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun getLicenseInfo(maxAgeMillis: Long): MsStoreLicenseInfo =
+        MsStoreLicense.getLicenseInfo(maxAgeMillis)
+
+    /**
+     * Starts refreshing the license snapshot in the background.
+     *
+     * Refreshes every [intervalMillis] while nothing happens. After a license
+     * change it refreshes more often for a while, and shortly after the next
+     * trial or subscription expiration. After errors it backs off
+     * exponentially from [minIntervalMillis] up to [maxIntervalMillis]. All
+     * delays, the first one included, get a jitter that is stable per install
+     * (derived from machine and user unless [jitterSeed] is set), so a fleet
+     * of installs spreads its refreshes instead of hitting the Store at once.
+     *
+     * Calling this again restarts the refresher with the new intervals.
+     *
+     * @throws MsStoreLicenseException when the intervals are out of order or the native call fails.
+     */
+    public fun startLicenseRefresher(
+        intervalMillis: Long,
+        minIntervalMillis: Long = intervalMillis / 10,
+        maxIntervalMillis: Long = intervalMillis * 4,
+        jitterSeed: Long = 0
+    ): Unit =
+        MsStoreLicense.startRefresher(intervalMillis, minIntervalMillis, maxIntervalMillis, jitterSeed)
+
+    /**
+     * Stops the background license refresher. The last snapshot stays cached.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun stopLicenseRefresher(): Unit =
+        MsStoreLicense.stopRefresher()
+
+    /**
+     * Queries the current license and returns the add-on changes since [generation].
+     *
+     * Pass the [MsStoreLicenseInfo.generation] or [MsStoreLicenseChanges.generation]
+     * of the last result you processed. If nothing changed, the returned
+     * generation equals [generation] and all lists are empty. Pass 0 for a
+     * full resync.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun licenseChangesSince(generation: Long): MsStoreLicenseChanges =
+        MsStoreLicense.licenseChangesSince(generation)
+
+    /**
+     * Writes the license as a CBOR document (RFC 8949) into [buffer], starting
+     * at its position, and advances the position past it.
+     *
+     * The document is encoded natively straight from the license snapshot,
+     * without building [MsStoreLicenseInfo] first, so it can be sent to a
+     * backend as is. Its layout and schema ID are documented at
+     * `msstore_winrt_export_license` in `msstore_winrt.h`. A direct buffer is
+     * written in place; a heap buffer takes one extra copy. The document
+     * takes about 70 bytes plus 50 to 100 per add-on, depending on its offer
+     * token.
+     *
+     * Uses the cached license if it is at most [maxAgeMillis] old; 0 always
+     * queries the Store.
+     *
+     * @return the number of bytes written.
+     * @throws MsStoreLicenseException when [buffer] is too small or the native call fails.
+     */
+    public fun exportLicense(buffer: ByteBuffer, maxAgeMillis: Long = 0): Int =
+        MsStoreLicense.exportLicense(buffer, maxAgeMillis)
+
+    /**
+     * Enables or disables keeping `ExtendedJsonData` for [getExtendedJsonField].
+     *
+     * Disabled by default. When enabled, every license query keeps the JSON
+     * documents of the app license and its add-on licenses in native memory.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun setKeepExtendedJson(keep: Boolean): Unit =
+        MsStoreExtendedJson.setKeepExtendedJson(keep)
+
+    /**
+     * Returns one field of the app license `ExtendedJsonData` from the last license query.
+     *
+     * The path uses dots for object keys and `[index]` for array elements,
+     * for example `skuItems[0].skuId`. The result is the raw JSON text of the
+     * value (strings keep their quotes), or null if the field does not exist.
+     *
+     * @throws MsStoreLicenseException when no document was kept or the native call fails.
+     */
+    public fun getExtendedJsonField(path: String): String? =
+        MsStoreExtendedJson.getJsonField(path)
+
+    /**
+     * Returns one field of an add-on license `ExtendedJsonData` from the last license query.
+     *
+     * See [getExtendedJsonField] for the path syntax.
+     *
+     * @throws MsStoreLicenseException when no document was kept or the native call fails.
+     */
+    public fun getAddOnExtendedJsonField(storeId: String, path: String): String? =
+        MsStoreExtendedJson.getAddOnJsonField(storeId, path)
+
+    /**
+     * Compiles entitlement rules into feature gates, one gate per rule.
+     *
+     * The gate ID is the index of the rule in [rules]. A rule combines the
+     * facts `LICENSED` (full license), `TRIAL` (active trial), `ACTIVE` (any
+     * active license) and `ADDON(storeId)` (add-on owned and not expired)
+     * with `AND`, `OR`, `NOT` and parentheses, for example:
+     *
+     * ```
+     * LICENSED OR (TRIAL AND ADDON(9NBLGGH4R315)) OR ADDON(9NBLGGH4R316)
+     * ```
+     *
+     * Feed licenses into [MsStoreFeatureGates.update] and check gates with
+     * [MsStoreFeatureGates.isEnabled].
+     *
+     * @throws MsStoreLicenseException when a rule has a syntax error.
+     */
+    public fun compileFeatureGates(rules: List<String>): MsStoreFeatureGates =
+        MsStoreFeatureGates.compile(rules)
+
+    /**
+     * Returns Store access on behalf of another signed-in Windows user.
+     *
+     * [userId] is the `User.NonRoamableId`, for example from
+     * `Windows.System.User.FindAllAsync()`. The functions on [MsStore] always
+     * use the user running the app.
+     *
+     * @throws MsStoreLicenseException when [userId] is blank.
+     */
+    public fun forUser(userId: String): MsStoreUser {
+
+        /* Prevent wrong use */
+        if (userId.isBlank())
+            throw MsStoreLicenseException("User ID must not be blank.")
+
+        return MsStoreUser(userId)
+    }
+
+    /**
+     * Makes this process the owner of the license broker [name].
+     *
+     * Every license query of this process is then published to a shared
+     * memory segment of the user session, so that other processes connected
+     * to the same broker can read it without asking the Store.
+     *
+     * @throws MsStoreLicenseException when another process already owns the broker
+     *   or the native call fails.
+     */
+    public fun startLicenseBroker(name: String): Unit =
+        MsStoreBroker.startBroker(name)
+
+    /**
+     * Connects this process as client to the license broker [name].
+     *
+     * [getLicenseInfo] then returns the snapshot last published by the owner
+     * if it is at most [maxAgeMillis] old, and only queries the Store itself
+     * otherwise.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun connectLicenseBroker(name: String, maxAgeMillis: Long): Unit =
+        MsStoreBroker.connectBroker(name, maxAgeMillis)
+
+    /**
+     * Closes the license broker of this process, as owner or client.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun closeLicenseBroker(): Unit =
+        MsStoreBroker.closeBroker()
+
+    /**
+     * Returns a JSON document describing the internal state of the native DLL.
+     *
+     * It shows the cached license and its age, whether a Store query is in
+     * flight and the last refresh error, dispatcher queue depth, native
+     * allocations not freed yet, update checker, broker and user cache state,
+     * and the package identity. Never calls the Store, so it also answers
+     * while a license check hangs. The fields are meant for people reading
+     * support logs and may change between versions.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun diagnostics(): String =
+        MsStoreDiagnostics.dumpState()
+
+    /**
+     * Validates an alternative license path against [getLicenseInfo] in production.
+     *
+     * After a sampled [sampleRate] share of [getLicenseInfo] calls, a
+     * reference path and [path] run in the background, one after the other,
+     * and their results are compared field by field. The reference never
+     * reads what [path] reads, see [MsStoreShadowPath]. The calling thread
+     * never waits for this; at most one comparison runs at a time.
+     * Mismatches and the latency difference are counted in [shadowStats].
+     *
+     * Every sample costs an extra Store query, so keep the rate low. Pass 0 to
+     * disable (the default). Each call starts new counters.
+     *
+     * @throws MsStoreLicenseException on a sample rate outside of 0 to 1, or
+     *   if the DLL is too old for [path].
+     */
+    public fun setShadowMode(sampleRate: Double, path: MsStoreShadowPath = MsStoreShadowPath.CachedSnapshot): Unit =
+        MsStoreShadow.configure(sampleRate, path)
+
+    /**
+     * Returns the counters of shadow mode since [setShadowMode] was called.
+     */
+    public fun shadowStats(): MsStoreShadowStats =
+        MsStoreShadow.stats()
+
+    /**
+     * Starts recording license calls that take at least [thresholdMicros].
+     *
+     * Each recorded call keeps its phase breakdown: dispatcher queue wait,
+     * COM apartment setup, Store query, marshalling and JVM decoding. Only
+     * the most recent 64 slow calls are kept. Pass 0 to stop recording; the
+     * calls then don't read the clock at all.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun setSlowCallThreshold(thresholdMicros: Long): Unit =
+        MsStoreSlowCalls.setThreshold(thresholdMicros)
+
+    /**
+     * Returns the recorded slow license calls, oldest first.
+     *
+     * Pass the [MsStoreSlowCall.sequence] of the last record seen to only
+     * get the calls recorded since.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun slowCalls(sinceSequence: Long = 0): List<MsStoreSlowCall> =
+        MsStoreSlowCalls.read(sinceSequence)
+
     /**
      * Requests a purchase for the given Store product ID.
      *
@@ -39,4 +295,117 @@ public object MsStore {
      */
     public fun requestPurchase(storeId: String): MsStorePurchaseStatus =
         MsStorePurchase.requestPurchase(storeId)
+
+    /**
+     * Prepares [requestPurchase] for the window with the native handle
+     * [windowHandle] (an HWND, e.g. `ComposeWindow.windowHandle` or
+     * `Native.getWindowID(frame)`).
+     *
+     * Creates the Store context and binds it to that window ahead of time,
+     * so a later [requestPurchase] only opens the dialog and no longer
+     * guesses the owner from the foreground window. With [storeId], the
+     * product is also fetched in the background to warm the Store's cache.
+     *
+     * Call on the thread that later requests the purchase. Calling again
+     * replaces the prepared window; once it is closed, [requestPurchase]
+     * falls back to the foreground window.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun preparePurchase(windowHandle: Long, storeId: String? = null): Unit =
+        MsStorePurchase.preparePurchase(windowHandle, storeId)
+
+    /**
+     * Lets [requestPurchase] answer from the last license snapshot.
+     *
+     * If the snapshot is at most [maxAgeMillis] old and shows the product as
+     * owned and unexpired, [MsStorePurchaseStatus.AlreadyPurchased] is
+     * returned right away instead of opening the Store UI. This also applies
+     * to [MsStoreUser.requestPurchase] with that user's snapshot.
+     *
+     * Disabled by default; pass 0 to disable again. A product bought in the
+     * Store app after the snapshot was taken is only noticed once the license
+     * is queried again.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun setPurchaseShortCircuit(maxAgeMillis: Long): Unit =
+        MsStorePurchase.setShortCircuit(maxAgeMillis)
+
+    /**
+     * Starts logging every purchase attempt into a memory-mapped file at [path].
+     *
+     * Each attempt is kept as a fixed-size record with product, Store UI open
+     * and close time, status, HRESULT and retry count. Writing a record only
+     * copies it into the mapped file; the operating system writes it to disk
+     * in the background, so purchases never wait for the log. Once [capacity]
+     * attempts are logged, the oldest are overwritten. An existing log with
+     * the same capacity is continued.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun openPurchaseLog(path: Path, capacity: Int = 65536): Unit =
+        MsStorePurchaseLog.open(path, capacity)
+
+    /**
+     * Flushes and closes the purchase log opened by [openPurchaseLog].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun closePurchaseLog(): Unit =
+        MsStorePurchaseLog.close()
+
+    /**
+     * Returns up to [maxCount] logged purchase attempts, oldest first.
+     *
+     * Pass the [MsStorePurchaseAttempt.sequence] of the last record seen to
+     * export the log in batches.
+     *
+     * @throws MsStoreLicenseException when no log is open or the native call fails.
+     */
+    public fun purchaseAttempts(sinceSequence: Long = 0, maxCount: Int = Int.MAX_VALUE): List<MsStorePurchaseAttempt> =
+        MsStorePurchaseLog.read(sinceSequence, maxCount)
+
+    /**
+     * Starts checking for package updates in the background.
+     *
+     * The first check runs right away, then every [intervalMillis] milliseconds.
+     * Calling this again restarts the checker with the new interval.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun startUpdateChecker(intervalMillis: Long): Unit =
+        MsStoreUpdates.startUpdateChecker(intervalMillis)
+
+    /**
+     * Stops the background update checker. The last result stays available.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun stopUpdateChecker(): Unit =
+        MsStoreUpdates.stopUpdateChecker()
+
+    /**
+     * Returns the cached result of the last background update check.
+     *
+     * This never blocks on a Store query and is safe to call from the UI thread.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun pendingUpdates(): MsStorePendingUpdates =
+        MsStoreUpdates.pendingUpdates()
+
+    /**
+     * Downloads and installs all pending updates when collected.
+     *
+     * Progress is buffered natively and emitted in coalesced batches at a
+     * bounded rate. The flow completes after the entry with `isFinal` set.
+     * Cancelling the collection does not cancel the installation.
+     *
+     * The Store may show UI, so the app needs a focused window.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun downloadAndInstallUpdates(): Flow<MsStoreUpdateProgress> =
+        MsStoreUpdates.downloadAndInstallUpdates()
 }
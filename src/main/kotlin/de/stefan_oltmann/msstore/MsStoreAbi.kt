@@ -0,0 +1,176 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+/**
+ * ABI of the loaded `msstore_winrt.dll` as reported by `msstore_winrt_get_abi_info()`.
+ *
+ * DLLs older than that function report [LEGACY]: the original five functions
+ * and the original struct layouts without fingerprints and generations.
+ */
+internal class MsStoreAbi(
+    val abiVersion: Int,
+    val layoutHash: Long,
+    val capabilities: Long,
+    /** Layout hash per struct, indexed by STRUCT_*; shorter for DLLs that have fewer structs. */
+    val structLayoutHashes: LongArray = LongArray(0)
+) {
+
+    /** True for a DLL with the original ABI. */
+    val isLegacy: Boolean
+        get() = abiVersion < 2
+
+    /**
+     * True if the license structs of this DLL can be read: either the legacy
+     * layout or exactly the layout this JAR was built against.
+     */
+    val isLayoutCompatible: Boolean
+        get() = isLegacy || layoutHash == EXPECTED_LAYOUT_HASH
+
+    /**
+     * True if the license calls return the fingerprinted structs
+     * (MsStoreLicenseV2Native), false for the legacy MsStoreLicenseNative.
+     */
+    val hasLicenseV2: Boolean
+        get() = has(CAP_LICENSE_V2)
+
+    fun has(capability: Long): Boolean =
+        capabilities and capability != 0L
+
+    /** True if the DLL has the struct [structId] in exactly the layout this JAR was built against. */
+    fun isStructCompatible(structId: Int): Boolean =
+        structLayoutHashes.getOrNull(structId) == EXPECTED_STRUCT_LAYOUT_HASHES[structId]
+
+    /** Refuses to exchange the struct [structId] with a DLL built from another header. */
+    fun requireStructLayout(structId: Int) {
+
+        if (!isStructCompatible(structId))
+            throw MsStoreLicenseException(
+                "The loaded msstore_winrt.dll uses another layout for ${STRUCT_NAMES[structId]} ($this). " +
+                    "Use the DLL that matches this library version."
+            )
+    }
+
+    override fun toString(): String =
+        "MsStoreAbi(abiVersion=$abiVersion, layoutHash=${layoutHash.toULong().toString(16)}, " +
+            "capabilities=${capabilities.toString(2)})"
+
+    internal companion object {
+
+        /* Capability bits, see MSSTORE_WINRT_CAP_* in msstore_winrt.h. */
+        const val CAP_ASYNC = 1L shl 0
+        const val CAP_PACKED_BLOB = 1L shl 1
+        const val CAP_CACHE = 1L shl 2
+        const val CAP_EVENTS = 1L shl 3
+        const val CAP_UPDATE_CHECKER = 1L shl 4
+        const val CAP_EXTENDED_JSON = 1L shl 5
+        const val CAP_BROKER = 1L shl 6
+        const val CAP_USERS = 1L shl 7
+        const val CAP_PURCHASE_SHORT_CIRCUIT = 1L shl 8
+        const val CAP_DIAGNOSTICS = 1L shl 9
+        const val CAP_SLOW_CALLS = 1L shl 10
+        const val CAP_PURCHASE_LOG = 1L shl 11
+        const val CAP_REFRESHER = 1L shl 12
+        const val CAP_PREPARED_PURCHASE = 1L shl 13
+        const val CAP_DIRECT_LICENSE = 1L shl 14
+        const val CAP_LICENSE_V2 = 1L shl 15
+
+        /* Struct indices, see MSSTORE_WINRT_STRUCT_* in msstore_winrt.h. */
+        const val STRUCT_ADD_ON_LICENSE = 0
+        const val STRUCT_LICENSE = 1
+        const val STRUCT_LICENSE_CHANGES = 2
+        const val STRUCT_PENDING_UPDATES = 3
+        const val STRUCT_UPDATE_PROGRESS = 4
+        const val STRUCT_SLOW_CALL = 5
+        const val STRUCT_PURCHASE_ATTEMPT = 6
+        const val STRUCT_ADD_ON_LICENSE_V2 = 7
+        const val STRUCT_LICENSE_V2 = 8
+
+        /** Size of MsStoreAbiInfoNative without StructLayoutHashes. */
+        const val ABI_INFO_NATIVE_SIZE = 24L
+
+        /** Number of StructLayoutHashes slots in MsStoreAbiInfoNative. */
+        const val STRUCT_LAYOUT_SLOTS = 16
+
+        val LEGACY = MsStoreAbi(abiVersion = 1, layoutHash = 0, capabilities = 0)
+
+        private val STRUCT_NAMES = arrayOf(
+            "MsStoreAddOnLicenseNative",
+            "MsStoreLicenseNative",
+            "MsStoreLicenseChangesNative",
+            "MsStorePendingUpdatesNative",
+            "MsStoreUpdateProgressNative",
+            "MsStoreSlowCallNative",
+            "MsStorePurchaseAttemptNative",
+            "MsStoreAddOnLicenseV2Native",
+            "MsStoreLicenseV2Native"
+        )
+
+        /**
+         * Size and field offsets of each struct, indexed by STRUCT_*.
+         * Mirrors the *_LAYOUT arrays in msstore_abi.cpp.
+         */
+        private val STRUCT_LAYOUTS = arrayOf(
+            /* MsStoreAddOnLicenseNative */
+            intArrayOf(24, 0, 8, 16),
+            /* MsStoreLicenseNative */
+            intArrayOf(40, 0, 8, 9, 16, 24, 32),
+            /* MsStoreLicenseChangesNative */
+            intArrayOf(88, 0, 8, 16, 24, 32, 33, 34, 40, 48, 56, 64, 72, 80),
+            /* MsStorePendingUpdatesNative */
+            intArrayOf(32, 0, 8, 16, 20, 24),
+            /* MsStoreUpdateProgressNative */
+            intArrayOf(168, 0, 8, 16, 24, 32, 36, 37),
+            /* MsStoreSlowCallNative */
+            intArrayOf(208, 0, 8, 16, 24, 32, 40, 48, 56, 64, 68, 72, 73, 74),
+            /* MsStorePurchaseAttemptNative */
+            intArrayOf(64, 0, 8, 16, 24, 28, 32, 36, 37, 38),
+            /* MsStoreAddOnLicenseV2Native */
+            intArrayOf(32, 0, 8, 16, 24),
+            /* MsStoreLicenseV2Native */
+            intArrayOf(56, 0, 8, 9, 16, 24, 32, 40, 48)
+        )
+
+        private const val FNV_OFFSET_BASIS = -3750763034362895579L /* 14695981039346656037 */
+
+        /** Continues 64-bit FNV-1a over [layout], each value as 4 little-endian bytes. */
+        private fun hashLayout(hash: Long, layout: IntArray): Long {
+
+            var result = hash
+
+            for (value in layout) {
+                for (index in 0 until 4) {
+                    result = result xor ((value ushr (index * 8)) and 0xFF).toLong()
+                    result *= 1099511628211L
+                }
+            }
+
+            return result
+        }
+
+        /** Expected LayoutHash: the add-on license layout followed by the license layout. */
+        val EXPECTED_LAYOUT_HASH: Long =
+            hashLayout(
+                hashLayout(FNV_OFFSET_BASIS, STRUCT_LAYOUTS[STRUCT_ADD_ON_LICENSE]),
+                STRUCT_LAYOUTS[STRUCT_LICENSE]
+            )
+
+        /** Expected StructLayoutHashes, indexed by STRUCT_*. */
+        val EXPECTED_STRUCT_LAYOUT_HASHES: LongArray =
+            LongArray(STRUCT_LAYOUTS.size) { hashLayout(FNV_OFFSET_BASIS, STRUCT_LAYOUTS[it]) }
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import java.lang.foreign.MemorySegment
+
+/**
+ * Internal entry-point for the cross-process license broker.
+ *
+ * The owner process publishes every license snapshot it queries into a named
+ * shared memory segment of the user session. Client processes read the
+ * latest snapshot from there in [MsStoreLicense.getLicenseInfo] and only ask
+ * the Store themselves if no fresh snapshot is available.
+ */
+internal object MsStoreBroker {
+
+    /** Maximum accepted snapshot age if this process is a client, null otherwise. */
+    @Volatile
+    private var clientMaxAgeMillis: Long? = null
+
+    /**
+     * Opens the broker as owner.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun startBroker(name: String) {
+        open(name, owner = true, maxAgeMillis = null)
+    }
+
+    /**
+     * Opens the broker as client.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun connectBroker(name: String, maxAgeMillis: Long) {
+
+        /* Prevent wrong use */
+        if (maxAgeMillis <= 0)
+            throw MsStoreLicenseException("Broker snapshot max age must be positive.")
+
+        open(name, owner = false, maxAgeMillis = maxAgeMillis)
+    }
+
+    /**
+     * Closes the broker.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun closeBroker() {
+
+        try {
+
+            clientMaxAgeMillis = null
+
+            MsStoreNative.brokerClose()
+
+        } catch (ex: Throwable) {
+            /* Wrap everything in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Broker close failed.")
+        }
+    }
+
+    /**
+     * Returns the latest broker snapshot as MsStoreLicenseV2Native pointer, or
+     * null if this process is no client or no fresh snapshot is available.
+     *
+     * The caller must free it by calling [MsStoreNative.freeLicense].
+     */
+    fun readLicense(): MemorySegment? {
+
+        val maxAgeMillis = clientMaxAgeMillis ?: return null
+
+        return MsStoreNative.brokerReadLicense(maxAgeMillis)
+    }
+
+    private fun open(name: String, owner: Boolean, maxAgeMillis: Long?) {
+
+        try {
+
+            /* Prevent wrong use */
+            if (name.isBlank())
+                throw MsStoreLicenseException("Broker name must not be blank.")
+
+            clientMaxAgeMillis = null
+
+            if (MsStoreNative.brokerOpen(name, owner) < 0)
+                throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Native broker open failed.")
+
+            clientMaxAgeMillis = maxAgeMillis
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Broker open failed.")
+        }
+    }
+}
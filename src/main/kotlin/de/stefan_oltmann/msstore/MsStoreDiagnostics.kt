@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout
+import java.nio.charset.StandardCharsets
+
+/**
+ * Internal entry-point for native diagnostics.
+ */
+internal object MsStoreDiagnostics {
+
+    /* The state may grow between sizing and writing; retry a few times. */
+    private const val MAX_ATTEMPTS = 4
+
+    /**
+     * Returns the JSON state document of the native DLL.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun dumpState(): String {
+
+        try {
+
+            var length = MsStoreNative.dumpState(MemorySegment.NULL, 0)
+
+            repeat(MAX_ATTEMPTS) {
+
+                if (length < 0)
+                    throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Native state dump failed.")
+
+                Arena.ofConfined().use { arena ->
+
+                    /* Some headroom for state that changes in between. */
+                    val size = length + length / 4 + 1
+
+                    val buffer = arena.allocate(size)
+
+                    length = MsStoreNative.dumpState(buffer, size)
+
+                    if (length in 0 until size) {
+
+                        val bytes = ByteArray(length.toInt())
+
+                        MemorySegment.copy(buffer, ValueLayout.JAVA_BYTE, 0, bytes, 0, bytes.size)
+
+                        return String(bytes, StandardCharsets.UTF_8)
+                    }
+                }
+            }
+
+            throw MsStoreLicenseException("Native state kept growing while it was dumped.")
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Native state dump failed.")
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo.Companion.STORE_ID_LENGTH
+import java.lang.foreign.MemorySegment
+
+/**
+ * Internal entry-point for on-demand access to `ExtendedJsonData`.
+ *
+ * When enabled, the native layer keeps the `ExtendedJsonData` documents of
+ * the last license query. Single fields are looked up natively by path, so
+ * the full document is never transferred to or parsed in the JVM.
+ *
+ * @see https://learn.microsoft.com/uwp/api/windows.services.store.storeapplicense.extendedjsondata
+ */
+internal object MsStoreExtendedJson {
+
+    /**
+     * Enables or disables keeping `ExtendedJsonData` on license queries.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun setKeepExtendedJson(keep: Boolean) {
+
+        try {
+
+            MsStoreNative.setKeepExtendedJson(keep)
+
+        } catch (ex: Throwable) {
+            /* Wrap everything in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Setting ExtendedJsonData mode failed.")
+        }
+    }
+
+    /**
+     * Returns the raw JSON value at [path] in the app license document, or null if missing.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun getJsonField(path: String): String? =
+        readField { MsStoreNative.getJsonField(path) }
+
+    /**
+     * Returns the raw JSON value at [path] in the add-on license document, or null if missing.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun getAddOnJsonField(storeId: String, path: String): String? {
+
+        /* Prevent wrong use */
+        if (storeId.length != STORE_ID_LENGTH)
+            throw MsStoreLicenseException("Store ID must be 12 characters long.")
+
+        return readField { MsStoreNative.getAddOnJsonField(storeId, path) }
+    }
+
+    private fun readField(nativeCall: () -> MemorySegment?): String? {
+
+        try {
+
+            val pointer = nativeCall()
+
+            if (pointer != null)
+                return MsStoreNativeHelpers.readUtf8AndFree(pointer)
+
+            /* An empty error means the field does not exist. */
+            val error = MsStoreNativeHelpers.readLastError()
+
+            if (error.isNullOrEmpty())
+                return null
+
+            throw MsStoreLicenseException(error)
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "ExtendedJsonData query failed.")
+        }
+    }
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import java.util.concurrent.atomic.AtomicReference
+
+/**
+ * Feature gates compiled from entitlement rules.
+ *
+ * Each rule is compiled once into a flat program. Programs are only run
+ * again when [update] sees a license with another generation, or when the
+ * earliest expiration date a rule depends on has passed. In between,
+ * [isEnabled] is a single bit test, so gates can be checked on hot paths.
+ *
+ * The gate ID is the index of the rule in the list passed to
+ * [MsStore.compileFeatureGates]. See there for the rule syntax.
+ *
+ * Use one instance per license source: generations of the app user and of
+ * an [MsStoreUser] are counted independently.
+ *
+ * This class is thread-safe.
+ */
+public class MsStoreFeatureGates internal constructor(
+    private val programs: Array<MsStoreRuleProgram>,
+    private val addOnFacts: Map<String, Int>
+) {
+
+    /**
+     * Evaluation result for one license. Replaced as a whole, never mutated.
+     *
+     * [validUntil] is the earliest expiration date after the evaluation that
+     * can flip a fact, or [Long.MAX_VALUE] if there is none.
+     */
+    private class State(
+        val license: MsStoreLicenseInfo?,
+        val validUntil: Long,
+        val bits: LongArray
+    )
+
+    private val state = AtomicReference(State(null, Long.MAX_VALUE, LongArray(wordCount(programs.size))))
+
+    /** Number of gates, the valid gate IDs are `0 until gateCount`. */
+    public val gateCount: Int
+        get() = programs.size
+
+    /**
+     * Evaluates all gates against [license], unless they already were for
+     * its generation and no relevant expiration date has passed since.
+     *
+     * Returns true if the gates were evaluated again.
+     */
+    public fun update(license: MsStoreLicenseInfo, nowMillis: Long = System.currentTimeMillis()): Boolean {
+
+        val current = state.get()
+
+        /* Generation 0 means "unknown", for example a license built in code. */
+        if (current.license != null &&
+            license.generation != 0L &&
+            license.generation == current.license.generation &&
+            nowMillis < current.validUntil
+        )
+            return false
+
+        state.set(evaluate(license, nowMillis))
+
+        return true
+    }
+
+    /**
+     * Returns whether the gate [gateId] is enabled.
+     *
+     * All gates are disabled until the first [update]. If an expiration date
+     * of the last license passed, the gates are evaluated again first.
+     */
+    public fun isEnabled(gateId: Int): Boolean {
+
+        /* Prevent wrong use */
+        if (gateId < 0 || gateId >= programs.size)
+            throw MsStoreLicenseException("Gate ID $gateId is out of range 0 until ${programs.size}.")
+
+        var current = state.get()
+
+        if (current.license != null && current.validUntil != Long.MAX_VALUE) {
+
+            val nowMillis = System.currentTimeMillis()
+
+            while (current.license != null && nowMillis >= current.validUntil) {
+
+                val reevaluated = evaluate(current.license, nowMillis)
+
+                /* Only replace what was evaluated; an update() in between has the newer license. */
+                if (state.compareAndSet(current, reevaluated)) {
+                    current = reevaluated
+                    break
+                }
+
+                current = state.get()
+            }
+        }
+
+        return current.bits[gateId ushr 6] and (1L shl gateId) != 0L
+    }
+
+    /**
+     * Returns a copy of the gate bitmask: gate `n` is enabled if bit
+     * `n % 64` of word `n / 64` is set.
+     */
+    public fun bitmask(): LongArray =
+        state.get().bits.copyOf()
+
+    private fun evaluate(license: MsStoreLicenseInfo, nowMillis: Long): State {
+
+        val facts = BooleanArray(MsStoreRuleCompiler.FIRST_ADDON_FACT + addOnFacts.size)
+        var validUntil = Long.MAX_VALUE
+
+        val appUnexpired = isUnexpired(license.expirationDate, nowMillis)
+
+        if (license.isActive && license.expirationDate > nowMillis)
+            validUntil = license.expirationDate
+
+        facts[MsStoreRuleCompiler.FACT_ACTIVE] = license.isActive && appUnexpired
+        facts[MsStoreRuleCompiler.FACT_LICENSED] = facts[MsStoreRuleCompiler.FACT_ACTIVE] && !license.isTrial
+        facts[MsStoreRuleCompiler.FACT_TRIAL] = facts[MsStoreRuleCompiler.FACT_ACTIVE] && license.isTrial
+
+        for (addOn in license.addOnLicenses) {
+
+            val fact = addOnFacts[addOn.storeId.uppercase()] ?: continue
+
+            if (!isUnexpired(addOn.expirationDate, nowMillis))
+                continue
+
+            facts[fact] = true
+
+            if (addOn.expirationDate != 0L && addOn.expirationDate < validUntil)
+                validUntil = addOn.expirationDate
+        }
+
+        val bits = LongArray(wordCount(programs.size))
+        val stack = BooleanArray(programs.maxOfOrNull { it.maxStack } ?: 0)
+
+        for ((gateId, program) in programs.withIndex())
+            if (run(program, facts, stack))
+                bits[gateId ushr 6] = bits[gateId ushr 6] or (1L shl gateId)
+
+        return State(license, validUntil, bits)
+    }
+
+    private fun run(program: MsStoreRuleProgram, facts: BooleanArray, stack: BooleanArray): Boolean {
+
+        var top = -1
+
+        for (code in program.code) {
+
+            when (code) {
+
+                MsStoreRuleCompiler.OP_AND -> {
+                    top--
+                    stack[top] = stack[top] && stack[top + 1]
+                }
+
+                MsStoreRuleCompiler.OP_OR -> {
+                    top--
+                    stack[top] = stack[top] || stack[top + 1]
+                }
+
+                MsStoreRuleCompiler.OP_NOT ->
+                    stack[top] = !stack[top]
+
+                else -> {
+                    top++
+                    stack[top] = facts[code]
+                }
+            }
+        }
+
+        return stack[0]
+    }
+
+    internal companion object {
+
+        /**
+         * Compiles [rules] into gates.
+         *
+         * @throws MsStoreLicenseException on syntax errors.
+         */
+        fun compile(rules: List<String>): MsStoreFeatureGates {
+
+            val compiler = MsStoreRuleCompiler()
+
+            val programs = rules.map { compiler.compile(it) }.toTypedArray()
+
+            return MsStoreFeatureGates(programs, compiler.addOnFacts.toMap())
+        }
+
+        private fun wordCount(gateCount: Int): Int =
+            (gateCount + 63) ushr 6
+
+        /* Same semantics as MsStoreLicenseInfo.isExpired: 0 means no expiration date. */
+        private fun isUnexpired(expirationDate: Long, nowMillis: Long): Boolean =
+            expirationDate == 0L || nowMillis < expirationDate
+    }
+}
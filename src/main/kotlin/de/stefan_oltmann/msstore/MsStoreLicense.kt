@@ -17,9 +17,12 @@
 package de.stefan_oltmann.msstore
 
 import de.stefan_oltmann.msstore.model.MsStoreAddOnLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreLicenseChanges
 import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import java.lang.foreign.Arena
 import java.lang.foreign.MemorySegment
 import java.lang.foreign.ValueLayout
+import java.nio.ByteBuffer
 
 /**
  * Internal entry-point for retrieving Microsoft Store license info.
@@ -33,8 +36,25 @@ import java.lang.foreign.ValueLayout
  */
 internal object MsStoreLicense {
 
-    private const val MSSTORE_LICENSE_NATIVE_SIZE = 40L
-    private const val MSSTORE_ADDON_LICENSE_NATIVE_SIZE = 24L
+    private const val MSSTORE_LICENSE_V2_NATIVE_SIZE = 56L
+    private const val MSSTORE_ADDON_LICENSE_V2_NATIVE_SIZE = 32L
+    private const val MSSTORE_LICENSE_CHANGES_NATIVE_SIZE = 88L
+
+    /* Struct sizes of MsStoreLicenseNative and MsStoreAddOnLicenseNative, without fingerprints and generations. */
+    private const val LEGACY_LICENSE_NATIVE_SIZE = 40L
+    private const val LEGACY_ADDON_LICENSE_NATIVE_SIZE = 24L
+
+    /*
+     * Last decoded license, for structural sharing.
+     *
+     * Decoding compares the native fingerprints with it before reading any
+     * string: an unchanged license is returned as this instance, unchanged
+     * add-ons as its add-on instances. Periodic refreshes then allocate
+     * nothing but the entries that changed. Concurrent decodes may overwrite
+     * each other, which only costs sharing.
+     */
+    @Volatile
+    private var lastLicenseInfo: MsStoreLicenseInfo? = null
 
     /**
      * Returns the current app license info.
@@ -43,15 +63,222 @@ internal object MsStoreLicense {
      */
     fun getLicenseInfo(): MsStoreLicenseInfo {
 
+        val licenseInfo = queryLicenseInfo {
+
+            /* A broker client reads the owner's snapshot and only falls back to the Store. */
+            MsStoreBroker.readLicense() ?: MsStoreNative.getLicense()
+        }
+
+        MsStoreShadow.onLicenseCall()
+
+        return licenseInfo
+    }
+
+    /**
+     * Returns the app license info, from the native snapshot if at most [maxAgeMillis] old.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun getLicenseInfo(maxAgeMillis: Long): MsStoreLicenseInfo =
+        queryLicenseInfo {
+            MsStoreBroker.readLicense() ?: MsStoreNative.getCachedLicense(maxAgeMillis)
+        }
+
+    /**
+     * Decodes the license returned by [query] without sharing instances with
+     * the last license, for shadow comparisons.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun readLicenseInfoUnshared(query: () -> MemorySegment?): MsStoreLicenseInfo =
+        queryLicenseInfo(shared = false, query)
+
+    /**
+     * Starts (or restarts) the background license refresher.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun startRefresher(intervalMillis: Long, minIntervalMillis: Long, maxIntervalMillis: Long, jitterSeed: Long) {
+
+        try {
+
+            /* Prevent wrong use */
+            if (minIntervalMillis <= 0 || minIntervalMillis > intervalMillis || intervalMillis > maxIntervalMillis)
+                throw MsStoreLicenseException(
+                    "Refresh intervals must be positive with minIntervalMillis <= intervalMillis <= maxIntervalMillis."
+                )
+
+            if (MsStoreNative.startLicenseRefresher(intervalMillis, minIntervalMillis, maxIntervalMillis, jitterSeed) < 0)
+                throw MsStoreLicenseException(
+                    MsStoreNativeHelpers.readLastError() ?: "Native license refresher start failed."
+                )
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "License refresher start failed.")
+        }
+    }
+
+    /**
+     * Stops the background license refresher.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun stopRefresher() {
+
+        try {
+
+            MsStoreNative.stopLicenseRefresher()
+
+        } catch (ex: Throwable) {
+            /* Wrap everything in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "License refresher stop failed.")
+        }
+    }
+
+    /**
+     * Queries the current license and returns the add-on changes since [sinceGeneration].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun licenseChangesSince(sinceGeneration: Long): MsStoreLicenseChanges =
+        queryLicenseChanges { MsStoreNative.getLicenseChanges(sinceGeneration) }
+
+    /**
+     * Returns the app license info of the user [userId], cached for up to [maxAgeMillis].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun getUserLicenseInfo(userId: String, maxAgeMillis: Long): MsStoreLicenseInfo =
+        queryLicenseInfo { MsStoreNative.getUserLicense(userId, maxAgeMillis) }
+
+    /**
+     * Queries the license of the user [userId] and returns the add-on changes since [sinceGeneration].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun userLicenseChangesSince(userId: String, sinceGeneration: Long): MsStoreLicenseChanges =
+        queryLicenseChanges { MsStoreNative.getUserLicenseChanges(userId, sinceGeneration) }
+
+    /**
+     * Writes the license as CBOR into [buffer] and returns the number of bytes written.
+     *
+     * @throws MsStoreLicenseException when the buffer is too small or the native call fails.
+     */
+    fun exportLicense(buffer: ByteBuffer, maxAgeMillis: Long): Int {
+
         try {
 
-            val pointer = MsStoreNative.getLicense()
-                ?: throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Native license query failed.")
+            /* Prevent wrong use */
+            if (buffer.isReadOnly)
+                throw MsStoreLicenseException("License export buffer is read-only.")
+
+            val remaining = buffer.remaining().toLong()
+
+            val length = if (buffer.isDirect) {
+
+                /* Native code writes straight into a direct buffer. */
+                MsStoreNative.exportLicense(MemorySegment.ofBuffer(buffer), remaining, maxAgeMillis)
+
+            } else {
+
+                Arena.ofConfined().use { arena ->
+
+                    val segment = arena.allocate(remaining)
+
+                    val length = MsStoreNative.exportLicense(segment, remaining, maxAgeMillis)
+
+                    if (length in 0..remaining)
+                        MemorySegment.copy(segment, 0, MemorySegment.ofBuffer(buffer), 0, length)
+
+                    length
+                }
+            }
+
+            if (length < 0)
+                throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Native license export failed.")
+
+            if (length > remaining)
+                throw MsStoreLicenseException(
+                    "License export needs $length bytes, but the buffer has only $remaining remaining."
+                )
+
+            buffer.position(buffer.position() + length.toInt())
+
+            return length.toInt()
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "License export failed.")
+        }
+    }
+
+    private inline fun queryLicenseInfo(shared: Boolean = true, query: () -> MemorySegment?): MsStoreLicenseInfo {
+
+        try {
+
+            requireLicenseLayout()
+
+            val pointer = query()
+
+            val decodeStartNanos = MsStoreSlowCalls.startTiming()
+
+            if (pointer == null) {
+
+                val error = MsStoreNativeHelpers.readLastError()
+
+                MsStoreSlowCalls.commit(decodeStartNanos)
+
+                throw MsStoreLicenseException(error ?: "Native license query failed.")
+            }
 
             try {
-                return readLicenseInfo(pointer)
+                return readLicenseInfo(pointer, shared)
             } finally {
                 MsStoreNative.freeLicense(pointer)
+                MsStoreSlowCalls.commit(decodeStartNanos)
+            }
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "License query failed.")
+        }
+    }
+
+    private inline fun queryLicenseChanges(query: () -> MemorySegment?): MsStoreLicenseChanges {
+
+        try {
+
+            MsStoreNative.abi.requireStructLayout(MsStoreAbi.STRUCT_LICENSE_CHANGES)
+            MsStoreNative.abi.requireStructLayout(MsStoreAbi.STRUCT_ADD_ON_LICENSE_V2)
+
+            val pointer = query()
+
+            val decodeStartNanos = MsStoreSlowCalls.startTiming()
+
+            if (pointer == null) {
+
+                val error = MsStoreNativeHelpers.readLastError()
+
+                MsStoreSlowCalls.commit(decodeStartNanos)
+
+                throw MsStoreLicenseException(error ?: "Native license query failed.")
+            }
+
+            try {
+                return readLicenseChanges(pointer)
+            } finally {
+                MsStoreNative.freeLicenseChanges(pointer)
+                MsStoreSlowCalls.commit(decodeStartNanos)
             }
 
         } catch (ex: MsStoreLicenseException) {
@@ -63,12 +290,35 @@ internal object MsStoreLicense {
         }
     }
 
-    private fun readLicenseInfo(pointer: MemorySegment): MsStoreLicenseInfo {
+    /** Refuses to read the license structs of a DLL built from another header. */
+    private fun requireLicenseLayout() {
+
+        val abi = MsStoreNative.abi
 
-        val licenseStruct = pointer.reinterpret(MSSTORE_LICENSE_NATIVE_SIZE)
+        if (abi.hasLicenseV2) {
+
+            abi.requireStructLayout(MsStoreAbi.STRUCT_LICENSE_V2)
+            abi.requireStructLayout(MsStoreAbi.STRUCT_ADD_ON_LICENSE_V2)
+
+        } else if (!abi.isLayoutCompatible) {
+
+            throw MsStoreLicenseException(
+                "The loaded msstore_winrt.dll uses other struct layouts ($abi). " +
+                    "Use the DLL that matches this library version."
+            )
+        }
+    }
+
+    private fun readLicenseInfo(pointer: MemorySegment, shared: Boolean): MsStoreLicenseInfo {
+
+        val isV2 = MsStoreNative.abi.hasLicenseV2
+
+        val licenseStruct = pointer.reinterpret(
+            if (isV2) MSSTORE_LICENSE_V2_NATIVE_SIZE else LEGACY_LICENSE_NATIVE_SIZE
+        )
 
         /*
-         * Layout must match the C struct MsStoreLicenseNative:
+         * Layout must match the C struct MsStoreLicenseV2Native:
          * 0: SkuStoreId (ADDRESS)
          * 8: IsActive (BYTE/BOOL)
          * 9: IsTrial (BYTE/BOOL)
@@ -76,9 +326,21 @@ internal object MsStoreLicense {
          * 16: ExpirationDate (LONG)
          * 24: AddOnLicenses (ADDRESS)
          * 32: AddOnLicensesCount (INT)
-         * (Padding to 40)
+         * 36-39: (Padding to align int64)
+         * 40: Fingerprint (LONG), not in MsStoreLicenseNative
+         * 48: Generation (LONG), not in MsStoreLicenseNative
          */
 
+        val fingerprint = if (isV2) licenseStruct.get(ValueLayout.JAVA_LONG, 40) else 0L
+        val generation = if (isV2) licenseStruct.get(ValueLayout.JAVA_LONG, 48) else 0L
+
+        val previous = if (shared) lastLicenseInfo else null
+
+        /* Nothing changed: not even the strings need to be read. */
+        if (fingerprint != 0L && previous != null &&
+            previous.fingerprint == fingerprint && previous.generation == generation)
+            return previous
+
         val skuStoreId = readString(licenseStruct, 0) ?: ""
 
         val isActive = licenseStruct.get(ValueLayout.JAVA_BOOLEAN, 8)
@@ -87,21 +349,11 @@ internal object MsStoreLicense {
         val addOnLicensesPointer = licenseStruct.get(ValueLayout.ADDRESS, 24)
         val addOnLicensesCount = licenseStruct.get(ValueLayout.JAVA_INT, 32)
 
-        val addOns = mutableListOf<MsStoreAddOnLicenseInfo>()
-
-        if (addOnLicensesPointer.address() != 0L && addOnLicensesCount > 0) {
-
-            val addOnLicensesStructArray =
-                addOnLicensesPointer.reinterpret(addOnLicensesCount.toLong() * MSSTORE_ADDON_LICENSE_NATIVE_SIZE)
-
-            for (index in 0 until addOnLicensesCount) {
-
-                /* Struct size: 2 pointers (2*8) + int64 expiration (8) = 24. */
-                val offset = index * MSSTORE_ADDON_LICENSE_NATIVE_SIZE
-
-                addOns.add(readAddOnLicenseInfo(addOnLicensesStructArray, offset))
-            }
-        }
+        val addOns = readAddOnLicenseInfos(
+            addOnLicensesPointer,
+            addOnLicensesCount,
+            previous?.addOnLicenses.orEmpty()
+        )
 
         /*
          * SkuStoreId is a combination of Store ID and SKU ID.
@@ -116,27 +368,132 @@ internal object MsStoreLicense {
         val storeId = skuStoreId.take(MsStoreLicenseInfo.STORE_ID_LENGTH)
         val skuId = skuStoreId.drop(MsStoreLicenseInfo.STORE_ID_LENGTH + 1)
 
-        return MsStoreLicenseInfo(
+        val licenseInfo = MsStoreLicenseInfo(
             storeId = storeId,
             skuId = skuId,
             expirationDate = expirationDate,
             isActive = isActive,
             isTrial = isTrial,
-            addOnLicenses = addOns
+            addOnLicenses = addOns,
+            fingerprint = fingerprint,
+            generation = generation
         )
+
+        if (shared)
+            lastLicenseInfo = licenseInfo
+
+        return licenseInfo
+    }
+
+    private fun readLicenseChanges(pointer: MemorySegment): MsStoreLicenseChanges {
+
+        val changesStruct = pointer.reinterpret(MSSTORE_LICENSE_CHANGES_NATIVE_SIZE)
+
+        /*
+         * Layout must match the C struct MsStoreLicenseChangesNative:
+         * 0: Generation (LONG)
+         * 8: Fingerprint (LONG)
+         * 16: SkuStoreId (ADDRESS)
+         * 24: ExpirationDate (LONG)
+         * 32: IsActive (BYTE/BOOL)
+         * 33: IsTrial (BYTE/BOOL)
+         * 34: IsFullResync (BYTE/BOOL)
+         * 35-39: (Padding to align pointer)
+         * 40: Added (ADDRESS)
+         * 48: AddedCount (INT)
+         * 56: Removed (ADDRESS)
+         * 64: RemovedCount (INT)
+         * 72: Changed (ADDRESS)
+         * 80: ChangedCount (INT)
+         * (Padding to 88)
+         */
+
+        val skuStoreId = readString(changesStruct, 16) ?: ""
+
+        /* Added and changed add-ons may already be known from the last license. */
+        val known = lastLicenseInfo?.addOnLicenses.orEmpty()
+
+        return MsStoreLicenseChanges(
+            generation = changesStruct.get(ValueLayout.JAVA_LONG, 0),
+            fingerprint = changesStruct.get(ValueLayout.JAVA_LONG, 8),
+            storeId = skuStoreId.take(MsStoreLicenseInfo.STORE_ID_LENGTH),
+            skuId = skuStoreId.drop(MsStoreLicenseInfo.STORE_ID_LENGTH + 1),
+            expirationDate = changesStruct.get(ValueLayout.JAVA_LONG, 24),
+            isActive = changesStruct.get(ValueLayout.JAVA_BOOLEAN, 32),
+            isTrial = changesStruct.get(ValueLayout.JAVA_BOOLEAN, 33),
+            isFullResync = changesStruct.get(ValueLayout.JAVA_BOOLEAN, 34),
+            added = readAddOnLicenseInfos(
+                changesStruct.get(ValueLayout.ADDRESS, 40),
+                changesStruct.get(ValueLayout.JAVA_INT, 48),
+                known
+            ),
+            removed = readAddOnLicenseInfos(
+                changesStruct.get(ValueLayout.ADDRESS, 56),
+                changesStruct.get(ValueLayout.JAVA_INT, 64),
+                known
+            ),
+            changed = readAddOnLicenseInfos(
+                changesStruct.get(ValueLayout.ADDRESS, 72),
+                changesStruct.get(ValueLayout.JAVA_INT, 80),
+                known
+            )
+        )
+    }
+
+    /**
+     * Reads an add-on array, reusing the instances of [known] with the same fingerprint.
+     *
+     * Returns [known] itself if every entry matches it in order.
+     */
+    private fun readAddOnLicenseInfos(
+        arrayPointer: MemorySegment,
+        count: Int,
+        known: List<MsStoreAddOnLicenseInfo>
+    ): List<MsStoreAddOnLicenseInfo> {
+
+        if (arrayPointer.address() == 0L || count <= 0)
+            return emptyList()
+
+        val isV2 = MsStoreNative.abi.hasLicenseV2
+
+        /* Struct size: 2 pointers (2*8) + int64 expiration (8) + uint64 fingerprint (8) = 32, legacy 24. */
+        val structSize = if (isV2) MSSTORE_ADDON_LICENSE_V2_NATIVE_SIZE else LEGACY_ADDON_LICENSE_NATIVE_SIZE
+
+        val addOnLicensesStructArray =
+            arrayPointer.reinterpret(count.toLong() * structSize)
+
+        /* Legacy structs have no fingerprints to match. */
+        if (!isV2 || known.isEmpty())
+            return List(count) { index -> readAddOnLicenseInfo(addOnLicensesStructArray, index * structSize) }
+
+        fun fingerprintAt(index: Int): Long =
+            addOnLicensesStructArray.get(ValueLayout.JAVA_LONG, index * structSize + 24)
+
+        /* Both lists are sorted by SkuStoreId, so an unchanged list matches position by position. */
+        if (count == known.size && (0 until count).all { index -> known[index].fingerprint == fingerprintAt(index) })
+            return known
+
+        val knownByFingerprint = known.associateBy { it.fingerprint }
+
+        return List(count) { index ->
+            knownByFingerprint[fingerprintAt(index)]
+                ?: readAddOnLicenseInfo(addOnLicensesStructArray, index * structSize)
+        }
     }
 
     private fun readAddOnLicenseInfo(pointer: MemorySegment, offset: Long): MsStoreAddOnLicenseInfo {
 
         /*
-         * Layout must match MsStoreAddOnLicenseNative:
+         * Layout must match MsStoreAddOnLicenseV2Native:
          * 0: SkuStoreId (ADDRESS)
          * 8: InAppOfferToken (ADDRESS)
          * 16: ExpirationDate (LONG)
+         * 24: Fingerprint (LONG), not in MsStoreAddOnLicenseNative
          */
         val skuStoreId = readString(pointer, offset + 0) ?: ""
         val inAppOfferToken = readString(pointer, offset + 8) ?: ""
         val expirationDate = pointer.get(ValueLayout.JAVA_LONG, offset + 16)
+        val fingerprint = if (MsStoreNative.abi.hasLicenseV2) pointer.get(ValueLayout.JAVA_LONG, offset + 24) else 0L
 
         val storeId = skuStoreId.take(MsStoreLicenseInfo.STORE_ID_LENGTH)
         val skuId = skuStoreId.drop(MsStoreLicenseInfo.STORE_ID_LENGTH + 1)
@@ -145,7 +502,8 @@ internal object MsStoreLicense {
             storeId = storeId,
             skuId = skuId,
             inAppOfferToken = inAppOfferToken,
-            expirationDate = expirationDate
+            expirationDate = expirationDate,
+            fingerprint = fingerprint
         )
     }
 
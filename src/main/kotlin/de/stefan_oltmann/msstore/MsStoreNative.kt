@@ -18,6 +18,7 @@ package de.stefan_oltmann.msstore
 
 import de.stefan_oltmann.msstore.MsStoreNative.free
 import de.stefan_oltmann.msstore.MsStoreNative.freeLicense
+import de.stefan_oltmann.msstore.MsStoreNative.freeLicenseChanges
 import java.lang.foreign.Arena
 import java.lang.foreign.FunctionDescriptor
 import java.lang.foreign.Linker
@@ -28,12 +29,20 @@ import java.nio.charset.StandardCharsets
 
 /**
  * FFM bindings to the C++/WinRT DLL (msstore_winrt.dll).
+ *
+ * Only the functions of the original ABI are required. Everything else is
+ * bound if the DLL reports the capability in `msstore_winrt_get_abi_info()`,
+ * so an older app-local DLL keeps working with a newer JAR; calling an
+ * unsupported function throws [MsStoreLicenseException].
  */
 internal object MsStoreNative {
 
     /** Entrypoint for creating downcall handles to native symbols. */
     private val linker: Linker = Linker.nativeLinker()
 
+    /** ABI of the loaded DLL, [MsStoreAbi.LEGACY] if it predates `msstore_winrt_get_abi_info`. */
+    val abi: MsStoreAbi = readAbi()
+
     /** Handle for `MsStoreLicenseNative* msstore_winrt_get_license()`. */
     private val getLicenseHandle: MethodHandle = downcall(
         symbolName = "msstore_winrt_get_license",
@@ -46,6 +55,68 @@ internal object MsStoreNative {
         descriptor = FunctionDescriptor.ofVoid(ValueLayout.ADDRESS)
     )
 
+    /** Handle for `MsStoreLicenseV2Native* msstore_winrt_get_license_v2()`. */
+    private val getLicenseV2Handle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_LICENSE_V2,
+        symbolName = "msstore_winrt_get_license_v2",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `void msstore_winrt_free_license_v2(MsStoreLicenseV2Native*)`. */
+    private val freeLicenseV2Handle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_LICENSE_V2,
+        symbolName = "msstore_winrt_free_license_v2",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `MsStoreLicenseV2Native* msstore_winrt_get_cached_license(int64_t)`. */
+    private val getCachedLicenseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_REFRESHER,
+        symbolName = "msstore_winrt_get_cached_license",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `MsStoreLicenseV2Native* msstore_winrt_get_license_direct()`. */
+    private val getLicenseDirectHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_DIRECT_LICENSE,
+        symbolName = "msstore_winrt_get_license_direct",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `int msstore_winrt_start_license_refresher(int64_t, int64_t, int64_t, uint64_t)`. */
+    private val startLicenseRefresherHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_REFRESHER,
+        symbolName = "msstore_winrt_start_license_refresher",
+        descriptor = FunctionDescriptor.of(
+            ValueLayout.JAVA_INT,
+            ValueLayout.JAVA_LONG,
+            ValueLayout.JAVA_LONG,
+            ValueLayout.JAVA_LONG,
+            ValueLayout.JAVA_LONG
+        )
+    )
+
+    /** Handle for `void msstore_winrt_stop_license_refresher()`. */
+    private val stopLicenseRefresherHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_REFRESHER,
+        symbolName = "msstore_winrt_stop_license_refresher",
+        descriptor = FunctionDescriptor.ofVoid()
+    )
+
+    /** Handle for `MsStoreLicenseChangesNative* msstore_winrt_get_license_changes(int64_t)`. */
+    private val getLicenseChangesHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_CACHE,
+        symbolName = "msstore_winrt_get_license_changes",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `void msstore_winrt_free_license_changes(MsStoreLicenseChangesNative*)`. */
+    private val freeLicenseChangesHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_CACHE,
+        symbolName = "msstore_winrt_free_license_changes",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.ADDRESS)
+    )
+
     /** Handle for `const char* msstore_winrt_get_last_error()`. */
     private val getLastErrorHandle: MethodHandle = downcall(
         symbolName = "msstore_winrt_get_last_error",
@@ -58,6 +129,201 @@ internal object MsStoreNative {
         descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS)
     )
 
+    /** Handle for `int msstore_winrt_prepare_purchase(void*, const char*)`. */
+    private val preparePurchaseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_PREPARED_PURCHASE,
+        symbolName = "msstore_winrt_prepare_purchase",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `void msstore_winrt_set_purchase_short_circuit(int64_t)`. */
+    private val setPurchaseShortCircuitHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_PURCHASE_SHORT_CIRCUIT,
+        symbolName = "msstore_winrt_set_purchase_short_circuit",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `int msstore_winrt_start_update_checker(int64_t)`. */
+    private val startUpdateCheckerHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_UPDATE_CHECKER,
+        symbolName = "msstore_winrt_start_update_checker",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `void msstore_winrt_stop_update_checker()`. */
+    private val stopUpdateCheckerHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_UPDATE_CHECKER,
+        symbolName = "msstore_winrt_stop_update_checker",
+        descriptor = FunctionDescriptor.ofVoid()
+    )
+
+    /** Handle for `void msstore_winrt_get_pending_updates(MsStorePendingUpdatesNative*)`. */
+    private val getPendingUpdatesHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_UPDATE_CHECKER,
+        symbolName = "msstore_winrt_get_pending_updates",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `int msstore_winrt_start_update_install()`. */
+    private val startUpdateInstallHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_EVENTS,
+        symbolName = "msstore_winrt_start_update_install",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT)
+    )
+
+    /** Handle for `int msstore_winrt_wait_update_progress(MsStoreUpdateProgressNative*, int, int)`. */
+    private val waitUpdateProgressHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_EVENTS,
+        symbolName = "msstore_winrt_wait_update_progress",
+        descriptor = FunctionDescriptor.of(
+            ValueLayout.JAVA_INT,
+            ValueLayout.ADDRESS,
+            ValueLayout.JAVA_INT,
+            ValueLayout.JAVA_INT
+        )
+    )
+
+    /** Handle for `void msstore_winrt_set_keep_extended_json(bool)`. */
+    private val setKeepExtendedJsonHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_EXTENDED_JSON,
+        symbolName = "msstore_winrt_set_keep_extended_json",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.JAVA_BOOLEAN)
+    )
+
+    /** Handle for `const char* msstore_winrt_get_json_field(const char*)`. */
+    private val getJsonFieldHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_EXTENDED_JSON,
+        symbolName = "msstore_winrt_get_json_field",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `const char* msstore_winrt_get_addon_json_field(const char*, const char*)`. */
+    private val getAddOnJsonFieldHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_EXTENDED_JSON,
+        symbolName = "msstore_winrt_get_addon_json_field",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.ADDRESS, ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `int msstore_winrt_broker_open(const char*, bool)`. */
+    private val brokerOpenHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_BROKER,
+        symbolName = "msstore_winrt_broker_open",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.JAVA_BOOLEAN)
+    )
+
+    /** Handle for `void msstore_winrt_broker_close()`. */
+    private val brokerCloseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_BROKER,
+        symbolName = "msstore_winrt_broker_close",
+        descriptor = FunctionDescriptor.ofVoid()
+    )
+
+    /** Handle for `MsStoreLicenseV2Native* msstore_winrt_broker_read_license(int64_t)`. */
+    private val brokerReadLicenseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_BROKER,
+        symbolName = "msstore_winrt_broker_read_license",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `MsStoreLicenseV2Native* msstore_winrt_get_user_license(const char*, int64_t)`. */
+    private val getUserLicenseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_USERS,
+        symbolName = "msstore_winrt_get_user_license",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.ADDRESS, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `MsStoreLicenseChangesNative* msstore_winrt_get_user_license_changes(const char*, int64_t)`. */
+    private val getUserLicenseChangesHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_USERS,
+        symbolName = "msstore_winrt_get_user_license_changes",
+        descriptor = FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.ADDRESS, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `int msstore_winrt_request_user_purchase(const char*, const char*)`. */
+    private val requestUserPurchaseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_USERS,
+        symbolName = "msstore_winrt_request_user_purchase",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `void msstore_winrt_forget_user(const char*)`. */
+    private val forgetUserHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_USERS,
+        symbolName = "msstore_winrt_forget_user",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.ADDRESS)
+    )
+
+    /** Handle for `int64_t msstore_winrt_dump_state(char*, int64_t)`. */
+    private val dumpStateHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_DIAGNOSTICS,
+        symbolName = "msstore_winrt_dump_state",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_LONG, ValueLayout.ADDRESS, ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `int64_t msstore_winrt_export_license(uint8_t*, int64_t, int64_t)`. */
+    private val exportLicenseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_PACKED_BLOB,
+        symbolName = "msstore_winrt_export_license",
+        descriptor = FunctionDescriptor.of(
+            ValueLayout.JAVA_LONG,
+            ValueLayout.ADDRESS,
+            ValueLayout.JAVA_LONG,
+            ValueLayout.JAVA_LONG
+        )
+    )
+
+    /** Handle for `void msstore_winrt_set_slow_call_threshold(int64_t)`. */
+    private val setSlowCallThresholdHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_SLOW_CALLS,
+        symbolName = "msstore_winrt_set_slow_call_threshold",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `void msstore_winrt_commit_slow_call(int64_t)`. */
+    private val commitSlowCallHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_SLOW_CALLS,
+        symbolName = "msstore_winrt_commit_slow_call",
+        descriptor = FunctionDescriptor.ofVoid(ValueLayout.JAVA_LONG)
+    )
+
+    /** Handle for `int msstore_winrt_read_slow_calls(int64_t, MsStoreSlowCallNative*, int)`. */
+    private val readSlowCallsHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_SLOW_CALLS,
+        symbolName = "msstore_winrt_read_slow_calls",
+        descriptor = FunctionDescriptor.of(
+            ValueLayout.JAVA_INT,
+            ValueLayout.JAVA_LONG,
+            ValueLayout.ADDRESS,
+            ValueLayout.JAVA_INT
+        )
+    )
+
+    /** Handle for `int msstore_winrt_purchase_log_open(const char*, int)`. */
+    private val purchaseLogOpenHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_PURCHASE_LOG,
+        symbolName = "msstore_winrt_purchase_log_open",
+        descriptor = FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.JAVA_INT)
+    )
+
+    /** Handle for `void msstore_winrt_purchase_log_close()`. */
+    private val purchaseLogCloseHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_PURCHASE_LOG,
+        symbolName = "msstore_winrt_purchase_log_close",
+        descriptor = FunctionDescriptor.ofVoid()
+    )
+
+    /** Handle for `int msstore_winrt_purchase_log_read(int64_t, MsStorePurchaseAttemptNative*, int)`. */
+    private val purchaseLogReadHandle: OptionalHandle = optionalDowncall(
+        capability = MsStoreAbi.CAP_PURCHASE_LOG,
+        symbolName = "msstore_winrt_purchase_log_read",
+        descriptor = FunctionDescriptor.of(
+            ValueLayout.JAVA_INT,
+            ValueLayout.JAVA_LONG,
+            ValueLayout.ADDRESS,
+            ValueLayout.JAVA_INT
+        )
+    )
+
     /** Handle for `void msstore_winrt_free(const char*)`. */
     private val freeHandle: MethodHandle = downcall(
         symbolName = "msstore_winrt_free",
@@ -65,13 +331,64 @@ internal object MsStoreNative {
     )
 
     /**
-     * Calls into msstore_winrt_get_license.
+     * Calls into msstore_winrt_get_license_v2, or msstore_winrt_get_license
+     * if the DLL predates it ([MsStoreAbi.hasLicenseV2]).
      *
-     * Returns a pointer to MsStoreLicenseNative on success.
+     * Returns a pointer to MsStoreLicenseV2Native, or MsStoreLicenseNative
+     * from an older DLL, on success.
      * The caller must free it by calling [freeLicense].
      */
     fun getLicense(): MemorySegment? =
-        nullIfNullAddress(getLicenseHandle.invoke() as MemorySegment)
+        nullIfNullAddress(
+            (if (abi.hasLicenseV2) getLicenseV2Handle.get().invoke() else getLicenseHandle.invoke()) as MemorySegment
+        )
+
+    /**
+     * Calls into msstore_winrt_get_cached_license.
+     *
+     * Returns a pointer to MsStoreLicenseV2Native on success.
+     * The caller must free it by calling [freeLicense].
+     */
+    fun getCachedLicense(maxAgeMillis: Long): MemorySegment? =
+        nullIfNullAddress(getCachedLicenseHandle.get().invoke(maxAgeMillis) as MemorySegment)
+
+    /**
+     * Calls into msstore_winrt_get_license_direct.
+     *
+     * Returns a pointer to MsStoreLicenseV2Native on success.
+     * The caller must free it by calling [freeLicense].
+     */
+    fun getLicenseDirect(): MemorySegment? =
+        nullIfNullAddress(getLicenseDirectHandle.get().invoke() as MemorySegment)
+
+    /**
+     * Calls into msstore_winrt_start_license_refresher.
+     *
+     * Returns 0 on success, -1 on failure.
+     */
+    fun startLicenseRefresher(
+        intervalMillis: Long,
+        minIntervalMillis: Long,
+        maxIntervalMillis: Long,
+        jitterSeed: Long
+    ): Int =
+        startLicenseRefresherHandle.get().invoke(intervalMillis, minIntervalMillis, maxIntervalMillis, jitterSeed) as Int
+
+    /**
+     * Calls into msstore_winrt_stop_license_refresher.
+     */
+    fun stopLicenseRefresher() {
+        stopLicenseRefresherHandle.get().invoke()
+    }
+
+    /**
+     * Calls into msstore_winrt_get_license_changes.
+     *
+     * Returns a pointer to MsStoreLicenseChangesNative on success.
+     * The caller must free it by calling [freeLicenseChanges].
+     */
+    fun getLicenseChanges(sinceGeneration: Long): MemorySegment? =
+        nullIfNullAddress(getLicenseChangesHandle.get().invoke(sinceGeneration) as MemorySegment)
 
     /**
      * Calls into msstore_winrt_get_last_error.
@@ -96,14 +413,210 @@ internal object MsStoreNative {
         }
 
     /**
-     * Frees a pointer returned by msstore_winrt_get_license.
+     * Calls into msstore_winrt_prepare_purchase.
+     *
+     * Returns 0 on success or -1 on failure.
+     */
+    fun preparePurchase(windowHandle: Long, storeId: String?): Int =
+        Arena.ofConfined().use { arena ->
+
+            val nativeStoreId = if (storeId != null) arena.allocateUtf8String(storeId) else MemorySegment.NULL
+
+            preparePurchaseHandle.get().invoke(MemorySegment.ofAddress(windowHandle), nativeStoreId) as Int
+        }
+
+    /**
+     * Calls into msstore_winrt_set_purchase_short_circuit.
+     */
+    fun setPurchaseShortCircuit(maxAgeMillis: Long) {
+        setPurchaseShortCircuitHandle.get().invoke(maxAgeMillis)
+    }
+
+    /**
+     * Calls into msstore_winrt_start_update_checker.
+     *
+     * Returns 0 on success or -1 on failure.
+     */
+    fun startUpdateChecker(intervalMillis: Long): Int =
+        startUpdateCheckerHandle.get().invoke(intervalMillis) as Int
+
+    /**
+     * Calls into msstore_winrt_stop_update_checker.
+     */
+    fun stopUpdateChecker() {
+        stopUpdateCheckerHandle.get().invoke()
+    }
+
+    /**
+     * Calls into msstore_winrt_get_pending_updates.
+     *
+     * Fills the caller-allocated MsStorePendingUpdatesNative struct. This never
+     * blocks on a Store query.
+     */
+    fun getPendingUpdates(result: MemorySegment) {
+        getPendingUpdatesHandle.get().invoke(result)
+    }
+
+    /**
+     * Calls into msstore_winrt_start_update_install.
+     *
+     * Returns 0 on success or -1 on failure.
+     */
+    fun startUpdateInstall(): Int =
+        startUpdateInstallHandle.get().invoke() as Int
+
+    /**
+     * Calls into msstore_winrt_wait_update_progress.
+     *
+     * Blocks for up to [timeoutMillis] if no progress is buffered and returns
+     * the number of MsStoreUpdateProgressNative records written to [buffer],
+     * or -1 on failure.
+     */
+    fun waitUpdateProgress(buffer: MemorySegment, capacity: Int, timeoutMillis: Int): Int =
+        waitUpdateProgressHandle.get().invoke(buffer, capacity, timeoutMillis) as Int
+
+    /**
+     * Calls into msstore_winrt_set_keep_extended_json.
+     */
+    fun setKeepExtendedJson(keep: Boolean) {
+        setKeepExtendedJsonHandle.get().invoke(keep)
+    }
+
+    /**
+     * Calls into msstore_winrt_get_json_field.
+     *
+     * Returns a pointer to the UTF-8 JSON value or null if the field is missing
+     * or the call failed. The caller must free it by calling [free].
+     */
+    fun getJsonField(path: String): MemorySegment? =
+        Arena.ofConfined().use { arena ->
+
+            val nativePath = arena.allocateUtf8String(path)
+
+            nullIfNullAddress(getJsonFieldHandle.get().invoke(nativePath) as MemorySegment)
+        }
+
+    /**
+     * Calls into msstore_winrt_get_addon_json_field.
+     *
+     * Returns a pointer to the UTF-8 JSON value or null if the field is missing
+     * or the call failed. The caller must free it by calling [free].
+     */
+    fun getAddOnJsonField(storeId: String, path: String): MemorySegment? =
+        Arena.ofConfined().use { arena ->
+
+            val nativeStoreId = arena.allocateUtf8String(storeId)
+            val nativePath = arena.allocateUtf8String(path)
+
+            nullIfNullAddress(getAddOnJsonFieldHandle.get().invoke(nativeStoreId, nativePath) as MemorySegment)
+        }
+
+    /**
+     * Calls into msstore_winrt_broker_open.
+     *
+     * Returns 0 on success or -1 on failure.
+     */
+    fun brokerOpen(name: String, owner: Boolean): Int =
+        Arena.ofConfined().use { arena ->
+
+            val nativeName = arena.allocateUtf8String(name)
+
+            brokerOpenHandle.get().invoke(nativeName, owner) as Int
+        }
+
+    /**
+     * Calls into msstore_winrt_broker_close.
+     */
+    fun brokerClose() {
+        brokerCloseHandle.get().invoke()
+    }
+
+    /**
+     * Calls into msstore_winrt_broker_read_license.
+     *
+     * Returns a pointer to MsStoreLicenseV2Native on success.
+     * The caller must free it by calling [freeLicense].
+     */
+    fun brokerReadLicense(maxAgeMillis: Long): MemorySegment? =
+        nullIfNullAddress(brokerReadLicenseHandle.get().invoke(maxAgeMillis) as MemorySegment)
+
+    /**
+     * Calls into msstore_winrt_get_user_license.
+     *
+     * Returns a pointer to MsStoreLicenseV2Native on success.
+     * The caller must free it by calling [freeLicense].
+     */
+    fun getUserLicense(userId: String, maxAgeMillis: Long): MemorySegment? =
+        Arena.ofConfined().use { arena ->
+
+            val nativeUserId = arena.allocateUtf8String(userId)
+
+            nullIfNullAddress(getUserLicenseHandle.get().invoke(nativeUserId, maxAgeMillis) as MemorySegment)
+        }
+
+    /**
+     * Calls into msstore_winrt_get_user_license_changes.
+     *
+     * Returns a pointer to MsStoreLicenseChangesNative on success.
+     * The caller must free it by calling [freeLicenseChanges].
+     */
+    fun getUserLicenseChanges(userId: String, sinceGeneration: Long): MemorySegment? =
+        Arena.ofConfined().use { arena ->
+
+            val nativeUserId = arena.allocateUtf8String(userId)
+
+            nullIfNullAddress(getUserLicenseChangesHandle.get().invoke(nativeUserId, sinceGeneration) as MemorySegment)
+        }
+
+    /**
+     * Calls into msstore_winrt_request_user_purchase.
+     *
+     * Returns a status code (see [de.stefan_oltmann.msstore.model.MsStorePurchaseStatus]) or -1 on failure.
+     */
+    fun requestUserPurchase(userId: String, storeId: String): Int =
+        Arena.ofConfined().use { arena ->
+
+            val nativeUserId = arena.allocateUtf8String(userId)
+            val nativeStoreId = arena.allocateUtf8String(storeId)
+
+            requestUserPurchaseHandle.get().invoke(nativeUserId, nativeStoreId) as Int
+        }
+
+    /**
+     * Calls into msstore_winrt_forget_user.
+     */
+    fun forgetUser(userId: String) {
+        Arena.ofConfined().use { arena ->
+            forgetUserHandle.get().invoke(arena.allocateUtf8String(userId))
+        }
+    }
+
+    /**
+     * Frees a pointer returned by [getLicense] or any other license call.
+     *
+     * All of them return MsStoreLicenseV2Native if the DLL has it, so the
+     * matching free function follows from [MsStoreAbi.hasLicenseV2] as well.
      */
     fun freeLicense(nativeMemorySegment: MemorySegment?) {
 
         if (nativeMemorySegment == null)
             return
 
-        freeLicenseHandle.invoke(nativeMemorySegment)
+        if (abi.hasLicenseV2)
+            freeLicenseV2Handle.get().invoke(nativeMemorySegment)
+        else
+            freeLicenseHandle.invoke(nativeMemorySegment)
+    }
+
+    /**
+     * Frees a pointer returned by msstore_winrt_get_license_changes.
+     */
+    fun freeLicenseChanges(nativeMemorySegment: MemorySegment?) {
+
+        if (nativeMemorySegment == null)
+            return
+
+        freeLicenseChangesHandle.get().invoke(nativeMemorySegment)
     }
 
     /**
@@ -121,13 +634,136 @@ internal object MsStoreNative {
         freeHandle.invoke(nativeMemorySegment)
     }
 
-    /** Resolves one native symbol and creates a strongly-typed downcall handle. */
-    private fun downcall(symbolName: String, descriptor: FunctionDescriptor): MethodHandle {
+    /**
+     * Calls into msstore_winrt_dump_state.
+     *
+     * Returns the document length; the document is only written if [size] is
+     * larger. Returns -1 on error.
+     */
+    fun dumpState(buffer: MemorySegment, size: Long): Long =
+        dumpStateHandle.get().invoke(buffer, size) as Long
 
-        val symbol = MsStoreNativeLoader.lookup.find(symbolName).orElseThrow {
-            UnsatisfiedLinkError("Native symbol '$symbolName' not found in msstore_winrt.dll.")
+    /**
+     * Calls into msstore_winrt_export_license.
+     *
+     * Returns the CBOR document length; the document is only written if
+     * [size] is at least that. Returns -1 on error.
+     */
+    fun exportLicense(buffer: MemorySegment, size: Long, maxAgeMillis: Long): Long =
+        exportLicenseHandle.get().invoke(buffer, size, maxAgeMillis) as Long
+
+    /**
+     * Calls into msstore_winrt_set_slow_call_threshold.
+     */
+    fun setSlowCallThreshold(thresholdMicros: Long) {
+        setSlowCallThresholdHandle.get().invoke(thresholdMicros)
+    }
+
+    /**
+     * Calls into msstore_winrt_commit_slow_call.
+     */
+    fun commitSlowCall(jvmDecodeMicros: Long) {
+        commitSlowCallHandle.get().invoke(jvmDecodeMicros)
+    }
+
+    /**
+     * Calls into msstore_winrt_read_slow_calls.
+     *
+     * Writes up to [capacity] records into [buffer] and returns their count.
+     */
+    fun readSlowCalls(sinceSequence: Long, buffer: MemorySegment, capacity: Int): Int =
+        readSlowCallsHandle.get().invoke(sinceSequence, buffer, capacity) as Int
+
+    /**
+     * Calls into msstore_winrt_purchase_log_open.
+     *
+     * Returns 0 on success or -1 on error.
+     */
+    fun purchaseLogOpen(path: String, capacity: Int): Int =
+        Arena.ofConfined().use { arena ->
+
+            val nativePath = arena.allocateUtf8String(path)
+
+            purchaseLogOpenHandle.get().invoke(nativePath, capacity) as Int
         }
 
+    /**
+     * Calls into msstore_winrt_purchase_log_close.
+     */
+    fun purchaseLogClose() {
+        purchaseLogCloseHandle.get().invoke()
+    }
+
+    /**
+     * Calls into msstore_winrt_purchase_log_read.
+     *
+     * Writes up to [capacity] records into [buffer] and returns their count,
+     * or -1 if no log is open.
+     */
+    fun purchaseLogRead(sinceSequence: Long, buffer: MemorySegment, capacity: Int): Int =
+        purchaseLogReadHandle.get().invoke(sinceSequence, buffer, capacity) as Int
+
+    /** Reads `msstore_winrt_get_abi_info()`, if the DLL has it. */
+    private fun readAbi(): MsStoreAbi {
+
+        val handle = findDowncall("msstore_winrt_get_abi_info", FunctionDescriptor.of(ValueLayout.ADDRESS))
+            ?: return MsStoreAbi.LEGACY
+
+        val pointer = handle.invoke() as MemorySegment
+
+        val structSize = pointer.reinterpret(MsStoreAbi.ABI_INFO_NATIVE_SIZE).get(ValueLayout.JAVA_INT, 4)
+
+        /* Fields are only ever appended; a smaller struct is not a version we know. */
+        if (structSize < MsStoreAbi.ABI_INFO_NATIVE_SIZE)
+            return MsStoreAbi.LEGACY
+
+        val info = pointer.reinterpret(structSize.toLong())
+
+        val structLayoutHashCount =
+            ((structSize - MsStoreAbi.ABI_INFO_NATIVE_SIZE) / 8).toInt().coerceAtMost(MsStoreAbi.STRUCT_LAYOUT_SLOTS)
+
+        return MsStoreAbi(
+            abiVersion = info.get(ValueLayout.JAVA_INT, 0),
+            layoutHash = info.get(ValueLayout.JAVA_LONG, 8),
+            capabilities = info.get(ValueLayout.JAVA_LONG, 16),
+            structLayoutHashes = LongArray(structLayoutHashCount) { index ->
+                info.get(ValueLayout.JAVA_LONG, MsStoreAbi.ABI_INFO_NATIVE_SIZE + index * 8L)
+            }
+        )
+    }
+
+    /** Downcall handle of a function the loaded DLL may not have. */
+    private class OptionalHandle(
+        private val symbolName: String,
+        private val handle: MethodHandle?
+    ) {
+
+        fun get(): MethodHandle =
+            handle ?: throw MsStoreLicenseException(
+                "The loaded msstore_winrt.dll does not support $symbolName ($abi). Update the DLL."
+            )
+    }
+
+    /** Binds a symbol only if the DLL reports [capability] and exports it. */
+    private fun optionalDowncall(capability: Long, symbolName: String, descriptor: FunctionDescriptor): OptionalHandle {
+
+        if (!abi.has(capability))
+            return OptionalHandle(symbolName, null)
+
+        return OptionalHandle(symbolName, findDowncall(symbolName, descriptor))
+    }
+
+    /** Resolves one native symbol and creates a strongly-typed downcall handle. */
+    private fun downcall(symbolName: String, descriptor: FunctionDescriptor): MethodHandle =
+        findDowncall(symbolName, descriptor)
+            ?: throw UnsatisfiedLinkError("Native symbol '$symbolName' not found in msstore_winrt.dll.")
+
+    /** Returns the downcall handle for a symbol, or null if the DLL lacks it. */
+    private fun findDowncall(symbolName: String, descriptor: FunctionDescriptor): MethodHandle? {
+
+        val symbol = MsStoreNativeLoader.lookup.find(symbolName).orElse(null)
+            ?: return null
+
         return linker.downcallHandle(symbol, descriptor)
     }
 
@@ -71,6 +71,25 @@ internal object MsStoreNativeHelpers {
         return readNullTerminatedUtf8(addressSegment)
     }
 
+    /**
+     * Reads a UTF-8 string from a fixed-size `char[]` field inside a struct.
+     *
+     * The string ends at the first null byte or at [maxBytes].
+     */
+    fun readFixedUtf8(struct: MemorySegment, offset: Long, maxBytes: Int): String {
+
+        var length = 0
+
+        while (length < maxBytes && struct.get(ValueLayout.JAVA_BYTE, offset + length).toInt() != 0)
+            length++
+
+        val bytes = ByteArray(length)
+
+        MemorySegment.copy(struct, ValueLayout.JAVA_BYTE, offset, bytes, 0, length)
+
+        return String(bytes, StandardCharsets.UTF_8)
+    }
+
     /**
      * Decodes a null-terminated UTF-8 C string from native memory.
      *
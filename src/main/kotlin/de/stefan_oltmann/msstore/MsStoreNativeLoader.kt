@@ -16,6 +16,8 @@
  */
 package de.stefan_oltmann.msstore
 
+import java.io.File
+import java.lang.foreign.Arena
 import java.lang.foreign.SymbolLookup
 import java.nio.file.Files
 import java.nio.file.Path
@@ -28,9 +30,16 @@ import java.nio.file.StandardCopyOption
  * 1. Explicit override path (`msstore.winrt.path`)
  * 2. DLL in the hosting app folder (`msstore_winrt.dll`)
  * 3. System library path (`msstore_winrt`)
- * 4. Embedded classpath resource extracted to a versioned cache folder
+ * 4. Embedded classpath resource extracted to a versioned cache folder,
+ *    under the temp directory or, if that is not usable, `%LOCALAPPDATA%`
  *
  * If you need to point at a specific DLL, set the system property `msstore.winrt.path` to a full file path.
+ *
+ * The DLL is bound with [SymbolLookup.libraryLookup] in the global arena, not
+ * with `System.load`, so it does not belong to any class loader. If the JAR is
+ * loaded by several class loaders, the first one resolves the DLL and records
+ * its location in [MsStoreNativeRegistry]; the others bind that same file,
+ * which Windows maps only once.
  */
 internal object MsStoreNativeLoader {
 
@@ -52,75 +61,133 @@ internal object MsStoreNativeLoader {
     /** Root folder under the temp directory where extracted natives are cached. */
     private const val CACHE_ROOT_DIR = "msstorelib-native"
 
-    /** FFM symbol lookup for the loaded native library. */
+    /** FFM symbol lookup for the loaded native library, the same DLL in all class loaders. */
     val lookup: SymbolLookup by lazy {
 
-        /*
-         * Load the native DLL once before any FFM symbol lookup.
-         * Symbol lookup depends on the library already being loaded.
-         */
-        loadNativeLibrary()
+        /* Another class loader resolved the DLL already. */
+        val sharedLocation = MsStoreNativeRegistry.sharedDllLocation()
+
+        if (sharedLocation != null)
+            return@lazy bind(sharedLocation)
 
-        SymbolLookup.loaderLookup()
+        val loaded = loadNativeLibrary()
+
+        val recordedLocation = MsStoreNativeRegistry.shareDllLocation(loaded.location)
+
+        /* Another class loader resolved it concurrently and was first to record it. */
+        if (recordedLocation != loaded.location)
+            return@lazy bind(recordedLocation)
+
+        loaded.lookup
     }
 
+    /** A loaded DLL and where it was loaded from: an absolute path, or a bare file name. */
+    private class LoadedLibrary(val location: String, val lookup: SymbolLookup)
+
     /**
      * Loads the native DLL using a strict fallback chain.
      *
      * Extraction from the classpath is only attempted as the final fallback.
      */
-    private fun loadNativeLibrary() {
+    private fun loadNativeLibrary(): LoadedLibrary {
 
         val overridePath = System.getProperty(PROP_WINRT_PATH)?.takeIf { it.isNotBlank() }
 
         /* 1) Explicit override always wins. */
-        if (overridePath != null) {
-            System.load(overridePath)
-            return
-        }
+        if (overridePath != null)
+            return load(overridePath)
 
         /* 2) Try DLL next to the host app. */
         val localPath = resolveAppLocalDllPath()
 
-        if (localPath != null) {
-            System.load(localPath)
-            return
-        }
+        if (localPath != null)
+            return load(localPath)
 
         /* 3) Try standard java.library.path lookup. */
-        val systemLoadError = tryLoadFromSystemLibraryPath() ?: return
+        val systemLoadError = try {
+            return loadFromSystemLibraryPath()
+        } catch (error: UnsatisfiedLinkError) {
+            error
+        }
 
         /*
          * 4) Final fallback: extract bundled DLL to a versioned cache path and
-         *    load from there.
+         *    load from there. A cache root that is read-only or blocked from
+         *    executing (e.g. by AppLocker) is skipped for the next one.
          */
-        val extractedPath = extractEmbeddedDllToVersionedCache()
-            ?: throw UnsatisfiedLinkError(
-                "Could not load '$LIB_NAME'. " +
-                    "Checked override path, local app folder, java.library.path, " +
-                    "and embedded resource '$EMBEDDED_RESOURCE'."
-            ).also { it.addSuppressed(systemLoadError) }
-
-        try {
-            System.load(extractedPath)
-        } catch (extractLoadError: UnsatisfiedLinkError) {
-            extractLoadError.addSuppressed(systemLoadError)
-            throw extractLoadError
+        val loadError = UnsatisfiedLinkError(
+            "Could not load '$LIB_NAME'. " +
+                "Checked override path, local app folder, java.library.path, " +
+                "and embedded resource '$EMBEDDED_RESOURCE'."
+        )
+
+        loadError.addSuppressed(systemLoadError)
+
+        for (cacheRoot in resolveCacheRoots()) {
+
+            val extractedPath = extractEmbeddedDllToVersionedCache(cacheRoot) ?: continue
+
+            try {
+                return load(extractedPath)
+            } catch (extractLoadError: UnsatisfiedLinkError) {
+                loadError.addSuppressed(extractLoadError)
+            }
         }
+
+        throw loadError
     }
 
     /**
-     * Attempts `System.loadLibrary(msstore_winrt)`.
-     *
-     * Returns null on success, otherwise the thrown load error.
+     * Loads the DLL at [path] into the global arena, so it stays loaded for
+     * the lifetime of the process.
      */
-    private fun tryLoadFromSystemLibraryPath(): UnsatisfiedLinkError? =
-        try {
-            System.loadLibrary(LIB_NAME)
-            null
-        } catch (error: UnsatisfiedLinkError) {
-            error
+    private fun load(path: String): LoadedLibrary {
+
+        val absolutePath = Path.of(path).toAbsolutePath()
+
+        return try {
+            LoadedLibrary(absolutePath.toString(), SymbolLookup.libraryLookup(absolutePath, Arena.global()))
+        } catch (ex: IllegalArgumentException) {
+            throw UnsatisfiedLinkError("Can't load library: $path").also { it.initCause(ex) }
+        }
+    }
+
+    /** Loads the DLL at a location recorded by [LoadedLibrary]. */
+    private fun bind(location: String): SymbolLookup {
+
+        if (Path.of(location).isAbsolute)
+            return load(location).lookup
+
+        return try {
+            SymbolLookup.libraryLookup(location, Arena.global())
+        } catch (ex: IllegalArgumentException) {
+            throw UnsatisfiedLinkError("Can't load library: $location").also { it.initCause(ex) }
         }
+    }
+
+    /**
+     * Loads `msstore_winrt.dll` from `java.library.path`, like
+     * `System.loadLibrary` would, and otherwise from the Windows DLL search path.
+     */
+    private fun loadFromSystemLibraryPath(): LoadedLibrary {
+
+        val fileName = System.mapLibraryName(LIB_NAME)
+
+        val libraryPath = System.getProperty("java.library.path")
+            ?.split(File.pathSeparator)
+            ?.filter { it.isNotBlank() }
+            ?.map { Path.of(it, fileName) }
+            ?.firstOrNull { Files.isRegularFile(it) }
+
+        if (libraryPath != null)
+            return load(libraryPath.toAbsolutePath().toString())
+
+        return try {
+            LoadedLibrary(fileName, SymbolLookup.libraryLookup(fileName, Arena.global()))
+        } catch (ex: IllegalArgumentException) {
+            throw UnsatisfiedLinkError("no $LIB_NAME in java.library.path").also { it.initCause(ex) }
+        }
+    }
 
     /**
      * Resolves app-local DLL path candidates and returns the first existing file.
@@ -189,17 +256,20 @@ internal object MsStoreNativeLoader {
      * returns its absolute path.
      *
      * Cache path format:
-     * `<tmp>/msstorelib-native/<LIB_VERSION>/windows-x86_64/msstore_winrt.dll`
+     * `<cache root>/msstorelib-native/<LIB_VERSION>/windows-x86_64/msstore_winrt.dll`
      *
      * If the file already exists for the same LIB_VERSION, it is reused and no
      * extraction is performed.
      *
+     * The DLL is written to a temporary file next to the target and moved into
+     * place, so a concurrently starting process never loads a half-written DLL.
+     *
      * Returns null when the resource is missing or extraction fails.
      */
-    private fun extractEmbeddedDllToVersionedCache(): String? =
+    private fun extractEmbeddedDllToVersionedCache(cacheRoot: Path): String? =
         runCatching {
 
-            val cacheDllPath = resolveVersionedCacheDllPath()
+            val cacheDllPath = resolveVersionedCacheDllPath(cacheRoot)
 
             /* Reuse an existing extracted binary for this library version. */
             if (Files.isRegularFile(cacheDllPath) && Files.size(cacheDllPath) > 0L)
@@ -209,10 +279,26 @@ internal object MsStoreNativeLoader {
                 .getResourceAsStream(EMBEDDED_RESOURCE)
                 ?: return@runCatching null
 
-            input.use { stream ->
-                /* Ensure versioned cache directories exist before copy. */
-                Files.createDirectories(cacheDllPath.parent)
-                Files.copy(stream, cacheDllPath, StandardCopyOption.REPLACE_EXISTING)
+            /* Ensure versioned cache directories exist before copy. */
+            Files.createDirectories(cacheDllPath.parent)
+
+            val partialPath = Files.createTempFile(cacheDllPath.parent, LIB_NAME, ".partial")
+
+            try {
+
+                input.use { stream ->
+                    Files.copy(stream, partialPath, StandardCopyOption.REPLACE_EXISTING)
+                }
+
+                Files.move(partialPath, cacheDllPath, StandardCopyOption.ATOMIC_MOVE)
+
+            } catch (ex: Exception) {
+
+                Files.deleteIfExists(partialPath)
+
+                /* Another process won the race; its DLL is just as good. */
+                if (!Files.isRegularFile(cacheDllPath) || Files.size(cacheDllPath) == 0L)
+                    throw ex
             }
 
             cacheDllPath.toAbsolutePath().toString()
@@ -220,24 +306,41 @@ internal object MsStoreNativeLoader {
         }.getOrNull()
 
     /**
-     * Computes the cache file path for the current library version.
+     * Returns the folders the embedded DLL may be extracted to, in order.
+     *
+     * `%LOCALAPPDATA%` is tried after the temp directory because locked-down
+     * hosts often redirect or block executables in the temp directory.
      */
-    private fun resolveVersionedCacheDllPath(): Path {
+    private fun resolveCacheRoots(): List<Path> {
 
-        val tempRoot = System.getProperty("java.io.tmpdir")
-            ?.takeIf { it.isNotBlank() }
-            ?: System.getProperty("user.home")
-            ?: "."
-
-        return Path.of(
-            tempRoot,
-            CACHE_ROOT_DIR,
-            getSanitizedLibVersion(),
-            PLATFORM_RESOURCE_DIR,
-            DLL_FILE_NAME
+        val candidates = sequenceOf(
+            System.getProperty("java.io.tmpdir"),
+            System.getenv("LOCALAPPDATA"),
+            System.getProperty("user.home")
         )
+
+        return candidates
+            .filterNotNull()
+            .filter { it.isNotBlank() }
+            .map { Path.of(it).toAbsolutePath() }
+            .distinct()
+            .toList()
+            .ifEmpty { listOf(Path.of(".").toAbsolutePath()) }
     }
 
+    /**
+     * Computes the cache file path for the current library version.
+     */
+    private fun resolveVersionedCacheDllPath(cacheRoot: Path): Path =
+        cacheRoot.resolve(
+            Path.of(
+                CACHE_ROOT_DIR,
+                getSanitizedLibVersion(),
+                PLATFORM_RESOURCE_DIR,
+                DLL_FILE_NAME
+            )
+        )
+
     /**
      * Normalizes values used as path segments.
      *
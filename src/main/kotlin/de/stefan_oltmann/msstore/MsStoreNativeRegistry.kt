@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+/**
+ * Process-wide registry shared by every copy of this library.
+ *
+ * Plugin hosts and app servers may load the JAR from several class loaders,
+ * each with its own [MsStoreNativeLoader] and [MsStoreNative]. The first copy
+ * resolves the DLL and records its location as a system property; the others
+ * bind the same file instead of running the resolution chain again, which
+ * might find another DLL.
+ *
+ * Only a String is stored, so the system properties stay storable and
+ * listable. The property is keyed per library version, so two different
+ * versions in one process never share a DLL.
+ */
+internal object MsStoreNativeRegistry {
+
+    /** System property holding the DLL location used by this library version. */
+    private val dllLocationProperty: String = "de.stefan_oltmann.msstore.dll.$LIB_VERSION"
+
+    /** Returns the DLL location recorded by another copy of this library, if any. */
+    fun sharedDllLocation(): String? =
+        System.getProperty(dllLocationProperty)
+
+    /**
+     * Records [location] unless another copy of this library was first.
+     * Returns the location that is recorded now.
+     */
+    fun shareDllLocation(location: String): String =
+        System.getProperties().putIfAbsent(dllLocationProperty, location) as String? ?: location
+}
@@ -32,7 +32,75 @@ internal object MsStorePurchase {
      *
      * @throws MsStoreLicenseException when the native call fails.
      */
-    fun requestPurchase(storeId: String): MsStorePurchaseStatus {
+    fun requestPurchase(storeId: String): MsStorePurchaseStatus =
+        request(storeId) { MsStoreNative.requestPurchase(storeId) }
+
+    /**
+     * Requests a purchase for the given Store product ID on behalf of the user [userId].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun requestUserPurchase(userId: String, storeId: String): MsStorePurchaseStatus =
+        request(storeId) { MsStoreNative.requestUserPurchase(userId, storeId) }
+
+    /**
+     * Prepares purchases for the owner window [windowHandle], optionally
+     * prefetching the product [storeId].
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun preparePurchase(windowHandle: Long, storeId: String?) {
+
+        try {
+
+            /* Prevent wrong use */
+            if (windowHandle == 0L)
+                throw MsStoreLicenseException("Window handle must not be 0.")
+
+            /* Prevent wrong use */
+            if (storeId != null && storeId.length != STORE_ID_LENGTH)
+                throw MsStoreLicenseException("Store ID must be 12 characters long.")
+
+            val result = MsStoreNative.preparePurchase(windowHandle, storeId)
+
+            if (result != 0)
+                throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Preparing purchase failed.")
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Preparing purchase failed.")
+        }
+    }
+
+    /**
+     * Enables answering purchase requests from a license snapshot at most
+     * [maxAgeMillis] old, or disables it for 0.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun setShortCircuit(maxAgeMillis: Long) {
+
+        try {
+
+            /* Prevent wrong use */
+            if (maxAgeMillis < 0)
+                throw MsStoreLicenseException("Purchase short-circuit max age must not be negative.")
+
+            MsStoreNative.setPurchaseShortCircuit(maxAgeMillis)
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Setting purchase short-circuit failed.")
+        }
+    }
+
+    private inline fun request(storeId: String, purchase: () -> Int): MsStorePurchaseStatus {
 
         try {
 
@@ -40,7 +108,7 @@ internal object MsStorePurchase {
             if (storeId.length != STORE_ID_LENGTH)
                 throw MsStoreLicenseException("Store ID must be 12 characters long.")
 
-            val statusCode = MsStoreNative.requestPurchase(storeId)
+            val statusCode = purchase()
 
             if (statusCode < 0)
                 throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Native purchase request failed.")
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStorePurchaseAttempt
+import de.stefan_oltmann.msstore.model.MsStorePurchaseStatus
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout
+import java.nio.file.Path
+
+/**
+ * Internal entry-point for the memory-mapped purchase attempt log.
+ *
+ * The native layer appends every purchase attempt to a fixed-size file it
+ * keeps mapped, so logging costs the purchase path a few memory writes and
+ * no I/O. This side opens and closes the log and reads records for export.
+ */
+internal object MsStorePurchaseLog {
+
+    private const val MSSTORE_PURCHASE_ATTEMPT_NATIVE_SIZE = 64L
+    private const val STORE_ID_MAX_BYTES = 24
+
+    /** Records read per native call. */
+    private const val READ_BATCH_CAPACITY = 1024
+
+    /**
+     * Opens (or creates) the log at [path] with room for [capacity] attempts.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun open(path: Path, capacity: Int) {
+
+        /* Prevent wrong use */
+        if (capacity <= 0)
+            throw MsStoreLicenseException("Purchase log capacity must be positive.")
+
+        try {
+
+            val result = MsStoreNative.purchaseLogOpen(path.toAbsolutePath().toString(), capacity)
+
+            if (result != 0)
+                throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Opening purchase log failed.")
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Opening purchase log failed.")
+        }
+    }
+
+    /**
+     * Flushes and closes the log.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun close() {
+
+        try {
+
+            MsStoreNative.purchaseLogClose()
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Closing purchase log failed.")
+        }
+    }
+
+    /**
+     * Returns up to [maxCount] attempts after [sinceSequence], oldest first.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun read(sinceSequence: Long, maxCount: Int): List<MsStorePurchaseAttempt> {
+
+        /* Prevent wrong use */
+        if (maxCount <= 0)
+            throw MsStoreLicenseException("Max count must be positive.")
+
+        try {
+
+            MsStoreNative.abi.requireStructLayout(MsStoreAbi.STRUCT_PURCHASE_ATTEMPT)
+
+            Arena.ofConfined().use { arena ->
+
+                val batchCapacity = minOf(maxCount, READ_BATCH_CAPACITY)
+
+                val buffer = arena.allocate(MSSTORE_PURCHASE_ATTEMPT_NATIVE_SIZE * batchCapacity)
+
+                val attempts = mutableListOf<MsStorePurchaseAttempt>()
+
+                var since = sinceSequence
+
+                while (attempts.size < maxCount) {
+
+                    val capacity = minOf(batchCapacity, maxCount - attempts.size)
+
+                    val count = MsStoreNative.purchaseLogRead(since, buffer, capacity)
+
+                    if (count < 0)
+                        throw MsStoreLicenseException(MsStoreNativeHelpers.readLastError() ?: "Reading purchase log failed.")
+
+                    for (index in 0 until count)
+                        attempts.add(readAttempt(buffer, index * MSSTORE_PURCHASE_ATTEMPT_NATIVE_SIZE))
+
+                    if (count < capacity)
+                        break
+
+                    since = attempts.last().sequence
+                }
+
+                return attempts
+            }
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Reading purchase log failed.")
+        }
+    }
+
+    private fun readAttempt(buffer: MemorySegment, offset: Long): MsStorePurchaseAttempt {
+
+        /*
+         * Layout must match the C struct MsStorePurchaseAttemptNative:
+         * 0: Sequence (LONG)
+         * 8: DialogOpenedAt (LONG)
+         * 16: DialogClosedAt (LONG)
+         * 24: Status (INT)
+         * 28: HResult (INT)
+         * 32: RetryCount (INT)
+         * 36: ShortCircuited (BYTE/BOOL)
+         * 37: ForUser (BYTE/BOOL)
+         * 38: StoreId (CHAR[24])
+         * (Padding to 64)
+         */
+        val statusCode = buffer.get(ValueLayout.JAVA_INT, offset + 24)
+
+        return MsStorePurchaseAttempt(
+            sequence = buffer.get(ValueLayout.JAVA_LONG, offset + 0),
+            storeId = MsStoreNativeHelpers.readFixedUtf8(buffer, offset + 38, STORE_ID_MAX_BYTES),
+            dialogOpenedAt = buffer.get(ValueLayout.JAVA_LONG, offset + 8),
+            dialogClosedAt = buffer.get(ValueLayout.JAVA_LONG, offset + 16),
+            status = if (statusCode < 0) null else MsStorePurchaseStatus.fromNativeCode(statusCode),
+            hresult = buffer.get(ValueLayout.JAVA_INT, offset + 28),
+            retryCount = buffer.get(ValueLayout.JAVA_INT, offset + 32),
+            shortCircuited = buffer.get(ValueLayout.JAVA_BOOLEAN, offset + 36),
+            forUser = buffer.get(ValueLayout.JAVA_BOOLEAN, offset + 37)
+        )
+    }
+}
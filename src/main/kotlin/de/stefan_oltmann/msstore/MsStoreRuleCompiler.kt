@@ -0,0 +1,243 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo.Companion.STORE_ID_LENGTH
+
+/**
+ * Compiles entitlement rules into flat postfix programs.
+ *
+ * Grammar (keywords are case-insensitive):
+ *
+ * ```
+ * rule    := or
+ * or      := and ("OR" and)*
+ * and     := unary ("AND" unary)*
+ * unary   := "NOT" unary | primary
+ * primary := "(" or ")" | "LICENSED" | "TRIAL" | "ACTIVE" | "ADDON" "(" storeId ")"
+ * ```
+ *
+ * Programs reference facts by index. The facts 0 to 2 are fixed (see the
+ * constants); every distinct add-on Store ID gets the next free index,
+ * shared across all rules compiled by the same instance.
+ */
+internal class MsStoreRuleCompiler {
+
+    /** Fact index of every add-on Store ID (upper case), starting at [FIRST_ADDON_FACT]. */
+    val addOnFacts: MutableMap<String, Int> = mutableMapOf()
+
+    private lateinit var rule: String
+    private var tokens: List<String> = emptyList()
+    private var position = 0
+    private val code = mutableListOf<Int>()
+    private var depth = 0
+    private var maxDepth = 0
+
+    /**
+     * Compiles one rule.
+     *
+     * @throws MsStoreLicenseException on syntax errors.
+     */
+    fun compile(rule: String): MsStoreRuleProgram {
+
+        this.rule = rule
+        tokens = tokenize(rule)
+        position = 0
+        code.clear()
+        depth = 0
+        maxDepth = 0
+
+        if (tokens.isEmpty())
+            fail("Rule is empty")
+
+        parseOr()
+
+        if (position < tokens.size)
+            fail("Unexpected '${tokens[position]}'")
+
+        return MsStoreRuleProgram(code.toIntArray(), maxDepth)
+    }
+
+    private fun parseOr() {
+
+        parseAnd()
+
+        while (acceptKeyword("OR")) {
+            parseAnd()
+            emitOperator(OP_OR)
+        }
+    }
+
+    private fun parseAnd() {
+
+        parseUnary()
+
+        while (acceptKeyword("AND")) {
+            parseUnary()
+            emitOperator(OP_AND)
+        }
+    }
+
+    private fun parseUnary() {
+
+        if (acceptKeyword("NOT")) {
+            parseUnary()
+            code.add(OP_NOT)
+            return
+        }
+
+        parsePrimary()
+    }
+
+    private fun parsePrimary() {
+
+        val token = next() ?: fail("Unexpected end of rule")
+
+        when (token.uppercase()) {
+
+            "(" -> {
+                parseOr()
+                expect(")")
+            }
+
+            "LICENSED" -> emitFact(FACT_LICENSED)
+            "TRIAL" -> emitFact(FACT_TRIAL)
+            "ACTIVE" -> emitFact(FACT_ACTIVE)
+
+            "ADDON" -> {
+
+                expect("(")
+
+                val storeId = next() ?: fail("Missing add-on Store ID")
+
+                if (storeId.length != STORE_ID_LENGTH)
+                    fail("Add-on Store ID '$storeId' must be 12 characters long")
+
+                expect(")")
+
+                emitFact(addOnFact(storeId.uppercase()))
+            }
+
+            else -> fail("Unexpected '$token'")
+        }
+    }
+
+    private fun addOnFact(storeId: String): Int =
+        addOnFacts.getOrPut(storeId) { FIRST_ADDON_FACT + addOnFacts.size }
+
+    private fun emitFact(fact: Int) {
+
+        code.add(fact)
+
+        depth++
+
+        if (depth > maxDepth)
+            maxDepth = depth
+    }
+
+    /** Binary operators pop two values and push one. */
+    private fun emitOperator(operator: Int) {
+        code.add(operator)
+        depth--
+    }
+
+    private fun acceptKeyword(keyword: String): Boolean {
+
+        if (position < tokens.size && tokens[position].equals(keyword, ignoreCase = true)) {
+            position++
+            return true
+        }
+
+        return false
+    }
+
+    private fun expect(token: String) {
+
+        if (next() != token)
+            fail("Expected '$token'")
+    }
+
+    private fun next(): String? =
+        if (position < tokens.size) tokens[position++] else null
+
+    private fun fail(message: String): Nothing =
+        throw MsStoreLicenseException("$message in rule \"$rule\".")
+
+    private fun tokenize(rule: String): List<String> {
+
+        val result = mutableListOf<String>()
+        var index = 0
+
+        while (index < rule.length) {
+
+            val char = rule[index]
+
+            when {
+
+                char.isWhitespace() -> index++
+
+                char == '(' || char == ')' -> {
+                    result.add(char.toString())
+                    index++
+                }
+
+                char.isLetterOrDigit() -> {
+
+                    val start = index
+
+                    while (index < rule.length && rule[index].isLetterOrDigit())
+                        index++
+
+                    result.add(rule.substring(start, index))
+                }
+
+                else -> fail("Unexpected character '$char'")
+            }
+        }
+
+        return result
+    }
+
+    internal companion object {
+
+        /** Full, non-trial, active and unexpired app license. */
+        const val FACT_LICENSED = 0
+
+        /** Active and unexpired trial license. */
+        const val FACT_TRIAL = 1
+
+        /** Active and unexpired app license of any kind. */
+        const val FACT_ACTIVE = 2
+
+        const val FIRST_ADDON_FACT = 3
+
+        /* Operators are negative so that any non-negative code is a fact index. */
+        const val OP_AND = -1
+        const val OP_OR = -2
+        const val OP_NOT = -3
+    }
+}
+
+/**
+ * One compiled rule: a postfix program over fact indices and operators.
+ *
+ * [maxStack] is the deepest the evaluation stack gets.
+ */
+internal class MsStoreRuleProgram(
+    val code: IntArray,
+    val maxStack: Int
+)
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreShadowPath
+import de.stefan_oltmann.msstore.model.MsStoreShadowStats
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
+import java.lang.foreign.MemorySegment
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.ThreadLocalRandom
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Internal entry-point for shadow mode.
+ *
+ * A sampled share of [MsStore.getLicenseInfo] calls schedules a comparison
+ * in the background: a reference path runs first, then the alternative path,
+ * both decoded without sharing instances with earlier licenses, so a decoding
+ * difference can't hide behind a shared instance. The caller never waits for
+ * it. Only one sample runs at a time; samples due meanwhile are dropped and
+ * counted.
+ *
+ * The reference path must not read what the alternative path reads, or the
+ * comparison proves nothing:
+ * - [MsStoreShadowPath.CachedSnapshot] is compared with the license marshalled
+ *   straight from the Store (msstore_winrt_get_license_direct), the path
+ *   without snapshots.
+ * - [MsStoreShadowPath.Broker] is compared with this process' own snapshot
+ *   (msstore_winrt_get_license_v2).
+ */
+internal object MsStoreShadow {
+
+    /** Counters of one configuration; replaced as a whole, so late samples can't leak into new ones. */
+    private class Counters {
+        val samples = AtomicLong()
+        val skipped = AtomicLong()
+        val matches = AtomicLong()
+        val mismatches = AtomicLong()
+        val legacyFailures = AtomicLong()
+        val alternativeFailures = AtomicLong()
+        val mismatchedFields = ConcurrentHashMap<String, AtomicLong>()
+        val legacyMicros = AtomicLong()
+        val alternativeMicros = AtomicLong()
+        val maxDeltaMicros = AtomicLong(Long.MIN_VALUE)
+    }
+
+    /** Sample rate, path and counters, swapped together by [configure]. */
+    private class Config(
+        val sampleRate: Double,
+        val path: MsStoreShadowPath,
+        val counters: Counters
+    )
+
+    @Volatile
+    private var config = Config(0.0, MsStoreShadowPath.CachedSnapshot, Counters())
+
+    private val running = AtomicBoolean(false)
+
+    private val scope = CoroutineScope(SupervisorJob() + Dispatchers.IO)
+
+    /**
+     * Samples [sampleRate] of the license calls against [path]; 0 disables.
+     * Starts new counters; a sample still running keeps counting into the old ones.
+     *
+     * @throws MsStoreLicenseException on a sample rate outside of 0 to 1, or
+     *   if the DLL lacks the reference path of [path].
+     */
+    fun configure(sampleRate: Double, path: MsStoreShadowPath) {
+
+        /* Prevent wrong use */
+        if (sampleRate.isNaN() || sampleRate < 0.0 || sampleRate > 1.0)
+            throw MsStoreLicenseException("Shadow sample rate must be between 0 and 1.")
+
+        if (sampleRate > 0.0 && path == MsStoreShadowPath.CachedSnapshot &&
+            !MsStoreNative.abi.has(MsStoreAbi.CAP_DIRECT_LICENSE))
+            throw MsStoreLicenseException(
+                "The loaded msstore_winrt.dll can't compare the cached snapshot (${MsStoreNative.abi}). Update the DLL."
+            )
+
+        config = Config(sampleRate, path, Counters())
+    }
+
+    fun stats(): MsStoreShadowStats {
+
+        val counters = config.counters
+
+        val maxDelta = counters.maxDeltaMicros.get()
+
+        return MsStoreShadowStats(
+            samples = counters.samples.get(),
+            skipped = counters.skipped.get(),
+            matches = counters.matches.get(),
+            mismatches = counters.mismatches.get(),
+            legacyFailures = counters.legacyFailures.get(),
+            alternativeFailures = counters.alternativeFailures.get(),
+            mismatchedFields = counters.mismatchedFields.mapValues { it.value.get() },
+            legacyMicros = counters.legacyMicros.get(),
+            alternativeMicros = counters.alternativeMicros.get(),
+            maxDeltaMicros = if (maxDelta == Long.MIN_VALUE) 0 else maxDelta
+        )
+    }
+
+    /** Called after every license call; schedules a sample if this one is picked. */
+    fun onLicenseCall() {
+
+        val config = config
+
+        if (config.sampleRate <= 0.0 || ThreadLocalRandom.current().nextDouble() >= config.sampleRate)
+            return
+
+        if (!running.compareAndSet(false, true)) {
+            config.counters.skipped.incrementAndGet()
+            return
+        }
+
+        scope.launch {
+            try {
+                runSample(config.path, config.counters)
+            } finally {
+                running.set(false)
+            }
+        }
+    }
+
+    /**
+     * Returns the names of the fields that differ, empty if the licenses are equal.
+     *
+     * Add-ons are compared regardless of order: the Store's own order is not
+     * stable, the snapshots sort them. The generation is never compared, as
+     * every process and path counts its own. Fingerprints are only compared
+     * if both paths computed one.
+     */
+    fun mismatchedFields(legacy: MsStoreLicenseInfo, alternative: MsStoreLicenseInfo): List<String> =
+        buildList {
+            if (legacy.storeId != alternative.storeId) add("storeId")
+            if (legacy.skuId != alternative.skuId) add("skuId")
+            if (legacy.isActive != alternative.isActive) add("isActive")
+            if (legacy.isTrial != alternative.isTrial) add("isTrial")
+            if (legacy.expirationDate != alternative.expirationDate) add("expirationDate")
+            if (sortedAddOns(legacy) != sortedAddOns(alternative)) add("addOnLicenses")
+            if (legacy.fingerprint != 0L && alternative.fingerprint != 0L && legacy.fingerprint != alternative.fingerprint)
+                add("fingerprint")
+        }
+
+    private fun sortedAddOns(license: MsStoreLicenseInfo) =
+        license.addOnLicenses.sortedWith(compareBy({ it.storeId }, { it.skuId }))
+
+    private fun runSample(path: MsStoreShadowPath, counters: Counters) {
+
+        counters.samples.incrementAndGet()
+
+        val legacyStartNanos = System.nanoTime()
+
+        val legacy = try {
+            MsStoreLicense.readLicenseInfoUnshared { readReference(path) }
+        } catch (_: Throwable) {
+            counters.legacyFailures.incrementAndGet()
+            return
+        }
+
+        val alternativeStartNanos = System.nanoTime()
+
+        val alternative = try {
+            MsStoreLicense.readLicenseInfoUnshared { readAlternative(path) }
+        } catch (_: Throwable) {
+            counters.alternativeFailures.incrementAndGet()
+            return
+        }
+
+        val endNanos = System.nanoTime()
+
+        val legacyCallMicros = (alternativeStartNanos - legacyStartNanos) / 1000
+        val alternativeCallMicros = (endNanos - alternativeStartNanos) / 1000
+
+        counters.legacyMicros.addAndGet(legacyCallMicros)
+        counters.alternativeMicros.addAndGet(alternativeCallMicros)
+        counters.maxDeltaMicros.accumulateAndGet(alternativeCallMicros - legacyCallMicros) { current, delta ->
+            maxOf(current, delta)
+        }
+
+        val fields = mismatchedFields(legacy, alternative)
+
+        if (fields.isEmpty()) {
+            counters.matches.incrementAndGet()
+            return
+        }
+
+        counters.mismatches.incrementAndGet()
+
+        for (field in fields)
+            counters.mismatchedFields.computeIfAbsent(field) { AtomicLong() }.incrementAndGet()
+    }
+
+    private fun readReference(path: MsStoreShadowPath): MemorySegment? =
+        when (path) {
+
+            /* Straight from the Store, not through the snapshot the alternative reads. */
+            MsStoreShadowPath.CachedSnapshot -> MsStoreNative.getLicenseDirect()
+
+            /* This process' own snapshot, not the broker owner's. */
+            MsStoreShadowPath.Broker -> MsStoreNative.getLicense()
+        }
+
+    private fun readAlternative(path: MsStoreShadowPath): MemorySegment? =
+        when (path) {
+
+            /* The snapshot the triggering license call published. */
+            MsStoreShadowPath.CachedSnapshot -> MsStoreNative.getCachedLicense(Long.MAX_VALUE)
+
+            MsStoreShadowPath.Broker -> MsStoreBroker.readLicense()
+        }
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreCallOperation
+import de.stefan_oltmann.msstore.model.MsStoreSlowCall
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout
+
+/**
+ * Internal entry-point for slow-call forensics.
+ *
+ * The native layer times the phases of every license call while a threshold
+ * is set and keeps the calls exceeding it in a small ring. This side adds the
+ * time spent decoding the result, so calls that only became slow in the JVM
+ * are recorded as well.
+ */
+internal object MsStoreSlowCalls {
+
+    private const val MSSTORE_SLOW_CALL_NATIVE_SIZE = 208L
+    private const val ERROR_MAX_BYTES = 128
+
+    /** Records read per native call. Matches the native ring capacity. */
+    private const val READ_BATCH_CAPACITY = 64
+
+    /** Start value of calls that are not timed. */
+    private const val NOT_TIMED = Long.MIN_VALUE
+
+    /** Threshold in microseconds, 0 if disabled. */
+    @Volatile
+    private var thresholdMicros: Long = 0
+
+    /**
+     * Sets the threshold; 0 disables recording.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun setThreshold(thresholdMicros: Long) {
+
+        /* Prevent wrong use */
+        if (thresholdMicros < 0)
+            throw MsStoreLicenseException("Slow-call threshold must not be negative.")
+
+        try {
+
+            MsStoreNative.setSlowCallThreshold(thresholdMicros)
+
+            this.thresholdMicros = thresholdMicros
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Setting slow-call threshold failed.")
+        }
+    }
+
+    /** Returns the start time of a timed section, or a marker if recording is off. */
+    fun startTiming(): Long =
+        if (thresholdMicros > 0) System.nanoTime() else NOT_TIMED
+
+    /**
+     * Hands the JVM decode time of the last license call of this thread to
+     * the native layer, which records the call if it was slow.
+     *
+     * Called for every timed call, slow or not: the native layer keeps the
+     * calls of a thread pending only once that thread has committed.
+     */
+    fun commit(decodeStartNanos: Long) {
+
+        if (decodeStartNanos == NOT_TIMED)
+            return
+
+        MsStoreNative.commitSlowCall((System.nanoTime() - decodeStartNanos) / 1000)
+    }
+
+    /**
+     * Returns the recorded slow calls after [sinceSequence], oldest first.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun read(sinceSequence: Long): List<MsStoreSlowCall> {
+
+        try {
+
+            MsStoreNative.abi.requireStructLayout(MsStoreAbi.STRUCT_SLOW_CALL)
+
+            Arena.ofConfined().use { arena ->
+
+                val buffer = arena.allocate(MSSTORE_SLOW_CALL_NATIVE_SIZE * READ_BATCH_CAPACITY)
+
+                val calls = mutableListOf<MsStoreSlowCall>()
+
+                var since = sinceSequence
+
+                while (true) {
+
+                    val count = MsStoreNative.readSlowCalls(since, buffer, READ_BATCH_CAPACITY)
+
+                    for (index in 0 until count)
+                        calls.add(readSlowCall(buffer, index * MSSTORE_SLOW_CALL_NATIVE_SIZE))
+
+                    if (count < READ_BATCH_CAPACITY)
+                        return calls
+
+                    since = calls.last().sequence
+                }
+            }
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Reading slow calls failed.")
+        }
+    }
+
+    private fun readSlowCall(buffer: MemorySegment, offset: Long): MsStoreSlowCall {
+
+        /*
+         * Layout must match the C struct MsStoreSlowCallNative:
+         * 0: Sequence (LONG)
+         * 8: StartedAt (LONG)
+         * 16: TotalMicros (LONG)
+         * 24: QueueWaitMicros (LONG)
+         * 32: ApartmentMicros (LONG)
+         * 40: StoreMicros (LONG)
+         * 48: MarshalMicros (LONG)
+         * 56: JvmDecodeMicros (LONG)
+         * 64: Operation (INT)
+         * 68: AddOnCount (INT)
+         * 72: Failed (BYTE/BOOL)
+         * 73: Joined (BYTE/BOOL)
+         * 74: Error (CHAR[128])
+         * (Padding to 208)
+         */
+        val failed = buffer.get(ValueLayout.JAVA_BOOLEAN, offset + 72)
+
+        return MsStoreSlowCall(
+            sequence = buffer.get(ValueLayout.JAVA_LONG, offset + 0),
+            operation = MsStoreCallOperation.fromNativeCode(buffer.get(ValueLayout.JAVA_INT, offset + 64)),
+            startedAt = buffer.get(ValueLayout.JAVA_LONG, offset + 8),
+            totalMicros = buffer.get(ValueLayout.JAVA_LONG, offset + 16),
+            queueWaitMicros = buffer.get(ValueLayout.JAVA_LONG, offset + 24),
+            apartmentMicros = buffer.get(ValueLayout.JAVA_LONG, offset + 32),
+            storeMicros = buffer.get(ValueLayout.JAVA_LONG, offset + 40),
+            marshalMicros = buffer.get(ValueLayout.JAVA_LONG, offset + 48),
+            jvmDecodeMicros = buffer.get(ValueLayout.JAVA_LONG, offset + 56),
+            addOnCount = buffer.get(ValueLayout.JAVA_INT, offset + 68),
+            joined = buffer.get(ValueLayout.JAVA_BOOLEAN, offset + 73),
+            error = if (failed) MsStoreNativeHelpers.readFixedUtf8(buffer, offset + 74, ERROR_MAX_BYTES) else null
+        )
+    }
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStorePendingUpdates
+import de.stefan_oltmann.msstore.model.MsStoreUpdateProgress
+import de.stefan_oltmann.msstore.model.MsStoreUpdateState
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.flowOn
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout
+
+/**
+ * Internal entry-point for background package update checks.
+ *
+ * The native layer runs `StoreContext.GetAppAndOptionalStorePackageUpdatesAsync()`
+ * on its dispatcher thread at the configured cadence and caches the result.
+ * Reading the cache never blocks on a Store query.
+ *
+ * @see https://learn.microsoft.com/windows/uwp/packaging/self-install-package-updates
+ */
+internal object MsStoreUpdates {
+
+    private const val MSSTORE_PENDING_UPDATES_NATIVE_SIZE = 32L
+    private const val MSSTORE_UPDATE_PROGRESS_NATIVE_SIZE = 168L
+    private const val PACKAGE_FAMILY_NAME_MAX_BYTES = 128
+
+    /** Records drained per native call. Matches the native ring capacity. */
+    private const val PROGRESS_BATCH_CAPACITY = 256
+
+    /** How long one native wait blocks before cancellation is checked again. */
+    private const val PROGRESS_WAIT_TIMEOUT_MILLIS = 1000
+
+    /**
+     * Minimum time between two emitted batches.
+     *
+     * Progress arriving in between accumulates in the native ring and is
+     * coalesced, which bounds the rate of UI updates during large downloads.
+     */
+    private const val PROGRESS_MIN_INTERVAL_MILLIS = 100L
+
+    /**
+     * Starts (or restarts) the background update checker.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun startUpdateChecker(intervalMillis: Long) {
+
+        try {
+
+            /* Prevent wrong use */
+            if (intervalMillis <= 0)
+                throw MsStoreLicenseException("Update check interval must be positive.")
+
+            if (MsStoreNative.startUpdateChecker(intervalMillis) < 0)
+                throw MsStoreLicenseException(
+                    MsStoreNativeHelpers.readLastError() ?: "Native update checker start failed."
+                )
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Update checker start failed.")
+        }
+    }
+
+    /**
+     * Stops the background update checker.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun stopUpdateChecker() {
+
+        try {
+
+            MsStoreNative.stopUpdateChecker()
+
+        } catch (ex: Throwable) {
+            /* Wrap everything in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Update checker stop failed.")
+        }
+    }
+
+    /**
+     * Returns the cached result of the last update check.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    fun pendingUpdates(): MsStorePendingUpdates {
+
+        try {
+
+            MsStoreNative.abi.requireStructLayout(MsStoreAbi.STRUCT_PENDING_UPDATES)
+
+            return Arena.ofConfined().use { arena ->
+
+                val struct = arena.allocate(MSSTORE_PENDING_UPDATES_NATIVE_SIZE, 8)
+
+                MsStoreNative.getPendingUpdates(struct)
+
+                readPendingUpdates(struct)
+            }
+
+        } catch (ex: Throwable) {
+            /* Wrap everything in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Pending updates query failed.")
+        }
+    }
+
+    /**
+     * Starts downloading and installing all pending updates and streams progress.
+     *
+     * The installation is started when the flow is collected, from an IO
+     * thread that waits while the pending updates are queried. Each native
+     * batch is coalesced to the latest entry per package before emitting. The
+     * flow completes after the final entry.
+     *
+     * Cancelling the collection stops observing, but not the installation.
+     */
+    fun downloadAndInstallUpdates(): Flow<MsStoreUpdateProgress> = flow {
+
+        try {
+
+            MsStoreNative.abi.requireStructLayout(MsStoreAbi.STRUCT_UPDATE_PROGRESS)
+
+            if (MsStoreNative.startUpdateInstall() < 0)
+                throw MsStoreLicenseException(
+                    MsStoreNativeHelpers.readLastError() ?: "Native update installation start failed."
+                )
+
+        } catch (ex: MsStoreLicenseException) {
+            /* Pass on MsStoreLicenseException as is. */
+            throw ex
+        } catch (ex: Throwable) {
+            /* Wrap everything else in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Update installation start failed.")
+        }
+
+        /* Shared because the collector may resume on another IO thread. */
+        Arena.ofShared().use { arena ->
+
+            val buffer = arena.allocate(PROGRESS_BATCH_CAPACITY * MSSTORE_UPDATE_PROGRESS_NATIVE_SIZE, 8)
+
+            while (true) {
+
+                val batch = drainProgress(buffer)
+
+                for (progress in batch)
+                    emit(progress)
+
+                if (batch.lastOrNull()?.isFinal == true)
+                    return@use
+
+                delay(PROGRESS_MIN_INTERVAL_MILLIS)
+            }
+        }
+
+    }.flowOn(Dispatchers.IO)
+
+    /**
+     * Drains one batch from the native ring, keeping only the latest entry per
+     * package. The final entry, if present, is always last.
+     */
+    private fun drainProgress(buffer: MemorySegment): List<MsStoreUpdateProgress> {
+
+        val count = try {
+            MsStoreNative.waitUpdateProgress(buffer, PROGRESS_BATCH_CAPACITY, PROGRESS_WAIT_TIMEOUT_MILLIS)
+        } catch (ex: Throwable) {
+            throw MsStoreLicenseException(ex.message ?: "Update progress query failed.")
+        }
+
+        if (count < 0)
+            throw MsStoreLicenseException(
+                MsStoreNativeHelpers.readLastError() ?: "Native update progress query failed."
+            )
+
+        val latestByPackage = LinkedHashMap<String, MsStoreUpdateProgress>()
+        var finalProgress: MsStoreUpdateProgress? = null
+
+        for (index in 0 until count) {
+
+            val progress = readUpdateProgress(buffer, index * MSSTORE_UPDATE_PROGRESS_NATIVE_SIZE)
+
+            if (progress.isFinal)
+                finalProgress = progress
+            else
+                latestByPackage[progress.packageFamilyName] = progress
+        }
+
+        return if (finalProgress != null)
+            latestByPackage.values + finalProgress
+        else
+            latestByPackage.values.toList()
+    }
+
+    private fun readUpdateProgress(buffer: MemorySegment, offset: Long): MsStoreUpdateProgress {
+
+        /*
+         * Layout must match the C struct MsStoreUpdateProgressNative:
+         * 0: PackageBytesDownloaded (LONG)
+         * 8: PackageDownloadSizeInBytes (LONG)
+         * 16: PackageDownloadProgress (DOUBLE)
+         * 24: TotalDownloadProgress (DOUBLE)
+         * 32: State (INT)
+         * 36: IsFinal (BYTE/BOOL)
+         * 37: PackageFamilyName (CHAR[128])
+         * (Padding to 168)
+         */
+        return MsStoreUpdateProgress(
+            packageFamilyName = MsStoreNativeHelpers.readFixedUtf8(
+                buffer, offset + 37, PACKAGE_FAMILY_NAME_MAX_BYTES
+            ),
+            packageBytesDownloaded = buffer.get(ValueLayout.JAVA_LONG, offset + 0),
+            packageDownloadSizeInBytes = buffer.get(ValueLayout.JAVA_LONG, offset + 8),
+            packageDownloadProgress = buffer.get(ValueLayout.JAVA_DOUBLE, offset + 16),
+            totalDownloadProgress = buffer.get(ValueLayout.JAVA_DOUBLE, offset + 24),
+            state = MsStoreUpdateState.fromNativeCode(buffer.get(ValueLayout.JAVA_INT, offset + 32)),
+            isFinal = buffer.get(ValueLayout.JAVA_BOOLEAN, offset + 36)
+        )
+    }
+
+    private fun readPendingUpdates(struct: MemorySegment): MsStorePendingUpdates {
+
+        /*
+         * Layout must match the C struct MsStorePendingUpdatesNative:
+         * 0: Generation (LONG)
+         * 8: CheckedAt (LONG)
+         * 16: UpdateCount (INT)
+         * 20: MandatoryUpdateCount (INT)
+         * 24: LastCheckFailed (BYTE/BOOL)
+         * (Padding to 32)
+         */
+        return MsStorePendingUpdates(
+            generation = struct.get(ValueLayout.JAVA_LONG, 0),
+            checkedAt = struct.get(ValueLayout.JAVA_LONG, 8),
+            updateCount = struct.get(ValueLayout.JAVA_INT, 16),
+            mandatoryUpdateCount = struct.get(ValueLayout.JAVA_INT, 20),
+            lastCheckFailed = struct.get(ValueLayout.JAVA_BOOLEAN, 24)
+        )
+    }
+}
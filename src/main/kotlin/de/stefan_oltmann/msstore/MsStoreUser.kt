@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreLicenseChanges
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStorePurchaseStatus
+
+/**
+ * Store access on behalf of one signed-in Windows user, see [MsStore.forUser].
+ *
+ * The native layer keeps the `StoreContext` of the most recently used users
+ * together with their last license. Handles are cheap; creating another one
+ * for the same user shares that cache.
+ */
+public class MsStoreUser internal constructor(
+
+    /**
+     * `User.NonRoamableId` of the Windows user.
+     */
+    public val userId: String
+) {
+
+    /**
+     * Returns the app license info of this user.
+     *
+     * If the cached license of this user is at most [maxAgeMillis] old, it is
+     * returned without a Store query. The default of 0 always queries.
+     *
+     * @throws MsStoreLicenseException when the user is not signed in or the native call fails.
+     */
+    public fun getLicenseInfo(maxAgeMillis: Long = 0): MsStoreLicenseInfo =
+        MsStoreLicense.getUserLicenseInfo(userId, maxAgeMillis)
+
+    /**
+     * Queries the license of this user and returns the add-on changes since [generation].
+     *
+     * Generations are counted per user. See [MsStore.licenseChangesSince].
+     *
+     * @throws MsStoreLicenseException when the user is not signed in or the native call fails.
+     */
+    public fun licenseChangesSince(generation: Long): MsStoreLicenseChanges =
+        MsStoreLicense.userLicenseChangesSince(userId, generation)
+
+    /**
+     * Requests a purchase for the given Store product ID on behalf of this user.
+     *
+     * @throws MsStoreLicenseException when the user is not signed in or the native call fails.
+     */
+    public fun requestPurchase(storeId: String): MsStorePurchaseStatus =
+        MsStorePurchase.requestUserPurchase(userId, storeId)
+
+    /**
+     * Drops the cached `StoreContext` and license of this user, for example
+     * after the user signed out.
+     *
+     * @throws MsStoreLicenseException when the native call fails.
+     */
+    public fun forget() {
+
+        try {
+
+            MsStoreNative.forgetUser(userId)
+
+        } catch (ex: Throwable) {
+            /* Wrap everything in a MsStoreLicenseException */
+            throw MsStoreLicenseException(ex.message ?: "Forgetting user failed.")
+        }
+    }
+
+    override fun toString(): String =
+        "MsStoreUser(userId=$userId)"
+}
@@ -46,4 +46,30 @@ public data class MsStoreAddOnLicenseInfo(
      * Expiration date and time for the add-on license.
      */
     val expirationDate: Long = 0
-)
+
+) {
+
+    /** Used by the native decoders; the public constructor leaves it at 0. */
+    internal constructor(
+        storeId: String = "",
+        skuId: String = "",
+        inAppOfferToken: String = "",
+        expirationDate: Long = 0,
+        fingerprint: Long
+    ) : this(storeId, skuId, inAppOfferToken, expirationDate) {
+        this.fingerprint = fingerprint
+    }
+
+    /**
+     * Stable 64-bit hash over all fields of this add-on license.
+     *
+     * Equal fingerprints mean equal add-on licenses, so this can be used
+     * instead of comparing all fields. 0 if the DLL doesn't report it.
+     *
+     * Not a constructor property, so it is not part of [equals], [hashCode],
+     * [toString] or [copy]: it is derived from the fields that are. A copy
+     * has 0.
+     */
+    var fingerprint: Long = 0
+        internal set
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * License operation a slow-call record belongs to.
+ */
+public enum class MsStoreCallOperation {
+
+    GetLicense,
+    GetLicenseChanges,
+    GetUserLicense,
+    GetUserLicenseChanges,
+    BrokerReadLicense,
+    Unknown;
+
+    internal companion object {
+        fun fromNativeCode(code: Int): MsStoreCallOperation = when (code) {
+            1 -> GetLicense
+            2 -> GetLicenseChanges
+            3 -> GetUserLicense
+            4 -> GetUserLicenseChanges
+            5 -> BrokerReadLicense
+            else -> Unknown
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * Add-on license changes between a previous license generation and the current one.
+ *
+ * If nothing changed, [generation] equals the generation that was asked for
+ * and all lists are empty.
+ */
+public data class MsStoreLicenseChanges(
+
+    /**
+     * Generation of the current license snapshot.
+     */
+    val generation: Long = 0,
+
+    /**
+     * Fingerprint of the current license snapshot.
+     */
+    val fingerprint: Long = 0,
+
+    /**
+     * Store ID of the current app license.
+     */
+    val storeId: String = "",
+
+    /**
+     * SKU ID of the current app license.
+     */
+    val skuId: String = "",
+
+    /**
+     * Value that indicates whether the current app license is active.
+     */
+    val isActive: Boolean = false,
+
+    /**
+     * Value that indicates whether the current app license is a trial license.
+     */
+    val isTrial: Boolean = false,
+
+    /**
+     * Expiration date of the current app license as timestamp in milliseconds.
+     */
+    val expirationDate: Long = 0,
+
+    /**
+     * Value that indicates that the previous generation was unknown to the native layer.
+     *
+     * All current add-ons are listed in [added] in that case, and the caller
+     * should replace its state instead of applying the changes.
+     */
+    val isFullResync: Boolean = false,
+
+    /**
+     * Add-on licenses that are new in the current generation.
+     */
+    val added: List<MsStoreAddOnLicenseInfo> = emptyList(),
+
+    /**
+     * Add-on licenses that no longer exist, as they were in the previous generation.
+     */
+    val removed: List<MsStoreAddOnLicenseInfo> = emptyList(),
+
+    /**
+     * Add-on licenses that exist in both generations but differ, as they are now.
+     */
+    val changed: List<MsStoreAddOnLicenseInfo> = emptyList()
+
+) {
+
+    /**
+     * Convenience property to indicate that at least one add-on changed.
+     */
+    val hasAddOnChanges: Boolean =
+        isFullResync || added.isNotEmpty() || removed.isNotEmpty() || changed.isNotEmpty()
+}
@@ -17,6 +17,8 @@
 package de.stefan_oltmann.msstore.model
 
 import de.stefan_oltmann.msstore.MsStoreLicenseException
+import kotlin.time.Clock
+import kotlin.time.ExperimentalTime
 
 /**
  * Subset of Store app license fields returned by the native WinRT API.
@@ -25,6 +27,12 @@ import de.stefan_oltmann.msstore.MsStoreLicenseException
  * to keep parsing stable across schema revisions. Date values are returned as
  * Unix timestamps (milliseconds).
  *
+ * Refreshes share what did not change: an unchanged license is returned as
+ * the same instance, and unchanged add-ons (same [MsStoreAddOnLicenseInfo.fingerprint])
+ * as the instances of the previous result. So `license === previous` is a
+ * cheap proof that nothing changed; a different instance may still be equal,
+ * for example after reading the license of another user in between.
+ *
  * @see https://learn.microsoft.com/uwp/api/windows.services.store.storeapplicense
  */
 public data class MsStoreLicenseInfo(
@@ -67,11 +75,57 @@ public data class MsStoreLicenseInfo(
 
 ) {
 
+    /** Used by the native decoders; the public constructor leaves both at 0. */
+    internal constructor(
+        storeId: String = "",
+        skuId: String = "",
+        isActive: Boolean = false,
+        isTrial: Boolean = false,
+        expirationDate: Long = 0,
+        addOnLicenses: List<MsStoreAddOnLicenseInfo> = emptyList(),
+        fingerprint: Long,
+        generation: Long
+    ) : this(storeId, skuId, isActive, isTrial, expirationDate, addOnLicenses) {
+        this.fingerprint = fingerprint
+        this.generation = generation
+    }
+
+    /**
+     * Stable 64-bit hash over all license fields and add-on licenses.
+     *
+     * Equal fingerprints mean equal licenses, so a refresh can be checked for
+     * changes with a single compare. 0 if the DLL doesn't report it.
+     *
+     * Not a constructor property, so it is not part of [equals], [hashCode],
+     * [toString] or [copy]: it is derived from the fields that are. A copy
+     * has 0.
+     */
+    var fingerprint: Long = 0
+        internal set
+
+    /**
+     * Generation of this license snapshot in the native layer.
+     *
+     * Starts at 1 and only advances when the fingerprint changes. Pass it to
+     * [de.stefan_oltmann.msstore.MsStore.licenseChangesSince] to get the add-ons
+     * that changed since. 0 if the DLL doesn't report it.
+     *
+     * Not a constructor property, so it is not part of [equals], [hashCode],
+     * [toString] or [copy]: the same license read twice is equal even if the
+     * native layer counted generations differently in between. A copy has 0.
+     */
+    var generation: Long = 0
+        internal set
+
     /**
      * Convenience property to indicate if the expiration date is in the past.
+     *
+     * Evaluated on every access, since unchanged licenses are handed out as
+     * the same instance across refreshes.
      */
-    val isExpired: Boolean =
-        expirationDate != 0L && System.currentTimeMillis() >= expirationDate
+    @OptIn(ExperimentalTime::class)
+    val isExpired: Boolean
+        get() = expirationDate != 0L && Clock.System.now().toEpochMilliseconds() >= expirationDate
 
     /**
      * Convenience property to indicate an installation from MS Store.
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * Cached result of the background package update check.
+ *
+ * @see https://learn.microsoft.com/uwp/api/windows.services.store.storecontext.getappandoptionalstorepackageupdatesasync
+ */
+public data class MsStorePendingUpdates(
+
+    /**
+     * Number of completed checks since the checker was first started.
+     *
+     * This is 0 until the first check completed. It changes on every completed
+     * check, so it can be used to detect fresh results.
+     */
+    val generation: Long = 0,
+
+    /**
+     * Time of the last completed check as timestamp in milliseconds.
+     */
+    val checkedAt: Long = 0,
+
+    /**
+     * Number of packages of this app (including optional packages) with an update available.
+     */
+    val updateCount: Int = 0,
+
+    /**
+     * Number of available updates that are marked as mandatory in Partner Center.
+     */
+    val mandatoryUpdateCount: Int = 0,
+
+    /**
+     * Value that indicates whether the last check failed.
+     * The update counts are kept from the last successful check in that case.
+     */
+    val lastCheckFailed: Boolean = false
+
+) {
+
+    /**
+     * Convenience property to indicate that at least one update is available.
+     */
+    val hasUpdates: Boolean =
+        updateCount > 0
+}
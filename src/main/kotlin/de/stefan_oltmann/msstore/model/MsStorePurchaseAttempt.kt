@@ -0,0 +1,72 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * One purchase attempt read from the purchase log.
+ */
+public data class MsStorePurchaseAttempt(
+
+    /**
+     * Increasing number of this record. Pass the last one seen to
+     * [de.stefan_oltmann.msstore.MsStore.purchaseAttempts] to only get newer records.
+     */
+    val sequence: Long = 0,
+
+    /**
+     * Store ID of the product the purchase was requested for.
+     */
+    val storeId: String = "",
+
+    /**
+     * Timestamp in milliseconds right before the Store purchase UI was requested.
+     */
+    val dialogOpenedAt: Long = 0,
+
+    /**
+     * Timestamp in milliseconds after the Store purchase UI returned.
+     *
+     * Same as [dialogOpenedAt] if no UI was shown.
+     */
+    val dialogClosedAt: Long = 0,
+
+    /**
+     * Outcome of the attempt, null if the attempt failed with an error.
+     */
+    val status: MsStorePurchaseStatus? = null,
+
+    /**
+     * Extended error of the purchase result or the error of a failed attempt, 0 if none.
+     */
+    val hresult: Int = 0,
+
+    /**
+     * Number of attempts for the same product since its last successful one.
+     */
+    val retryCount: Int = 0,
+
+    /**
+     * Value that indicates whether the attempt was answered from a fresh
+     * license snapshot without showing the Store purchase UI.
+     */
+    val shortCircuited: Boolean = false,
+
+    /**
+     * Value that indicates whether the purchase was requested on behalf of a specific user.
+     */
+    val forUser: Boolean = false
+)
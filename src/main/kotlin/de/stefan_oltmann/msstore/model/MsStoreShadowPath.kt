@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * Alternative license path that shadow mode compares with [de.stefan_oltmann.msstore.MsStore.getLicenseInfo].
+ */
+public enum class MsStoreShadowPath {
+
+    /**
+     * The native snapshot read by `getLicenseInfo(maxAgeMillis)`, without a Store query.
+     *
+     * Compared with the license marshalled straight from the Store, without
+     * snapshots. Needs a DLL with `msstore_winrt_get_license_direct`.
+     */
+    CachedSnapshot,
+
+    /**
+     * The snapshot of the license broker this process is connected to.
+     *
+     * Compared with this process' own snapshot.
+     */
+    Broker
+}
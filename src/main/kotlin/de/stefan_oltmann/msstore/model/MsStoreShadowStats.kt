@@ -0,0 +1,86 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * Counters of shadow mode, see [de.stefan_oltmann.msstore.MsStore.setShadowMode].
+ *
+ * Latencies are only summed over samples where both paths succeeded, so
+ * they compare like with like.
+ */
+public data class MsStoreShadowStats(
+
+    /**
+     * Number of samples run since shadow mode was enabled.
+     */
+    val samples: Long = 0,
+
+    /**
+     * Number of samples dropped because the previous one was still running.
+     */
+    val skipped: Long = 0,
+
+    /**
+     * Number of samples where both paths returned equal licenses.
+     */
+    val matches: Long = 0,
+
+    /**
+     * Number of samples where both paths succeeded but returned different licenses.
+     */
+    val mismatches: Long = 0,
+
+    /**
+     * Number of samples where the legacy path failed.
+     */
+    val legacyFailures: Long = 0,
+
+    /**
+     * Number of samples where the legacy path succeeded and the alternative path failed.
+     */
+    val alternativeFailures: Long = 0,
+
+    /**
+     * Mismatch count per field name of [MsStoreLicenseInfo], e.g. "isActive" or "addOnLicenses".
+     */
+    val mismatchedFields: Map<String, Long> = emptyMap(),
+
+    /**
+     * Total time of the legacy path in microseconds.
+     */
+    val legacyMicros: Long = 0,
+
+    /**
+     * Total time of the alternative path in microseconds.
+     */
+    val alternativeMicros: Long = 0,
+
+    /**
+     * Largest amount by which the alternative path was slower than the legacy
+     * path in one sample, in microseconds; negative if it was always faster.
+     */
+    val maxDeltaMicros: Long = 0
+
+) {
+
+    /**
+     * Mean time the alternative path took longer than the legacy path, in
+     * microseconds. Negative if it is faster.
+     */
+    val meanDeltaMicros: Long =
+        if (matches + mismatches == 0L) 0 else (alternativeMicros - legacyMicros) / (matches + mismatches)
+}
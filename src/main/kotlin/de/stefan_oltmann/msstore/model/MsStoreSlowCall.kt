@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * Phase breakdown of one license call that exceeded the slow-call threshold.
+ *
+ * All durations are in microseconds. The phases don't add up to [totalMicros]
+ * exactly; the rest is time spent in between, for example in the FFM call.
+ */
+public data class MsStoreSlowCall(
+
+    /**
+     * Increasing number of this record. Pass the last one seen to
+     * [de.stefan_oltmann.msstore.MsStore.slowCalls] to only get newer records.
+     */
+    val sequence: Long = 0,
+
+    /**
+     * The license operation that was slow.
+     */
+    val operation: MsStoreCallOperation = MsStoreCallOperation.Unknown,
+
+    /**
+     * Start of the call as timestamp in milliseconds.
+     */
+    val startedAt: Long = 0,
+
+    /**
+     * Duration of the whole call, including [jvmDecodeMicros].
+     */
+    val totalMicros: Long = 0,
+
+    /**
+     * Time the Store query waited in the native dispatcher queue before it started.
+     */
+    val queueWaitMicros: Long = 0,
+
+    /**
+     * Time spent initializing the COM apartment of the calling thread.
+     */
+    val apartmentMicros: Long = 0,
+
+    /**
+     * Time the Store needed to answer the license query.
+     */
+    val storeMicros: Long = 0,
+
+    /**
+     * Time spent building the native result structs.
+     */
+    val marshalMicros: Long = 0,
+
+    /**
+     * Time spent decoding the native result in the JVM.
+     *
+     * Only set for calls that were fast natively and only became slow
+     * through decoding; 0 otherwise.
+     */
+    val jvmDecodeMicros: Long = 0,
+
+    /**
+     * Number of add-on licenses in the result.
+     */
+    val addOnCount: Int = 0,
+
+    /**
+     * Value that indicates whether the call joined a Store query that was
+     * already running, so [queueWaitMicros] and [storeMicros] started earlier.
+     */
+    val joined: Boolean = false,
+
+    /**
+     * Error message of a failed call, null if the call succeeded.
+     */
+    val error: String? = null
+)
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * Progress of a package update download and installation.
+ *
+ * @see https://learn.microsoft.com/uwp/api/windows.services.store.storepackageupdatestatus
+ */
+public data class MsStoreUpdateProgress(
+
+    /**
+     * Package family name of the package this progress belongs to.
+     * This value is empty for the final progress entry.
+     */
+    val packageFamilyName: String = "",
+
+    /**
+     * Number of bytes of this package that have been downloaded.
+     */
+    val packageBytesDownloaded: Long = 0,
+
+    /**
+     * Download size of this package in bytes.
+     */
+    val packageDownloadSizeInBytes: Long = 0,
+
+    /**
+     * Download progress of this package from 0.0 to 1.0.
+     */
+    val packageDownloadProgress: Double = 0.0,
+
+    /**
+     * Download progress of all packages in this installation from 0.0 to 1.0.
+     */
+    val totalDownloadProgress: Double = 0.0,
+
+    /**
+     * State of this package, or the overall state for the final entry.
+     */
+    val state: MsStoreUpdateState = MsStoreUpdateState.Pending,
+
+    /**
+     * Value that indicates whether this is the last entry of the installation.
+     */
+    val isFinal: Boolean = false
+)
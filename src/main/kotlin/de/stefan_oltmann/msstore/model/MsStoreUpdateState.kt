@@ -0,0 +1,49 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore.model
+
+/**
+ * State of a package update download and installation.
+ *
+ * Names are aligned with Windows.Services.Store.StorePackageUpdateState for clarity.
+ */
+public enum class MsStoreUpdateState {
+
+    Pending,
+    Downloading,
+    Deploying,
+    Completed,
+    Canceled,
+    OtherError,
+    ErrorLowBattery,
+    ErrorWiFiRecommended,
+    ErrorWiFiRequired;
+
+    internal companion object {
+        fun fromNativeCode(code: Int): MsStoreUpdateState = when (code) {
+            0 -> Pending
+            1 -> Downloading
+            2 -> Deploying
+            3 -> Completed
+            4 -> Canceled
+            6 -> ErrorLowBattery
+            7 -> ErrorWiFiRecommended
+            8 -> ErrorWiFiRequired
+            else -> OtherError
+        }
+    }
+}
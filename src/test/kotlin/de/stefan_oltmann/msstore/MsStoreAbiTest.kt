@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class MsStoreAbiTest {
+
+    @Test
+    fun matchesHashesOfNativeHeader() {
+
+        /* Printed from ABI_INFO of msstore_abi.cpp. */
+        assertEquals(0x910678a41bb12c34UL.toLong(), MsStoreAbi.EXPECTED_LAYOUT_HASH)
+        assertEquals(0xf7c6b2b836db2285UL.toLong(), MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES[MsStoreAbi.STRUCT_ADD_ON_LICENSE])
+        assertEquals(0x63de0a6240cf64f5UL.toLong(), MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES[MsStoreAbi.STRUCT_ADD_ON_LICENSE_V2])
+        assertEquals(0xaeb3564d900f6c3cUL.toLong(), MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES[MsStoreAbi.STRUCT_LICENSE_V2])
+        assertEquals(0xf4015a4ca5c5939aUL.toLong(), MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES[MsStoreAbi.STRUCT_SLOW_CALL])
+        assertEquals(0x0ef57205a4aede5eUL.toLong(), MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES[MsStoreAbi.STRUCT_PURCHASE_ATTEMPT])
+    }
+
+    @Test
+    fun readsLicenseFromDllWithoutNewerStructs() {
+
+        val abi = MsStoreAbi(
+            abiVersion = 2,
+            layoutHash = MsStoreAbi.EXPECTED_LAYOUT_HASH,
+            capabilities = 0,
+            structLayoutHashes = MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES.copyOf(MsStoreAbi.STRUCT_SLOW_CALL)
+        )
+
+        assertTrue(abi.isLayoutCompatible)
+        assertTrue(abi.isStructCompatible(MsStoreAbi.STRUCT_UPDATE_PROGRESS))
+        assertFalse(abi.isStructCompatible(MsStoreAbi.STRUCT_SLOW_CALL))
+
+        assertFailsWith<MsStoreLicenseException> {
+            abi.requireStructLayout(MsStoreAbi.STRUCT_PURCHASE_ATTEMPT)
+        }
+    }
+
+    @Test
+    fun rejectsChangedStructOnly() {
+
+        val structLayoutHashes = MsStoreAbi.EXPECTED_STRUCT_LAYOUT_HASHES.copyOf()
+
+        structLayoutHashes[MsStoreAbi.STRUCT_PENDING_UPDATES] = 42
+
+        val abi = MsStoreAbi(
+            abiVersion = 2,
+            layoutHash = MsStoreAbi.EXPECTED_LAYOUT_HASH,
+            capabilities = 0,
+            structLayoutHashes = structLayoutHashes
+        )
+
+        assertFalse(abi.isStructCompatible(MsStoreAbi.STRUCT_PENDING_UPDATES))
+        assertTrue(abi.isStructCompatible(MsStoreAbi.STRUCT_LICENSE_CHANGES))
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreAddOnLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class MsStoreFeatureGatesTest {
+
+    private val gates = MsStore.compileFeatureGates(
+        listOf(
+            "LICENSED",
+            "licensed OR (trial AND addon(9NBLGGH4R315)) OR ADDON(9NBLGGH4R316)",
+            "NOT TRIAL AND NOT LICENSED"
+        )
+    )
+
+    @Test
+    fun evaluatesRules() {
+
+        val trialWithAddOn = MsStoreLicenseInfo(
+            isActive = true,
+            isTrial = true,
+            addOnLicenses = listOf(MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R315")),
+            fingerprint = 1,
+            generation = 1
+        )
+
+        gates.update(trialWithAddOn, nowMillis = 1000)
+
+        assertFalse(gates.isEnabled(0))
+        assertTrue(gates.isEnabled(1))
+        assertFalse(gates.isEnabled(2))
+        assertEquals(0b010L, gates.bitmask()[0])
+    }
+
+    @Test
+    fun reevaluatesOnlyOnGenerationChangeOrExpiry() {
+
+        /* isEnabled() checks expiry against the clock, so expire in the future. */
+        val now = System.currentTimeMillis()
+        val expiration = now + 60_000
+
+        val expiringAddOn = MsStoreLicenseInfo(
+            addOnLicenses = listOf(MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R316", expirationDate = expiration)),
+            fingerprint = 1,
+            generation = 1
+        )
+
+        assertTrue(gates.update(expiringAddOn, nowMillis = now))
+        assertTrue(gates.isEnabled(1))
+
+        assertFalse(gates.update(expiringAddOn, nowMillis = now + 30_000))
+
+        /* The add-on expired. */
+        assertTrue(gates.update(expiringAddOn, nowMillis = expiration))
+        assertFalse(gates.isEnabled(1))
+
+        val nextGeneration = MsStoreLicenseInfo(
+            addOnLicenses = expiringAddOn.addOnLicenses,
+            fingerprint = 1,
+            generation = 2
+        )
+
+        assertTrue(gates.update(nextGeneration, nowMillis = expiration))
+    }
+
+    @Test
+    fun rejectsSyntaxErrors() {
+
+        assertFailsWith<MsStoreLicenseException> { MsStore.compileFeatureGates(listOf("LICENSED AND")) }
+        assertFailsWith<MsStoreLicenseException> { MsStore.compileFeatureGates(listOf("ADDON(123)")) }
+        assertFailsWith<MsStoreLicenseException> { MsStore.compileFeatureGates(listOf("(TRIAL")) }
+        assertFailsWith<MsStoreLicenseException> { MsStore.compileFeatureGates(listOf("")) }
+    }
+}
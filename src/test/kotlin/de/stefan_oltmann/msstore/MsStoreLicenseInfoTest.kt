@@ -0,0 +1,58 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreAddOnLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNotEquals
+
+class MsStoreLicenseInfoTest {
+
+    private val addOn = MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R316", inAppOfferToken = "pro", fingerprint = 7)
+
+    @Test
+    fun excludesGenerationAndFingerprintFromEquality() {
+
+        val first = MsStoreLicenseInfo(storeId = "9NBLGGH4R315", addOnLicenses = listOf(addOn), fingerprint = 42, generation = 1)
+        val second = MsStoreLicenseInfo(storeId = "9NBLGGH4R315", addOnLicenses = listOf(addOn), fingerprint = 42, generation = 5)
+
+        assertEquals(first, second)
+        assertEquals(first.hashCode(), second.hashCode())
+        assertEquals(first, MsStoreLicenseInfo(storeId = "9NBLGGH4R315", addOnLicenses = listOf(addOn)))
+
+        assertNotEquals(first, first.copy(isTrial = true))
+    }
+
+    @Test
+    fun keepsNativeValuesOutOfCopies() {
+
+        val license = MsStoreLicenseInfo(storeId = "9NBLGGH4R315", fingerprint = 42, generation = 3)
+
+        assertEquals(42L, license.fingerprint)
+        assertEquals(3L, license.generation)
+
+        val copy = license.copy(isActive = true)
+
+        assertEquals(0L, copy.fingerprint)
+        assertEquals(0L, copy.generation)
+
+        assertEquals(7L, addOn.fingerprint)
+        assertEquals(0L, addOn.copy().fingerprint)
+    }
+}
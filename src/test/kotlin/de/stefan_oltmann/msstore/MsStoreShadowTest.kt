@@ -0,0 +1,89 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreAddOnLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreLicenseInfo
+import de.stefan_oltmann.msstore.model.MsStoreShadowStats
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class MsStoreShadowTest {
+
+    private val license = MsStoreLicenseInfo(
+        storeId = "9NBLGGH4R315",
+        skuId = "0010",
+        isActive = true,
+        addOnLicenses = listOf(MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R316", fingerprint = 7)),
+        fingerprint = 42,
+        generation = 3
+    )
+
+    @Test
+    fun comparesFieldByField() {
+
+        assertEquals(emptyList<String>(), MsStoreShadow.mismatchedFields(license, license.copy()))
+
+        val differing = license.copy(
+            isTrial = true,
+            addOnLicenses = listOf(MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R316", expirationDate = 1000))
+        )
+
+        assertEquals(listOf("isTrial", "addOnLicenses"), MsStoreShadow.mismatchedFields(license, differing))
+    }
+
+    @Test
+    fun ignoresAddOnOrderAndGeneration() {
+
+        val addOns = listOf(
+            MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R316"),
+            MsStoreAddOnLicenseInfo(storeId = "9NBLGGH4R317")
+        )
+
+        val owner = MsStoreLicenseInfo(storeId = "9NBLGGH4R315", addOnLicenses = addOns, fingerprint = 42, generation = 3)
+        val client = MsStoreLicenseInfo(storeId = "9NBLGGH4R315", addOnLicenses = addOns.reversed(), fingerprint = 42, generation = 9)
+
+        assertEquals(emptyList<String>(), MsStoreShadow.mismatchedFields(owner, client))
+    }
+
+    @Test
+    fun comparesFingerprintsOnlyIfBothPathsHaveOne() {
+
+        val direct = license.copy()
+        val otherFingerprint = MsStoreLicenseInfo(
+            storeId = license.storeId,
+            skuId = license.skuId,
+            isActive = license.isActive,
+            addOnLicenses = license.addOnLicenses,
+            fingerprint = 43,
+            generation = 3
+        )
+
+        assertEquals(0L, direct.fingerprint)
+        assertEquals(emptyList<String>(), MsStoreShadow.mismatchedFields(direct, license))
+        assertEquals(listOf("fingerprint"), MsStoreShadow.mismatchedFields(license, otherFingerprint))
+    }
+
+    @Test
+    fun averagesDeltaOverComparedSamples() {
+
+        val stats = MsStoreShadowStats(matches = 3, mismatches = 1, legacyMicros = 4000, alternativeMicros = 400)
+
+        assertEquals(-900L, stats.meanDeltaMicros)
+        assertEquals(0L, MsStoreShadowStats().meanDeltaMicros)
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026 Stefan Oltmann
+ * https://github.com/StefanOltmann/msstorelib
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.stefan_oltmann.msstore
+
+import de.stefan_oltmann.msstore.model.MsStoreUpdateState
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class MsStoreUpdateStateTest {
+
+    @Test
+    fun mapsNativeStateCodes() {
+        assertEquals(MsStoreUpdateState.Pending, MsStoreUpdateState.fromNativeCode(0))
+        assertEquals(MsStoreUpdateState.Downloading, MsStoreUpdateState.fromNativeCode(1))
+        assertEquals(MsStoreUpdateState.Deploying, MsStoreUpdateState.fromNativeCode(2))
+        assertEquals(MsStoreUpdateState.Completed, MsStoreUpdateState.fromNativeCode(3))
+        assertEquals(MsStoreUpdateState.Canceled, MsStoreUpdateState.fromNativeCode(4))
+        assertEquals(MsStoreUpdateState.OtherError, MsStoreUpdateState.fromNativeCode(5))
+        assertEquals(MsStoreUpdateState.ErrorLowBattery, MsStoreUpdateState.fromNativeCode(6))
+        assertEquals(MsStoreUpdateState.ErrorWiFiRecommended, MsStoreUpdateState.fromNativeCode(7))
+        assertEquals(MsStoreUpdateState.ErrorWiFiRequired, MsStoreUpdateState.fromNativeCode(8))
+        assertEquals(MsStoreUpdateState.OtherError, MsStoreUpdateState.fromNativeCode(42))
+    }
+}